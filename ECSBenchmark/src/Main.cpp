@@ -0,0 +1,43 @@
+#include "CommonHeaders.h"
+#include "Utilities/Logger.h"
+#include "Utilities/JobSystem.h"
+#include "ECS/ECSCore.h"
+#include "ECS/ECSBenchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#pragma comment(lib, "mofuengine.lib")
+
+/*
+* headless runner of the ECS micro-benchmarks, nothing else of the engine is initialized
+* usage: ECSBenchmark [output path] [entity count] [runs]
+*/
+
+using namespace mofu;
+
+int
+main(int argc, char** argv)
+{
+	const char* outputPath{ argc > 1 ? argv[1] : "ecs_benchmark.json" };
+	ecs::benchmark::BenchmarkSettings settings{};
+	if (argc > 2) settings.EntityCount = (u32)std::strtoul(argv[2], nullptr, 10);
+	if (argc > 3) settings.Runs = (u32)std::strtoul(argv[3], nullptr, 10);
+	if (settings.EntityCount == 0 || settings.Runs == 0)
+	{
+		printf("usage: ECSBenchmark [output path] [entity count] [runs]\n");
+		return 1;
+	}
+
+	log::Initialize();
+	jobs::Initialize();
+	ecs::Initialize();
+
+	printf("running the ECS benchmarks: %u entities, %u runs, %u threads\n", settings.EntityCount, settings.Runs, jobs::GetThreadCount());
+	const bool written{ ecs::benchmark::RunBenchmarks(outputPath, settings) };
+	if (written) printf("results written to %s\n", outputPath);
+	else printf("failed to write the results to %s\n", outputPath);
+
+	ecs::Shutdown();
+	jobs::Shutdown();
+	log::Shutdown();
+	return written ? 0 : 1;
+}
@@ -11,6 +11,8 @@ using namespace mofu;
 
 struct TestSystem : ecs::system::System<TestSystem>
 {
+	using Access = ecs::system::SystemAccess<>;
+
 	void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 	{
 		//log::Info("TestSystem::Update");
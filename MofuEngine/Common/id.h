@@ -48,8 +48,9 @@ Generation(id_t forId)
 constexpr inline void
 AdvanceGeneration(id_t& forId)
 {
-	assert(false);
-	forId += (id_t{ 1 } << detail::INDEX_BITS);
+	// wraps around before reaching GENERATION_MASK, an id with all generation bits set could be INVALID_ID
+	const id_t generation{ Generation(forId) + 1 };
+	forId = Index(forId) | ((generation > MAX_GENERATION ? 0 : generation) << detail::INDEX_BITS);
 }
 
 #ifdef _DEBUG
@@ -147,6 +147,7 @@ constexpr bool IsAllowedTextureExtension(std::string_view e)
 
 constexpr const char* PREFAB_FILE_EXTENSION{ ".pre" };
 constexpr const char* SCENE_FILE_EXTENSION{ ".sc" };
+constexpr const char* SCENE_SNAPSHOT_FILE_EXTENSION{ ".scb" };
 
 [[nodiscard]] inline AssetType::type 
 GetAssetTypeFromExtension(std::string_view extension)
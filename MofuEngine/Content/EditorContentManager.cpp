@@ -599,7 +599,7 @@ LoadMeshAsset(AssetHandle asset, ecs::Entity entity, ecs::component::RenderMesh&
 	{
 		material.MaterialCount = 1;
 		material.MaterialID = content::GetDefaultMaterial();
-		material.MaterialAsset = DEFAULT_MATERIAL_UNTEXTURED_HANDLE;
+		ecs::metadata::GetAssets(entity).Material = DEFAULT_MATERIAL_UNTEXTURED_HANDLE;
 	}
 	// root
 	mesh.MeshID = uploadedGeometryInfo.GeometryContentID;
@@ -38,6 +38,29 @@ GetGeometryHierarchyBufferSize(const void* const blob)
 	return totalSize;
 }
 
+// the positions follow the 5 u32 of the submesh header, see AddSubmesh
+OBB
+GetSubmeshBounds(const u8* const submesh)
+{
+	util::BlobStreamReader reader{ submesh };
+	reader.Skip(sizeof(u32)); // element size
+	const u32 vertexCount{ reader.Read<u32>() };
+	reader.Skip(sizeof(u32) * 3); // index count, element type, primitive topology
+	if (vertexCount == 0) return {};
+
+	const v3* const positions{ (const v3*)reader.Position() };
+	v3 min{ positions[0] };
+	v3 max{ positions[0] };
+	for (u32 i{ 1 }; i < vertexCount; ++i)
+	{
+		const v3& p{ positions[i] };
+		min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+		max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+	}
+	return { { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f },
+		{ (max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f } };
+}
+
 Vec<UploadedGeometryInfo>
 CreateGeometryItem(const void* const blob)
 {
@@ -62,10 +85,12 @@ CreateGeometryItem(const void* const blob)
 		
 		u32 submeshIndex{ 0 };
 		id_t* const submeshGpuIDs = new id_t[submeshCount];
+		Vec<OBB> submeshBounds(submeshCount);
 
 		for (u32 idIdx{ 0 }; idIdx < submeshCount; ++idIdx)
 		{
 			const u8* at{ reader.Position() };
+			submeshBounds[idIdx] = GetSubmeshBounds(at);
 			// upload the submesh to the GPU
 			u32 id{ graphics::AddSubmesh(at) };
 			submeshGpuIDs[submeshIndex++] = id;
@@ -86,6 +111,7 @@ CreateGeometryItem(const void* const blob)
 		lastUploadedGeometryInfo.SubmeshCount = submeshCount;
 		lastUploadedGeometryInfo.SubmeshGpuIDs.resize(submeshCount);
 		std::copy(submeshGpuIDs, submeshGpuIDs + submeshCount, lastUploadedGeometryInfo.SubmeshGpuIDs.begin());
+		lastUploadedGeometryInfo.SubmeshBounds = std::move(submeshBounds);
 
 		info.emplace_back(lastUploadedGeometryInfo);
 	}
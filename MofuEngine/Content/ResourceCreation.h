@@ -17,6 +17,7 @@ struct UploadedGeometryInfo
 	id_t GeometryContentID{ id::INVALID_ID };
 	u32 SubmeshCount{ 0 };
 	Vec<id_t> SubmeshGpuIDs;
+	Vec<OBB> SubmeshBounds; // the local bounds of the vertex positions, by submesh
 };
 
 struct TextureFlags
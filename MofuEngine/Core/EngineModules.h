@@ -1,12 +1,14 @@
 #pragma once
 #include "CommonHeaders.h"
 #include "Utilities/Logger.h"
+#include "Utilities/JobSystem.h"
 #include "ECS/ECSCore.h"
 
 namespace mofu {
 bool InitializeEngineModules()
 {
 	mofu::log::Initialize();
+	mofu::jobs::Initialize();
 	mofu::ecs::Initialize();
 	return true;
 }
@@ -14,6 +16,7 @@ bool InitializeEngineModules()
 void ShutdownEngineModules()
 {
 	mofu::ecs::Shutdown();
+	mofu::jobs::Shutdown();
 	mofu::log::Shutdown();
 }
 }
\ No newline at end of file
@@ -8,7 +8,38 @@
 
 
 namespace mofu::ecs::component {
-struct Component {};
+enum class ComponentStorage : u8
+{
+    Table, // a column in the entity's block
+    Sparse, // a sparse set keyed by entity index, adding/removing doesn't move the entity to another block
+};
+
+struct Component
+{
+    static constexpr ComponentStorage Storage{ ComponentStorage::Table };
+};
+
+// for data-less tags that come and go often (visibility, render pass markers...)
+struct SparseComponent : Component
+{
+    static constexpr ComponentStorage Storage{ ComponentStorage::Sparse };
+};
+
+// one field array of a column
+struct ColumnField
+{
+    u32 Offset; // of the field in the component
+    u32 Size;
+};
+
+/*
+* a table component stored field by field specializes this, each field gets its own array in the block column
+* so a system that only needs a few hot fields reads them as plain arrays
+* the specialization lists the Fields in order (packed, covering the whole component) and provides the proxies
+* Columns<Writable> (the field arrays, GetColumns) and its operator[] row reference, which queries and GetComponent return instead of C* and C&
+*/
+template<typename C>
+struct FieldSplit : std::false_type {};
 }
 
 namespace mofu::ecs {
@@ -1,6 +1,7 @@
 #pragma once
 #include <array>
 #include <tuple>
+#include <span>
 #include "ECSCommon.h"
 #include "Component.h"
 #include "Transform.h"
@@ -84,6 +85,84 @@ inline constexpr u32 GetComponentSize() { static_assert(ID < ComponentTypeCount)
 
 inline constexpr u32 GetComponentSize(ComponentID id) { assert(id < ComponentTypeCount); return ComponentSizes[id]; }
 
+///////////////////////////////// STORAGE ///////////////////////////////////////////////////////////////
+
+template<IsComponent C>
+inline constexpr bool IsSparse{ C::Storage == ComponentStorage::Sparse };
+
+template<std::size_t... Is>
+constexpr auto MakeStorageLUT(std::index_sequence<Is...>)
+{
+    return std::array<ComponentStorage, sizeof...(Is)>{ ComponentTypeByID<Is>::Storage... };
+}
+
+constexpr auto ComponentStorages{ MakeStorageLUT(std::make_index_sequence<ComponentTypeCount>{}) };
+
+inline constexpr bool IsSparseComponent(ComponentID id) { assert(id < ComponentTypeCount); return ComponentStorages[id] == ComponentStorage::Sparse; }
+
+// every component stored in a sparse set, these bits never show up in a block signature
+inline const CetMask& GetSparseMask()
+{
+    static const CetMask mask = [] {
+        CetMask m;
+        for (ComponentID cid{ 0 }; cid < ComponentTypeCount; ++cid)
+        {
+            if (IsSparseComponent(cid)) m.set(cid);
+        }
+        return m;
+        }();
+    return mask;
+}
+
+///////////////////////////////// COLUMN FIELDS ///////////////////////////////////////////////////////////////
+
+template<typename C>
+inline constexpr bool IsFieldSplit{ FieldSplit<C>::value };
+
+template<typename C>
+inline constexpr ColumnField WHOLE_COMPONENT_FIELD[]{ { 0, sizeof(C) } };
+
+template<typename C>
+constexpr std::span<const ColumnField> GetFieldsOf()
+{
+    if constexpr (IsFieldSplit<C>) return FieldSplit<C>::Fields;
+    else return WHOLE_COMPONENT_FIELD<C>;
+}
+
+template<std::size_t... Is>
+constexpr auto MakeFieldsLUT(std::index_sequence<Is...>)
+{
+    return std::array<std::span<const ColumnField>, sizeof...(Is)>{ GetFieldsOf<ComponentTypeByID<Is>>()... };
+}
+
+constexpr auto ComponentFields{ MakeFieldsLUT(std::make_index_sequence<ComponentTypeCount>{}) };
+
+// the field arrays of a column, a component that isn't split is a single field
+inline std::span<const ColumnField> GetColumnFields(ComponentID id) { assert(id < ComponentTypeCount); return ComponentFields[id]; }
+
+// a component field that holds an entity id, these get remapped when entities come back with new ids (snapshot loads, world merges)
+struct EntityReferenceField
+{
+    ComponentID Component;
+    u32 Offset;
+};
+
+inline constexpr EntityReferenceField ENTITY_REFERENCE_FIELDS[]{
+    { ID<Child>, offsetof(Child, ParentEntity) },
+    { ID<DirectionalLight>, offsetof(DirectionalLight, Owner) },
+    { ID<PointLight>, offsetof(PointLight, Owner) },
+    { ID<SpotLight>, offsetof(SpotLight, Owner) },
+};
+
+// the reference fixups address a field as component offset + row * size, so it can't be in a split component
+static_assert([] {
+    for (const EntityReferenceField& field : ENTITY_REFERENCE_FIELDS)
+    {
+        if (ComponentFields[field.Component].size() != 1) return false;
+    }
+    return true;
+    }());
+
 template<ComponentID ID>
 void RenderOneComponent(void* raw)
 {
@@ -162,14 +241,31 @@ inline constexpr auto AddLUT = MakeAddLUT(std::make_index_sequence<ComponentType
 //template<typename T>
 //constexpr bool IsYamlSerializable_v = detail::IsYamlSerializable<T>::value;
 
-using SerializeFunc = void(*)(YAML::Emitter&, const u8* const);
+// components that save editor data of their entity rather than their own fields
+template<typename T>
+concept IsEntitySerializable = requires(YAML::Emitter& out, Entity entity, const T& t)
+{
+    SerializeEntityComponent(out, entity, t);
+};
+
+template<typename T>
+concept IsEntityDeserializable = requires(const YAML::Node& node, Entity entity, T& t)
+{
+    DeserializeEntityComponent(node, entity, t);
+};
+
+using SerializeFunc = void(*)(YAML::Emitter&, Entity, const u8* const);
 
 template<ComponentID ID>
-void SerializeComponent(YAML::Emitter& out, const u8* const componentData) 
+void SerializeComponent(YAML::Emitter& out, [[maybe_unused]] Entity entity, const u8* const componentData) 
 {
     using T = ComponentTypeByID<ID>;
 
-    if constexpr (IsYamlSerializable<T>) 
+    if constexpr (IsEntitySerializable<T>)
+    {
+        SerializeEntityComponent(out, entity, *reinterpret_cast<const T*>(componentData));
+    }
+    else if constexpr (IsYamlSerializable<T>) 
     {
         out << *reinterpret_cast<const T*>(componentData);
     }
@@ -188,14 +284,19 @@ constexpr auto MakeSerializeLUT(std::index_sequence<Is...>)
 inline constexpr auto SerializeLUT = MakeSerializeLUT(std::make_index_sequence<ComponentTypeCount>{});
 
 
-using DeserializeFunc = void(*)(const YAML::Node&, u8*);
+using DeserializeFunc = void(*)(const YAML::Node&, Entity, u8*);
 
 template<ComponentID ID>
-void DeserializeComponent(const YAML::Node& node, u8* data) 
+void DeserializeComponent(const YAML::Node& node, [[maybe_unused]] Entity entity, u8* data) 
 {
     using T = ComponentTypeByID<ID>;
 
-    if constexpr (IsYamlDeserializable<T>)
+    if constexpr (IsEntityDeserializable<T>)
+    {
+        new (reinterpret_cast<T*>(data)) T{};
+        DeserializeEntityComponent(node, entity, *reinterpret_cast<T*>(data));
+    }
+    else if constexpr (IsYamlDeserializable<T>)
     {
         //*reinterpret_cast<T*>(data) = node.as<T>();
         node >> *reinterpret_cast<T*>(data);
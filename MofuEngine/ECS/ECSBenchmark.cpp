@@ -0,0 +1,581 @@
+#include "ECSBenchmark.h"
+#include "EngineAPI/ECS/SceneAPI.h"
+#include "TransformHierarchy.h"
+#include "FrustumCulling.h"
+#include "Utilities/JobSystem.h"
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace mofu::ecs::benchmark {
+namespace {
+using namespace component;
+using Clock = std::chrono::steady_clock;
+
+// the components of the query iteration benchmark, the first N are queried
+using QueryComponents = std::tuple<LocalTransform, WorldTransform, NameComponent, CullableObject, Camera, PointLight, SpotLight, DirectionalLight>;
+constexpr u32 QUERY_LOOKUPS_PER_RUN{ 100'000 };
+constexpr u32 HIERARCHY_DEPTHS[]{ 1, 4, 16 };
+constexpr u32 JOB_COUNT{ 10'000 };
+// jobs started by every job of the nested cases
+constexpr u32 NESTED_JOB_FANOUT{ 64 };
+constexpr u32 SCALING_HIERARCHY_DEPTH{ 4 };
+constexpr u32 MAX_SCALING_THREADS{ 16 };
+// the culled boxes are scattered in a cube of this half size around the camera
+constexpr f32 CULL_SCENE_HALF_SIZE{ 100.f };
+
+struct BenchmarkResult
+{
+	char Name[48];
+	u32 OpCount;
+	f32 MinMs;
+	f32 AvgMs;
+};
+
+// how many times faster a benchmark ran than its baseline, from the min times
+struct BenchmarkSpeedup
+{
+	char Name[48];
+	char Baseline[48];
+	f32 Ratio;
+};
+
+Vec<BenchmarkResult> _results{};
+Vec<BenchmarkSpeedup> _speedups{};
+// keeps the compiler from dropping the loops that only read
+volatile u64 _sink{ 0 };
+
+f32
+ElapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<f32, std::milli>(Clock::now() - start).count();
+}
+
+// setup(), then op() timed, then teardown(), once per run
+template<typename Setup, typename Op, typename Teardown>
+void
+Measure(const char* name, u32 opCount, u32 runs, Setup&& setup, Op&& op, Teardown&& teardown)
+{
+	BenchmarkResult result{ {}, opCount, std::numeric_limits<f32>::max(), 0.f };
+	snprintf(result.Name, sizeof(result.Name), "%s", name);
+	for (u32 run{ 0 }; run < runs; ++run)
+	{
+		setup();
+		const Clock::time_point start{ Clock::now() };
+		op();
+		const f32 ms{ ElapsedMs(start) };
+		teardown();
+		result.MinMs = std::min(result.MinMs, ms);
+		result.AvgMs += ms / runs;
+	}
+	_results.emplace_back(result);
+}
+
+template<typename Op>
+void
+Measure(const char* name, u32 opCount, u32 runs, Op&& op)
+{
+	Measure(name, opCount, runs, [] {}, op, [] {});
+}
+
+const BenchmarkResult*
+FindResult(const char* name)
+{
+	for (const BenchmarkResult& r : _results)
+	{
+		if (strcmp(r.Name, name) == 0) return &r;
+	}
+	return nullptr;
+}
+
+// both have to be measured already
+void
+AddSpeedup(const char* name, const char* baseline)
+{
+	const BenchmarkResult* const result{ FindResult(name) };
+	const BenchmarkResult* const baselineResult{ FindResult(baseline) };
+	assert(result && baselineResult);
+	BenchmarkSpeedup speedup{ {}, {}, result->MinMs > 0.f ? baselineResult->MinMs / result->MinMs : 0.f };
+	snprintf(speedup.Name, sizeof(speedup.Name), "%s", name);
+	snprintf(speedup.Baseline, sizeof(speedup.Baseline), "%s", baseline);
+	_speedups.emplace_back(speedup);
+}
+
+void
+ClearScene()
+{
+	scene::UnloadScene();
+}
+
+void
+CollectEntities(Vec<Entity>& outEntities)
+{
+	outEntities.clear();
+	for (auto [entity, lt] : scene::GetRO<LocalTransform>()) outEntities.emplace_back(entity);
+}
+
+// every spawned entity goes into the transform hierarchy at the end of the frame, so that's part of the creation cost
+void
+SpawnTestEntities(u32 count)
+{
+	scene::SpawnEntities(count, LocalTransform{}, WorldTransform{}, NameComponent{});
+	scene::EndFrame();
+}
+
+void
+BenchmarkCreateDestroy(const BenchmarkSettings& settings)
+{
+	const u32 count{ settings.EntityCount };
+	Vec<Entity> entities{};
+	Measure("create", count, settings.Runs,
+		[] {},
+		[count] { SpawnTestEntities(count); },
+		[] { ClearScene(); });
+
+	Measure("create_single", count, settings.Runs,
+		[] {},
+		[count] {
+			for (u32 i{ 0 }; i < count; ++i) scene::SpawnEntity(LocalTransform{}, WorldTransform{}, NameComponent{});
+			scene::EndFrame();
+		},
+		[] { ClearScene(); });
+
+	Measure("destroy", count, settings.Runs,
+		[count, &entities] { SpawnTestEntities(count); CollectEntities(entities); },
+		[&entities] { for (Entity e : entities) scene::DestroyEntity(e); },
+		[] { ClearScene(); });
+}
+
+void
+BenchmarkMigrations(const BenchmarkSettings& settings)
+{
+	const u32 count{ settings.EntityCount };
+	Vec<Entity> entities{};
+	SpawnTestEntities(count);
+	CollectEntities(entities);
+
+	Measure("add_component", count, settings.Runs,
+		[] {},
+		[&entities] { for (Entity e : entities) scene::AddComponent<CullableObject>(e); },
+		[&entities] { for (Entity e : entities) scene::RemoveComponent<CullableObject>(e); });
+	Measure("remove_component", count, settings.Runs,
+		[&entities] { for (Entity e : entities) scene::AddComponent<CullableObject>(e); },
+		[&entities] { for (Entity e : entities) scene::RemoveComponent<CullableObject>(e); },
+		[] {});
+	// sparse tags don't move the entity
+	Measure("add_remove_sparse", count, settings.Runs, [&entities] {
+		for (Entity e : entities) scene::AddComponent<PotentiallyVisible>(e);
+		for (Entity e : entities) scene::RemoveComponent<PotentiallyVisible>(e);
+		});
+	ClearScene();
+}
+
+// the first byte of the row's component, a split component is read back as a whole
+template<typename C>
+u8
+ReadFirstByte(ColumnArray<C, false> column, u32 row)
+{
+	if constexpr (component::IsFieldSplit<C>)
+	{
+		const C value = column[row];
+		return *(const u8*)&value;
+	}
+	else
+	{
+		return *(const u8*)(column + row);
+	}
+}
+
+template<typename... C>
+void
+IterateQuery()
+{
+	u64 sum{ 0 };
+	scene::GetRO<C...>().ForEachChunk([&sum](u32 count, const Entity* entities, ColumnArray<C, false>... columns) {
+		for (u32 i{ 0 }; i < count; ++i) sum += (u32)entities[i] + (ReadFirstByte<C>(columns, i) + ...);
+		});
+	_sink = _sink + sum;
+}
+
+template<size_t... I>
+void
+BenchmarkQueryIteration(const BenchmarkSettings& settings, std::index_sequence<I...>)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "query_iterate_%u", (u32)sizeof...(I));
+	Measure(name, settings.EntityCount, settings.Runs, [] { IterateQuery<std::tuple_element_t<I, QueryComponents>...>(); });
+}
+
+void
+BenchmarkQueries(const BenchmarkSettings& settings)
+{
+	scene::SpawnEntities(settings.EntityCount, LocalTransform{}, WorldTransform{}, NameComponent{}, CullableObject{},
+		Camera{}, PointLight{}, SpotLight{}, DirectionalLight{});
+	// a few other archetypes the queries have to skip
+	scene::SpawnEntities(settings.EntityCount / 4, LocalTransform{}, WorldTransform{}, NameComponent{});
+	scene::SpawnEntities(settings.EntityCount / 4, LocalTransform{}, WorldTransform{}, Camera{});
+	scene::EndFrame();
+
+	BenchmarkQueryIteration(settings, std::make_index_sequence<1>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<2>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<3>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<4>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<5>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<6>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<7>{});
+	BenchmarkQueryIteration(settings, std::make_index_sequence<8>{});
+
+	// what every system pays per query per frame, the block list is cached after the first lookup
+	Measure("query_lookup", QUERY_LOOKUPS_PER_RUN, settings.Runs, [] {
+		const QueryMask& mask{ GetQueryMask<LocalTransform, WorldTransform, Without<Camera>>() };
+		u64 blockCount{ 0 };
+		for (u32 i{ 0 }; i < QUERY_LOOKUPS_PER_RUN; ++i) blockCount += scene::GetBlocksFromCet(mask).size();
+		_sink = _sink + blockCount;
+		});
+	ClearScene();
+}
+
+// the per-entity work of the iteration benchmarks: rotates and scales the local position into the world translation
+void
+WriteWorldPosition(const v3& position, const quat& rotation, const v3& scale, WorldTransform& wt)
+{
+	const v3 p{ position.x * scale.x, position.y * scale.y, position.z * scale.z };
+	// t = 2 * cross(q.xyz, p), p' = p + q.w * t + cross(q.xyz, t)
+	const v3 t{ 2.f * (rotation.y * p.z - rotation.z * p.y), 2.f * (rotation.z * p.x - rotation.x * p.z), 2.f * (rotation.x * p.y - rotation.y * p.x) };
+	wt.TRS.m[3][0] = p.x + rotation.w * t.x + (rotation.y * t.z - rotation.z * t.y);
+	wt.TRS.m[3][1] = p.y + rotation.w * t.y + (rotation.z * t.x - rotation.x * t.z);
+	wt.TRS.m[3][2] = p.z + rotation.w * t.z + (rotation.x * t.y - rotation.y * t.x);
+}
+
+// the same work done through the row iterator, ForEachChunk and the parallel variants
+void
+BenchmarkIterationStyles(const BenchmarkSettings& settings)
+{
+	const u32 count{ settings.EntityCount };
+	scene::SpawnEntities(count, LocalTransform{ {}, v3{ 1.f, 2.f, 3.f }, quat{ 0.f, 0.7071068f, 0.f, 0.7071068f } }, WorldTransform{});
+	scene::EndFrame();
+
+	Measure("iterate_for", count, settings.Runs, [] {
+		for (auto [entity, lt, wt] : scene::GetRW<LocalTransform, WorldTransform>()) WriteWorldPosition(lt.Position, lt.Rotation, lt.Scale, wt);
+		});
+	Measure("iterate_for_each_chunk", count, settings.Runs, [] {
+		scene::GetRW<LocalTransform, WorldTransform>().ForEachChunk([](u32 rowCount, const Entity*, ColumnArray<LocalTransform, true> lts, WorldTransform* wts) {
+			for (u32 i{ 0 }; i < rowCount; ++i) WriteWorldPosition(lts.Position[i], lts.Rotation[i], lts.Scale[i], wts[i]);
+			});
+		});
+	Measure("iterate_parallel_for_each", count, settings.Runs, [] {
+		scene::GetRW<LocalTransform, WorldTransform>().ParallelForEach([](Entity, auto lt, WorldTransform& wt) {
+			WriteWorldPosition(lt.Position, lt.Rotation, lt.Scale, wt);
+			});
+		});
+	Measure("iterate_parallel_for_each_chunk", count, settings.Runs, [] {
+		scene::GetRW<LocalTransform, WorldTransform>().ParallelForEachChunk([](u32 rowCount, const Entity*, ColumnArray<LocalTransform, true> lts, WorldTransform* wts) {
+			for (u32 i{ 0 }; i < rowCount; ++i) WriteWorldPosition(lts.Position[i], lts.Rotation[i], lts.Scale[i], wts[i]);
+			});
+		});
+	AddSpeedup("iterate_for_each_chunk", "iterate_for");
+	AddSpeedup("iterate_parallel_for_each", "iterate_for");
+	AddSpeedup("iterate_parallel_for_each_chunk", "iterate_for");
+	ClearScene();
+}
+
+// chains of depth entities, a root and depth - 1 children below it, returns the chain count
+u32
+SpawnChains(u32 entityCount, u32 depth, Vec<Entity>& roots)
+{
+	const u32 chainCount{ std::max(entityCount / depth, 1u) };
+	for (u32 chain{ 0 }; chain < chainCount; ++chain)
+	{
+		Entity parent{ scene::SpawnEntity(LocalTransform{}, WorldTransform{}, Parent{}).id };
+		roots.emplace_back(parent);
+		for (u32 level{ 1 }; level < depth; ++level)
+		{
+			parent = scene::SpawnEntity(LocalTransform{}, WorldTransform{}, Child{ {}, parent }).id;
+		}
+	}
+	scene::EndFrame();
+	transform::UpdateHierarchy();
+	return chainCount;
+}
+
+void
+BenchmarkHierarchy(const BenchmarkSettings& settings)
+{
+	for (u32 depth : HIERARCHY_DEPTHS)
+	{
+		Vec<Entity> roots{};
+		const u32 chainCount{ SpawnChains(settings.EntityCount, depth, roots) };
+		const auto markRoots{ [&roots] { for (Entity e : roots) transform::MarkLocalTransformChanged(e); } };
+
+		char name[48];
+		snprintf(name, sizeof(name), "hierarchy_update_depth_%u", depth);
+		Measure(name, chainCount * depth, settings.Runs,
+			[] { scene::MarkAllComponentsChanged<LocalTransform>(); },
+			[] { transform::UpdateHierarchy(); },
+			[] {});
+		// the same update one entity at a time, the baseline of the four-wide kernel
+		char scalarName[48];
+		snprintf(scalarName, sizeof(scalarName), "hierarchy_update_scalar_depth_%u", depth);
+		Measure(scalarName, chainCount * depth, settings.Runs,
+			[] { scene::MarkAllComponentsChanged<LocalTransform>(); transform::SetScalarUpdate(true); },
+			[] { transform::UpdateHierarchy(); },
+			[] { transform::SetScalarUpdate(false); });
+		AddSpeedup(name, scalarName);
+		// only the roots move and their children follow, the children never read their own blocks
+		snprintf(name, sizeof(name), "hierarchy_roots_moved_depth_%u", depth);
+		Measure(name, chainCount * depth, settings.Runs, markRoots, [] { transform::UpdateHierarchy(); }, [] {});
+		snprintf(scalarName, sizeof(scalarName), "hierarchy_roots_moved_scalar_depth_%u", depth);
+		Measure(scalarName, chainCount * depth, settings.Runs,
+			[&markRoots] { markRoots(); transform::SetScalarUpdate(true); },
+			[] { transform::UpdateHierarchy(); },
+			[] { transform::SetScalarUpdate(false); });
+		AddSpeedup(name, scalarName);
+		snprintf(name, sizeof(name), "hierarchy_idle_depth_%u", depth);
+		Measure(name, chainCount * depth, settings.Runs, [] { transform::UpdateHierarchy(); });
+		ClearScene();
+	}
+}
+
+void
+BenchmarkEnableDisable(const BenchmarkSettings& settings)
+{
+	const u32 count{ settings.EntityCount };
+	Vec<Entity> entities{};
+	SpawnTestEntities(count);
+	CollectEntities(entities);
+
+	Measure("disable", count, settings.Runs,
+		[] {},
+		[&entities] { for (Entity e : entities) scene::DisableEntity(e); },
+		[&entities] { for (Entity e : entities) scene::EnableEntity(e); });
+	Measure("enable", count, settings.Runs,
+		[&entities] { for (Entity e : entities) scene::DisableEntity(e); },
+		[&entities] { for (Entity e : entities) scene::EnableEntity(e); },
+		[] {});
+	// every other entity disabled, the query walks the enabled mask
+	for (u32 i{ 0 }; i < count; i += 2) scene::DisableEntity(entities[i]);
+	Measure("query_iterate_half_disabled", count / 2, settings.Runs, [] { IterateQuery<LocalTransform, NameComponent>(); });
+	ClearScene();
+}
+
+// some arithmetic so the jobs aren't only queue overhead
+u32
+JobWork(u32 seed)
+{
+	u32 x{ seed };
+	for (u32 i{ 0 }; i < 64; ++i) x = x * 1664525u + 1013904223u;
+	return x;
+}
+
+// job overhead and a stress test of waiting inside jobs, every case checks that all of its jobs ran
+void
+BenchmarkJobs(const BenchmarkSettings& settings)
+{
+	std::atomic<u32> doneCount{ 0 };
+	std::atomic<u64> checksum{ 0 };
+	const auto runJob = [&doneCount, &checksum](u32 seed) {
+		checksum.fetch_add(JobWork(seed), std::memory_order_relaxed);
+		doneCount.fetch_add(1, std::memory_order_relaxed);
+		};
+
+	Measure("jobs_run_wait", JOB_COUNT, settings.Runs, [&runJob] {
+		jobs::JobCounter counter{};
+		for (u32 i{ 0 }; i < JOB_COUNT; ++i) jobs::Run([&runJob, i] { runJob(i); }, &counter);
+		jobs::Wait(counter);
+		});
+
+	// every job starts its own jobs and waits for them, the waiting threads run other jobs meanwhile
+	Measure("jobs_nested_wait", NESTED_JOB_FANOUT * NESTED_JOB_FANOUT, settings.Runs, [&runJob] {
+		jobs::JobCounter outer{};
+		for (u32 i{ 0 }; i < NESTED_JOB_FANOUT; ++i)
+		{
+			jobs::Run([&runJob, i] {
+				jobs::JobCounter inner{};
+				for (u32 j{ 0 }; j < NESTED_JOB_FANOUT; ++j) jobs::Run([&runJob, i, j] { runJob(i * NESTED_JOB_FANOUT + j); }, &inner);
+				jobs::Wait(inner);
+				}, &outer);
+		}
+		jobs::Wait(outer);
+		});
+
+	Measure("jobs_nested_parallel_for", NESTED_JOB_FANOUT * NESTED_JOB_FANOUT, settings.Runs, [&runJob] {
+		jobs::ParallelFor(NESTED_JOB_FANOUT, 1, [&runJob](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i)
+			{
+				jobs::ParallelFor(NESTED_JOB_FANOUT, 4, [&runJob, i](u32 innerBegin, u32 innerEnd) {
+					for (u32 j{ innerBegin }; j < innerEnd; ++j) runJob(i * NESTED_JOB_FANOUT + j);
+					});
+			}
+			});
+		});
+
+	const u32 expectedCount{ settings.Runs * (JOB_COUNT + 2 * NESTED_JOB_FANOUT * NESTED_JOB_FANOUT) };
+	if (doneCount != expectedCount) log::Error("[ECS benchmark] %u of %u jobs ran", doneCount.load(), expectedCount);
+	assert(doneCount == expectedCount);
+	_sink = _sink + checksum;
+}
+
+// the scalar box test against the SIMD kernel of the culling system, both on one thread so only the kernels differ
+void
+BenchmarkCulling(const BenchmarkSettings& settings)
+{
+	using namespace culling;
+	const u32 count{ settings.EntityCount };
+	scene::SpawnEntities(count, LocalTransform{}, WorldTransform{}, CullableObject{});
+	scene::EndFrame();
+
+	// boxes of different sizes at random spots around the camera at the origin, about a quarter of them in view
+	// NOTE: the world transforms are written directly, the hierarchy isn't updated before the runs
+	u32 seed{ 1 };
+	const auto random{ [&seed](f32 min, f32 max) {
+		seed = JobWork(seed);
+		return min + (max - min) * (f32)(seed >> 8) / (f32)(1u << 24);
+		} };
+	scene::GetRW<WorldTransform, CullableObject>().ForEachChunk([&random](u32 rowCount, const Entity*, WorldTransform* wts, CullableObject* cullables) {
+		for (u32 i{ 0 }; i < rowCount; ++i)
+		{
+			const f32 scale{ random(0.5f, 2.f) };
+			DirectX::XMStoreFloat4x4(&wts[i].TRS, DirectX::XMMatrixAffineTransformation(
+				DirectX::XMVectorReplicate(scale), DirectX::g_XMZero,
+				DirectX::XMQuaternionRotationRollPitchYaw(random(0.f, math::TAU), random(0.f, math::TAU), 0.f),
+				DirectX::XMVectorSet(random(-CULL_SCENE_HALF_SIZE, CULL_SCENE_HALF_SIZE), random(-CULL_SCENE_HALF_SIZE, CULL_SCENE_HALF_SIZE),
+					random(-CULL_SCENE_HALF_SIZE, CULL_SCENE_HALF_SIZE), 1.f)));
+			cullables[i].obb = { { random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f) }, { random(0.1f, 2.f), random(0.1f, 2.f), random(0.1f, 2.f) } };
+		}
+		});
+
+	m4x4 viewProjection;
+	DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMMatrixPerspectiveFovLH(math::HALF_PI, 16.f / 9.f, 0.1f, CULL_SCENE_HALF_SIZE));
+	const FrustumPlanes frustum{ GetFrustumPlanes(viewProjection) };
+	const FrustumPlanesBatch planes{ GetFrustumPlanesBatch(frustum) };
+
+	u32 scalarVisible{ 0 };
+	Measure("cull_scalar", count, settings.Runs, [&frustum, &scalarVisible] {
+		u32 visible{ 0 };
+		scene::GetRO<WorldTransform, CullableObject>().ForEachChunk([&frustum, &visible](u32 rowCount, const Entity*,
+			const WorldTransform* wts, const CullableObject* cullables) {
+			for (u32 i{ 0 }; i < rowCount; ++i) visible += GetBoxFrustumMargin(wts[i].TRS, cullables[i].obb, frustum) >= 0.f;
+			});
+		scalarVisible = visible;
+		});
+	u32 simdVisible{ 0 };
+	Measure("cull_simd", count, settings.Runs, [&planes, &simdVisible] {
+		u32 visible{ 0 };
+		scene::GetRO<WorldTransform, CullableObject>().ForEachChunk([&planes, &visible](u32 rowCount, const Entity*,
+			const WorldTransform* wts, const CullableObject* cullables) {
+			CullBatch batch;
+			for (u32 first{ 0 }; first < rowCount; first += CULL_SIMD_WIDTH)
+			{
+				const u32 laneCount{ std::min(CULL_SIMD_WIDTH, rowCount - first) };
+				FillCullBatch(batch, wts, cullables, first, rowCount);
+				visible += std::popcount(CullBoxBatch(batch, planes) & ((1u << laneCount) - 1));
+			}
+			});
+		simdVisible = visible;
+		});
+	AddSpeedup("cull_simd", "cull_scalar");
+
+	// only boxes that touch a plane can come out differently
+	if (scalarVisible != simdVisible) log::Warn("[ECS benchmark] the scalar cull found %u visible boxes, the SIMD one %u", scalarVisible, simdVisible);
+	_sink = _sink + scalarVisible + simdVisible;
+	ClearScene();
+}
+
+// the parallel iteration and the hierarchy update with 1, 2, 4... threads
+// NOTE: the job system is restarted for every thread count and then with the one it had before
+void
+BenchmarkThreadScaling(const BenchmarkSettings& settings)
+{
+	const u32 threadCount{ jobs::GetThreadCount() };
+	const u32 maxThreads{ std::min(std::max(std::thread::hardware_concurrency(), threadCount), MAX_SCALING_THREADS) };
+	Vec<Entity> roots{};
+	const u32 chainCount{ SpawnChains(settings.EntityCount, SCALING_HIERARCHY_DEPTH, roots) };
+	const u32 entityCount{ chainCount * SCALING_HIERARCHY_DEPTH };
+
+	for (u32 threads{ 1 }; threads <= maxThreads; threads *= 2)
+	{
+		jobs::Shutdown();
+		jobs::Initialize(threads - 1);
+
+		char name[48];
+		snprintf(name, sizeof(name), "scaling_iterate_%u_threads", threads);
+		Measure(name, entityCount, settings.Runs, [] {
+			scene::GetRW<LocalTransform, WorldTransform>().ParallelForEachChunk([](u32 rowCount, const Entity*, ColumnArray<LocalTransform, true> lts, WorldTransform* wts) {
+				for (u32 i{ 0 }; i < rowCount; ++i) WriteWorldPosition(lts.Position[i], lts.Rotation[i], lts.Scale[i], wts[i]);
+				});
+			});
+		if (threads > 1) AddSpeedup(name, "scaling_iterate_1_threads");
+
+		snprintf(name, sizeof(name), "scaling_hierarchy_%u_threads", threads);
+		Measure(name, entityCount, settings.Runs,
+			[] { scene::MarkAllComponentsChanged<LocalTransform>(); },
+			[] { transform::UpdateHierarchy(); },
+			[] {});
+		if (threads > 1) AddSpeedup(name, "scaling_hierarchy_1_threads");
+	}
+
+	jobs::Shutdown();
+	jobs::Initialize(threadCount - 1);
+	ClearScene();
+}
+
+bool
+WriteResults(const char* outputPath, const BenchmarkSettings& settings)
+{
+	FILE* file{ fopen(outputPath, "w") };
+	if (!file) return false;
+
+	fprintf(file, "{\n\t\"entityCount\": %u,\n\t\"runs\": %u,\n\t\"threads\": %u,\n\t\"results\": [\n",
+		settings.EntityCount, settings.Runs, jobs::GetThreadCount());
+	for (u32 i{ 0 }; i < _results.size(); ++i)
+	{
+		const BenchmarkResult& r{ _results[i] };
+		const f32 nsPerOp{ r.OpCount ? r.MinMs * 1'000'000.f / r.OpCount : 0.f };
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"ops\": %u, \"minMs\": %.4f, \"avgMs\": %.4f, \"nsPerOp\": %.2f }%s\n",
+			r.Name, r.OpCount, r.MinMs, r.AvgMs, nsPerOp, i + 1 < _results.size() ? "," : "");
+	}
+	fprintf(file, "\t],\n\t\"speedups\": [\n");
+	for (u32 i{ 0 }; i < _speedups.size(); ++i)
+	{
+		const BenchmarkSpeedup& s{ _speedups[i] };
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"baseline\": \"%s\", \"ratio\": %.2f }%s\n",
+			s.Name, s.Baseline, s.Ratio, i + 1 < _speedups.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+	fclose(file);
+	return true;
+}
+
+} // anonymous namespace
+
+bool
+RunBenchmarks(const char* outputPath, BenchmarkSettings settings)
+{
+	assert(settings.EntityCount != 0 && settings.Runs != 0);
+	_results.clear();
+	_speedups.clear();
+	ClearScene();
+
+	BenchmarkCreateDestroy(settings);
+	BenchmarkMigrations(settings);
+	BenchmarkQueries(settings);
+	BenchmarkIterationStyles(settings);
+	BenchmarkHierarchy(settings);
+	BenchmarkEnableDisable(settings);
+	BenchmarkCulling(settings);
+	BenchmarkJobs(settings);
+	BenchmarkThreadScaling(settings);
+
+	for (const BenchmarkResult& r : _results)
+	{
+		log::Info("[ECS benchmark] %s: %.3f ms (%.2f ns/op)", r.Name, r.MinMs, r.OpCount ? r.MinMs * 1'000'000.f / r.OpCount : 0.f);
+	}
+	for (const BenchmarkSpeedup& s : _speedups)
+	{
+		log::Info("[ECS benchmark] %s: %.2fx %s", s.Name, s.Ratio, s.Baseline);
+	}
+	return WriteResults(outputPath, settings);
+}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "CommonHeaders.h"
+
+/*
+* micro-benchmarks of the ECS core: entity create/destroy, component migrations, query iteration and lookup,
+* serial vs parallel iteration, hierarchy updates, enable/disable toggles, scalar vs SIMD frustum culling, job system overhead and thread scaling;
+* the results are written as json so they can be compared between revisions, with the speedups of the variants over their baselines
+* NOTE: runs on the current world and unloads it afterwards, and restarts the job system for the thread scaling cases,
+* the ECSBenchmark console project runs it headless
+*/
+
+namespace mofu::ecs::benchmark {
+struct BenchmarkSettings
+{
+	u32 EntityCount{ 100'000 };
+	u32 Runs{ 5 };
+};
+
+// returns false if the results couldn't be written
+bool RunBenchmarks(const char* outputPath, BenchmarkSettings settings = {});
+}
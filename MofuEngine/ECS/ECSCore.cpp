@@ -2,6 +2,8 @@
 #include "SystemRegistry.h"
 #include "Scene.h"
 #include "SystemMessages.h"
+#include "Resources.h"
+#include <atomic>
 
 namespace mofu::graphics::d3d12 {
 struct D3D12FrameInfo;
@@ -9,7 +11,8 @@ struct D3D12FrameInfo;
 
 #include "Systems/TransformSystem.cpp"
 #include "Systems/SubmitEntityRenderSystem.cpp"
-#include "Systems/PrepareEngineFrameInfo.cpp"
+//#include "Systems/PrepareEngineFrameInfo.cpp"
+#include "Systems/FrustumCullingSystem.cpp"
 //#include "Systems/TestCullingSystem.cpp"
 #include "Systems/PrepareFrameRenderSystem.cpp"
 #include "Systems/PreparePerObjectDataRenderSystem.cpp"
@@ -22,8 +25,57 @@ struct D3D12FrameInfo;
 namespace mofu::ecs {
 namespace {
 
+std::atomic<u32> _globalVersion{ 1 };
+thread_local u32 _systemVersion{ 0 };
+thread_local u32 _systemLastRunVersion{ 0 };
+std::atomic<bool> _isRunningParallelStep{ false };
+
 } // anonymous namespace
 
+u32
+AdvanceVersion()
+{
+	return _globalVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+u32
+GetWriteVersion()
+{
+	return _systemVersion != 0 ? _systemVersion : AdvanceVersion();
+}
+
+u32
+GetLastRunVersion()
+{
+	return _systemLastRunVersion;
+}
+
+void
+SetSystemVersions(u32 version, u32 lastRunVersion)
+{
+	_systemVersion = version;
+	_systemLastRunVersion = lastRunVersion;
+}
+
+void
+GetSystemVersions(u32& outVersion, u32& outLastRunVersion)
+{
+	outVersion = _systemVersion;
+	outLastRunVersion = _systemLastRunVersion;
+}
+
+void
+SetRunningParallelStep(bool isRunning)
+{
+	_isRunningParallelStep.store(isRunning, std::memory_order_relaxed);
+}
+
+bool
+IsRunningParallelStep()
+{
+	return _isRunningParallelStep.load(std::memory_order_relaxed);
+}
+
 void 
 Initialize()
 {
@@ -34,6 +86,7 @@ void
 Shutdown()
 {
 	scene::Shutdown();
+	resources::Clear();
 }
 
 void 
@@ -55,6 +108,9 @@ UpdatePostPhysics(system::SystemUpdateData data)
 
 void UpdateRenderSystems(system::SystemUpdateData data, [[maybe_unused]] const graphics::d3d12::D3D12FrameInfo& d3d12FrameInfo)
 {
+	// the render systems read the events of this frame's update phases
+	messages::PublishEvents();
+
 	system::SystemRegistry& systemRegistry{ system::SystemRegistry::Instance() };
 	systemRegistry.UpdateSystems(system::SystemGroup::PostUpdate, data);
 	systemRegistry.UpdateSystems(system::SystemGroup::Final, data);
@@ -6,6 +6,7 @@
 //#include "Graphics/D3D12/D3D12Core.h"
 #include "ComponentRegistry.h"
 #include <span>
+#include <bit>
 
 namespace mofu::graphics::d3d12 {
 struct D3D12FrameInfo;
@@ -17,6 +18,9 @@ struct SystemUpdateData;
 }
 
 constexpr u32 MAX_ENTITIES_PER_BLOCK{ 128 };
+constexpr u32 ENABLED_MASK_WORDS{ MAX_ENTITIES_PER_BLOCK / 64 };
+// ForEachComponent gathers a split component into a buffer of this size
+constexpr u32 MAX_SPLIT_COMPONENT_SIZE{ 128 };
 
 struct CetLayout
 {
@@ -26,30 +30,108 @@ struct CetLayout
 	u32 ComponentOffsets[MAX_COMPONENT_TYPES]{ sizeof(Entity) * MAX_ENTITIES_PER_BLOCK }; // there is always one entity, so the first offset is sizeof(Entity)
 };
 
+namespace scene { struct Archetype; }
+
+// the first set bit of a row mask at or after row, count if there isn't one
+inline u32
+NextSetRow(const u64* mask, u32 row, u32 count)
+{
+	for (u32 word{ row >> 6 }; word < ENABLED_MASK_WORDS; ++word)
+	{
+		const u64 bits{ word == (row >> 6) ? mask[word] & (~0ull << (row & 63)) : mask[word] };
+		if (bits) return std::min<u32>(word * 64 + (u32)std::countr_zero(bits), count);
+	}
+	return count;
+}
+
+// the first clear bit of a row mask at or after row, count if there isn't one
+inline u32
+NextClearRow(const u64* mask, u32 row, u32 count)
+{
+	for (u32 word{ row >> 6 }; word < ENABLED_MASK_WORDS; ++word)
+	{
+		const u64 bits{ word == (row >> 6) ? ~mask[word] & (~0ull << (row & 63)) : ~mask[word] };
+		if (bits) return std::min<u32>(word * 64 + (u32)std::countr_zero(bits), count);
+	}
+	return count;
+}
+
+// what a column of C is accessed through: a plain array, or the field arrays of a component stored field by field (FieldSplit)
+template<typename C, bool Writable, bool = component::IsFieldSplit<C>>
+struct ColumnArrayOf { using Type = std::conditional_t<Writable, C*, const C*>; };
+template<typename C, bool Writable>
+struct ColumnArrayOf<C, Writable, true> { using Type = typename component::FieldSplit<C>::template Columns<Writable>; };
+
+template<typename C, bool Writable>
+using ColumnArray = typename ColumnArrayOf<C, Writable>::Type;
+// C& or the row proxy of a split component
+template<typename C, bool Writable>
+using ColumnElement = decltype(std::declval<ColumnArray<C, Writable>>()[0u]);
+
 struct EntityBlock
 {
 	CetMask Signature;
+	scene::Archetype* Archetype{ nullptr }; // shared by every block with this signature
 	u32 CetSize{ 0 };
 	u16 EntityCount{ 0 };
 	u16 Capacity{ 0 }; // up to 128, maybe less based on component size
 	u16 ComponentCount{};
-	u16 LastEnabledIdx{ MAX_ENTITIES_PER_BLOCK - 1 }; // disabling entities puts them at the end of the block, when processing entities, only process up to this index
 	ComponentID* ComponentIDs{};
 	Entity* Entities; // the first array in ComponentData
 	//id::generation_t* Generations;
 	u8* ComponentData{ nullptr };
 	u32 ComponentOffsets[MAX_COMPONENT_TYPES]{ sizeof(Entity) * MAX_ENTITIES_PER_BLOCK }; // there is always one entity, so the first offset is sizeof(Entity)
+	u32 ComponentVersions[MAX_COMPONENT_TYPES]{}; // the change version of the last write to each component array
+	// a bit per row, disabled entities keep their row and only have the bit cleared; bits past EntityCount are always 0
+	u64 EnabledMask[ENABLED_MASK_WORDS]{};
 
 	template<IsComponent C>
 	C* GetComponentArray()
 	{
+		static_assert(!component::IsFieldSplit<C>, "a split component is read through GetComponentColumns");
 		u32 offset = ComponentOffsets[component::ID<C>];
 		assert(offset);
 		return reinterpret_cast<C*>(ComponentData + offset);
 	}
 
+	template<IsComponent C, bool Writable = true>
+	ColumnArray<C, Writable> GetComponentColumns()
+	{
+		static_assert(component::IsFieldSplit<C>);
+		u32 offset = ComponentOffsets[component::ID<C>];
+		assert(offset);
+		return component::FieldSplit<C>::template GetColumns<Writable>(ComponentData + offset, MAX_ENTITIES_PER_BLOCK);
+	}
+
 	inline std::span<ComponentID> GetComponentView() const { return { ComponentIDs, ComponentCount }; }
 
+	bool IsRowEnabled(u32 row) const { return (EnabledMask[row >> 6] >> (row & 63)) & 1; }
+
+	void SetRowEnabled(u32 row, bool enabled)
+	{
+		const u64 bit{ 1ull << (row & 63) };
+		EnabledMask[row >> 6] = enabled ? (EnabledMask[row >> 6] | bit) : (EnabledMask[row >> 6] & ~bit);
+	}
+
+	bool HasEnabledRows() const
+	{
+		u64 any{ 0 };
+		for (u64 word : EnabledMask) any |= word;
+		return any != 0;
+	}
+
+	u32 GetEnabledCount() const
+	{
+		u32 count{ 0 };
+		for (u64 word : EnabledMask) count += (u32)std::popcount(word);
+		return count;
+	}
+
+	// the first enabled row at or after row, EntityCount if there isn't one
+	u32 NextEnabledRow(u32 row) const { return NextSetRow(EnabledMask, row, EntityCount); }
+	// the first disabled row at or after row, EntityCount if there isn't one
+	u32 NextDisabledRow(u32 row) const { return NextClearRow(EnabledMask, row, EntityCount); }
+
 	~EntityBlock()
 	{
 		if (ComponentIDs)
@@ -68,18 +150,89 @@ struct EntityData
 	Entity id{ id::INVALID_ID };
 };
 
+/*
+* a column holds capacity rows, the array of each field starts at its offset in the component * capacity;
+* for a component that isn't split that's just the rows back to back
+* a packed range of n rows (snapshots, prefab templates) is a column of capacity n, a single component is a column of capacity 1
+*/
+inline void
+CopyColumnRows(ComponentID cid, u8* dst, u32 dstCapacity, u32 dstRow, const u8* src, u32 srcCapacity, u32 srcRow, u32 count)
+{
+	for (const component::ColumnField& field : component::GetColumnFields(cid))
+	{
+		memcpy(dst + field.Offset * dstCapacity + field.Size * dstRow, src + field.Offset * srcCapacity + field.Size * srcRow, field.Size * count);
+	}
+}
+
+inline void
+ClearColumnRows(ComponentID cid, u8* column, u32 capacity, u32 row, u32 count)
+{
+	for (const component::ColumnField& field : component::GetColumnFields(cid))
+	{
+		memset(column + field.Offset * capacity + field.Size * row, 0, field.Size * count);
+	}
+}
+
+// reads the row's component into data, packed like the component struct
+inline void
+ReadComponentRow(const EntityBlock* block, ComponentID cid, u32 row, void* data)
+{
+	CopyColumnRows(cid, (u8*)data, 1, 0, block->ComponentData + block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, row, 1);
+}
+
+inline void
+WriteComponentRow(EntityBlock* block, ComponentID cid, u32 row, const void* data)
+{
+	CopyColumnRows(cid, block->ComponentData + block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, row, (const u8*)data, 1, 0, 1);
+}
+
+// func(cid, data) gets the row's components packed like the component structs,
+// a split component is gathered into a copy that's written back after the call
 template<typename Fun>
 void ForEachComponent(const EntityBlock* const block, u32 row, Fun&& func)
 {
 	for (ComponentID cid : block->GetComponentView())
 	{
-		u32 offset = block->ComponentOffsets[cid] + component::GetComponentSize(cid) * row;
-		u8* componentData = block->ComponentData + offset;
+		if (component::GetColumnFields(cid).size() == 1)
+		{
+			u32 offset = block->ComponentOffsets[cid] + component::GetComponentSize(cid) * row;
+			u8* componentData = block->ComponentData + offset;
 
+			std::invoke(std::forward<Fun>(func), cid, componentData);
+			continue;
+		}
+
+		alignas(16) u8 componentData[MAX_SPLIT_COMPONENT_SIZE];
+		assert(component::GetComponentSize(cid) <= MAX_SPLIT_COMPONENT_SIZE);
+		u8* const column{ block->ComponentData + block->ComponentOffsets[cid] };
+		CopyColumnRows(cid, componentData, 1, 0, column, MAX_ENTITIES_PER_BLOCK, row, 1);
 		std::invoke(std::forward<Fun>(func), cid, componentData);
+		CopyColumnRows(cid, column, MAX_ENTITIES_PER_BLOCK, row, componentData, 1, 0, 1);
 	}
 }
 
+/*
+* change versions: every system update gets a new version, writable queries stamp the arrays they touch with it
+* and Changed<C> filters compare that to the version the system had the last time it ran
+*/
+u32 AdvanceVersion();
+// the running system's version, or a new one outside of systems
+u32 GetWriteVersion();
+// 0 outside of systems, so everything counts as changed
+u32 GetLastRunVersion();
+// set by the scheduler on the thread that runs a system
+void SetSystemVersions(u32 version, u32 lastRunVersion);
+void GetSystemVersions(u32& outVersion, u32& outLastRunVersion);
+// set by the scheduler while the systems of a step run on the job system, blocks can't be created or removed then
+void SetRunningParallelStep(bool isRunning);
+[[nodiscard]] bool IsRunningParallelStep();
+
+inline bool IsNewerVersion(u32 version, u32 than)
+{
+	// wraps around
+	return (i32)(version - than) > 0;
+}
+
 void Initialize();
 void Shutdown();
 
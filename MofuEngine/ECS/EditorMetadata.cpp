@@ -0,0 +1,79 @@
+#include "EditorMetadata.h"
+#if EDITOR_BUILD
+
+namespace mofu::ecs::metadata {
+namespace {
+
+struct AssetsEntry
+{
+	Entity Owner{ id::INVALID_ID };
+	EntityAssets Assets{};
+};
+
+Vec<AssetsEntry> _assets{};
+
+} // anonymous namespace
+
+struct Snapshot
+{
+	Vec<AssetsEntry> Assets{};
+};
+
+EntityAssets&
+GetAssets(Entity entity)
+{
+	assert(id::IsValid(entity));
+	const u32 index{ (u32)id::Index(entity) };
+	if (index >= _assets.size()) _assets.resize(index + 1);
+	AssetsEntry& entry{ _assets[index] };
+	if (entry.Owner != entity)
+	{
+		// either unused or left over from a removed entity with the same index
+		entry.Owner = entity;
+		entry.Assets = {};
+	}
+	return entry.Assets;
+}
+
+const EntityAssets* const
+TryGetAssets(Entity entity)
+{
+	const u32 index{ (u32)id::Index(entity) };
+	if (index >= _assets.size() || _assets[index].Owner != entity) return nullptr;
+	return &_assets[index].Assets;
+}
+
+void
+RemoveEntity(Entity entity)
+{
+	const u32 index{ (u32)id::Index(entity) };
+	if (index < _assets.size() && _assets[index].Owner == entity) _assets[index] = {};
+}
+
+void
+Clear()
+{
+	_assets.clear();
+}
+
+Snapshot*
+SaveSnapshot()
+{
+	return new Snapshot{ _assets };
+}
+
+void
+RestoreSnapshot(Snapshot* snapshot)
+{
+	assert(snapshot);
+	_assets = std::move(snapshot->Assets);
+	delete snapshot;
+}
+
+void
+DestroySnapshot(Snapshot* snapshot)
+{
+	delete snapshot;
+}
+}
+#endif
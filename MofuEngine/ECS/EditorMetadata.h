@@ -0,0 +1,36 @@
+#pragma once
+#include "ECSCommon.h"
+#if EDITOR_BUILD
+#include "Content/Asset.h"
+
+/*
+* editor-only data about entities, kept in side tables instead of the components so a component has the same layout
+* in game and editor builds; indexed by entity index, a recycled index gets a fresh entry
+*/
+
+namespace mofu::ecs::metadata {
+
+// the assets the entity's runtime resources were created from, only needed for saving the scene
+struct EntityAssets
+{
+	content::AssetHandle Mesh{ content::INVALID_HANDLE };
+	content::AssetHandle Material{ content::INVALID_HANDLE };
+	content::AssetHandle Shape{ content::INVALID_HANDLE };
+};
+
+EntityAssets& GetAssets(Entity entity);
+// nullptr if nothing was ever set for the entity
+const EntityAssets* const TryGetAssets(Entity entity);
+
+void RemoveEntity(Entity entity);
+// when unloading a scene
+void Clear();
+
+// the side tables saved with a clone of the world
+struct Snapshot;
+[[nodiscard]] Snapshot* SaveSnapshot();
+// puts the saved tables back and frees the snapshot
+void RestoreSnapshot(Snapshot* snapshot);
+void DestroySnapshot(Snapshot* snapshot);
+}
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+#include "ECSCommon.h"
+#include "ComponentRegistry.h"
+
+/*
+* records structural changes (spawns, destroys, adding and removing components) instead of applying them right away
+* every job system thread has its own buffer, so systems running on workers can record without locking
+* all buffers are played back in scene::EndFrame, component changes are grouped by source block and destination signature
+* and moved in batches
+*/
+
+namespace mofu::ecs::scene {
+
+class EntityCommandBuffer
+{
+public:
+	enum class CommandType : u8
+	{
+		Spawn,
+		Destroy,
+		AddComponents,
+		RemoveComponents,
+	};
+
+	struct Command
+	{
+		CommandType Type;
+		Entity Target{ id::INVALID_ID };
+		CetMask Signature{}; // the whole signature for spawns, the added/removed components otherwise
+		u32 DataOffset{ 0 };
+		u32 DataSize{ 0 };
+	};
+
+	// component data is stored as [ComponentID][component bytes] pairs
+	struct ComponentDataHeader
+	{
+		ComponentID ID;
+		u32 Size;
+	};
+
+	template<IsComponent... C>
+	void Spawn(const C&... components)
+	{
+		Record(CommandType::Spawn, Entity{ id::INVALID_ID }, components...);
+	}
+
+	// components are zero-initialized
+	void Spawn(const CetMask& signature)
+	{
+		_commands.emplace_back(CommandType::Spawn, Entity{ id::INVALID_ID }, signature, (u32)_data.size(), 0u);
+	}
+
+	void Destroy(Entity entity)
+	{
+		_commands.emplace_back(CommandType::Destroy, entity, CetMask{}, (u32)_data.size(), 0u);
+	}
+
+	template<IsComponent... C>
+	void AddComponents(Entity entity)
+	{
+		Record(CommandType::AddComponents, entity, C{}...);
+	}
+
+	template<IsComponent... C>
+	void AddComponents(Entity entity, const C&... components)
+	{
+		Record(CommandType::AddComponents, entity, components...);
+	}
+
+	template<IsComponent... C>
+	void RemoveComponents(Entity entity)
+	{
+		CetMask mask{};
+		(mask.set(component::ID<C>), ...);
+		_commands.emplace_back(CommandType::RemoveComponents, entity, mask, (u32)_data.size(), 0u);
+	}
+
+	[[nodiscard]] bool IsEmpty() const { return _commands.empty(); }
+	[[nodiscard]] std::span<const Command> GetCommands() const { return { _commands.data(), _commands.size() }; }
+	[[nodiscard]] const u8* GetData(const Command& command) const { return _data.data() + command.DataOffset; }
+
+	void Clear()
+	{
+		_commands.clear();
+		_data.clear();
+	}
+
+private:
+	template<IsComponent... C>
+	void Record(CommandType type, Entity entity, const C&... components)
+	{
+		CetMask mask{};
+		(mask.set(component::ID<C>), ...);
+		const u32 dataOffset{ (u32)_data.size() };
+		(WriteComponent(components), ...);
+		_commands.emplace_back(type, entity, mask, dataOffset, (u32)_data.size() - dataOffset);
+	}
+
+	template<IsComponent C>
+	void WriteComponent(const C& component)
+	{
+		static_assert(std::is_trivially_copyable_v<C>);
+		const ComponentDataHeader header{ component::ID<C>, (u32)sizeof(C) };
+		const u64 offset{ _data.size() };
+		_data.resize(offset + sizeof(ComponentDataHeader) + sizeof(C));
+		memcpy(_data.data() + offset, &header, sizeof(ComponentDataHeader));
+		memcpy(_data.data() + offset + sizeof(ComponentDataHeader), &component, sizeof(C));
+	}
+
+	Vec<Command> _commands{};
+	Vec<u8> _data{};
+};
+
+// the buffer of the calling thread, threads outside of the job system share the main thread's buffer
+EntityCommandBuffer& GetThreadCommandBuffer();
+// applies and clears every thread's buffer, called at the end of the frame
+void PlaybackCommandBuffers();
+
+}
@@ -0,0 +1,131 @@
+#include "FrustumCulling.h"
+#include <cfloat>
+
+namespace mofu::ecs::culling {
+
+FrustumPlanes
+GetFrustumPlanes(const m4x4& viewProjection)
+{
+	const auto column{ [&viewProjection](u32 c) {
+		return v4{ viewProjection.m[0][c], viewProjection.m[1][c], viewProjection.m[2][c], viewProjection.m[3][c] }; } };
+	const auto add{ [](v4 a, v4 b) { return v4{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; } };
+	const auto subtract{ [](v4 a, v4 b) { return v4{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; } };
+	const v4 c0{ column(0) }, c1{ column(1) }, c2{ column(2) }, c3{ column(3) };
+
+	FrustumPlanes frustum{ { add(c3, c0), subtract(c3, c0), add(c3, c1), subtract(c3, c1), c2, subtract(c3, c2) } };
+	for (v4& plane : frustum.Planes)
+	{
+		const f32 length{ std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z) };
+		// an infinite far plane has no normal, nothing is behind it
+		plane = length > 0.f ? v4{ plane.x / length, plane.y / length, plane.z / length, plane.w / length } : v4{ 0.f, 0.f, 0.f, 1.f };
+	}
+	return frustum;
+}
+
+FrustumPlanesBatch
+GetFrustumPlanesBatch(const FrustumPlanes& frustum)
+{
+	FrustumPlanesBatch batch;
+	for (u32 i{ 0 }; i < 6; ++i)
+	{
+		const v4& plane{ frustum.Planes[i] };
+		batch.Planes[i][0] = DirectX::XMVectorReplicate(plane.x);
+		batch.Planes[i][1] = DirectX::XMVectorReplicate(plane.y);
+		batch.Planes[i][2] = DirectX::XMVectorReplicate(plane.z);
+		batch.Planes[i][3] = DirectX::XMVectorReplicate(plane.w);
+	}
+	return batch;
+}
+
+f32
+GetBoxFrustumMargin(const m4x4& trs, const OBB& obb, const FrustumPlanes& frustum)
+{
+	const v3 center{
+		obb.Center.x * trs._11 + obb.Center.y * trs._21 + obb.Center.z * trs._31 + trs._41,
+		obb.Center.x * trs._12 + obb.Center.y * trs._22 + obb.Center.z * trs._32 + trs._42,
+		obb.Center.x * trs._13 + obb.Center.y * trs._23 + obb.Center.z * trs._33 + trs._43,
+	};
+	const f32 extents[3]{ obb.Extents.x, obb.Extents.y, obb.Extents.z };
+
+	f32 margin{ FLT_MAX };
+	for (const v4& plane : frustum.Planes)
+	{
+		const f32 distance{ plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w };
+		// the projected radius, each box axis is a row of the transform
+		f32 radius{ 0.f };
+		for (u32 axis{ 0 }; axis < 3; ++axis)
+		{
+			radius += extents[axis] * std::abs(plane.x * trs.m[axis][0] + plane.y * trs.m[axis][1] + plane.z * trs.m[axis][2]);
+		}
+		margin = std::min(margin, distance + radius);
+	}
+	return margin;
+}
+
+void
+FillCullBatch(CullBatch& batch, const component::WorldTransform* transforms, const component::CullableObject* cullables, u32 first, u32 count)
+{
+	const u32 laneCount{ std::min(CULL_SIMD_WIDTH, count - first) };
+	for (u32 lane{ 0 }; lane < CULL_SIMD_WIDTH; ++lane)
+	{
+		const u32 i{ first + std::min(lane, laneCount - 1) };
+		const m4x4& trs{ transforms[i].TRS };
+		const OBB& obb{ cullables[i].obb };
+		for (u32 row{ 0 }; row < 4; ++row)
+			for (u32 col{ 0 }; col < 3; ++col) batch.Trs[row][col][lane] = trs.m[row][col];
+		batch.Center[0][lane] = obb.Center.x;
+		batch.Center[1][lane] = obb.Center.y;
+		batch.Center[2][lane] = obb.Center.z;
+		batch.Extents[0][lane] = obb.Extents.x;
+		batch.Extents[1][lane] = obb.Extents.y;
+		batch.Extents[2][lane] = obb.Extents.z;
+	}
+}
+
+u32
+CullBoxBatch(const CullBatch& batch, const FrustumPlanesBatch& frustum)
+{
+	using namespace DirectX;
+	const auto load{ [](const f32* lanes) { return XMLoadFloat4A((const XMFLOAT4A*)lanes); } };
+
+	xmm trs[4][3];
+	for (u32 row{ 0 }; row < 4; ++row)
+		for (u32 col{ 0 }; col < 3; ++col) trs[row][col] = load(batch.Trs[row][col]);
+	const xmm cx{ load(batch.Center[0]) };
+	const xmm cy{ load(batch.Center[1]) };
+	const xmm cz{ load(batch.Center[2]) };
+	const xmm extents[3]{ load(batch.Extents[0]), load(batch.Extents[1]), load(batch.Extents[2]) };
+
+	xmm center[3];
+	for (u32 col{ 0 }; col < 3; ++col)
+	{
+		xmm v{ XMVectorMultiplyAdd(cx, trs[0][col], trs[3][col]) };
+		v = XMVectorMultiplyAdd(cy, trs[1][col], v);
+		center[col] = XMVectorMultiplyAdd(cz, trs[2][col], v);
+	}
+
+	xmm visible{ XMVectorTrueInt() };
+	for (const xmm (&plane)[4] : frustum.Planes)
+	{
+		xmm distance{ XMVectorMultiplyAdd(plane[0], center[0], plane[3]) };
+		distance = XMVectorMultiplyAdd(plane[1], center[1], distance);
+		distance = XMVectorMultiplyAdd(plane[2], center[2], distance);
+
+		xmm radius{ XMVectorZero() };
+		for (u32 axis{ 0 }; axis < 3; ++axis)
+		{
+			xmm projected{ XMVectorMultiply(plane[0], trs[axis][0]) };
+			projected = XMVectorMultiplyAdd(plane[1], trs[axis][1], projected);
+			projected = XMVectorMultiplyAdd(plane[2], trs[axis][2], projected);
+			radius = XMVectorMultiplyAdd(extents[axis], XMVectorAbs(projected), radius);
+		}
+		visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(XMVectorAdd(distance, radius), XMVectorZero()));
+	}
+
+	u32 lanes[CULL_SIMD_WIDTH];
+	XMStoreInt4(lanes, visible);
+	u32 mask{ 0 };
+	for (u32 lane{ 0 }; lane < CULL_SIMD_WIDTH; ++lane) mask |= (lanes[lane] & 1) << lane;
+	return mask;
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "CommonHeaders.h"
+#include "Transform.h"
+
+/*
+* the box vs frustum test of the culling system, CULL_SIMD_WIDTH boxes at a time
+* GetBoxFrustumMargin is the scalar reference the SIMD kernel gets checked and benchmarked against
+*/
+
+namespace mofu::ecs::culling {
+constexpr u32 CULL_SIMD_WIDTH{ 4 };
+// the SIMD and scalar tests can disagree on boxes that just touch a plane
+constexpr f32 CULL_CHECK_EPSILON{ 1e-3f };
+
+// left, right, bottom, top, near, far; normals point inside, a point is inside when dot(n, p) + d >= 0
+struct FrustumPlanes
+{
+	v4 Planes[6];
+};
+
+// every plane value replicated across the lanes
+struct FrustumPlanesBatch
+{
+	xmm Planes[6][4];
+};
+
+/*
+* SoA input of the culling kernel, every array holds one value of CULL_SIMD_WIDTH boxes
+* Trs holds the first three columns of the world transforms, the 4th is always 0 0 0 1
+*/
+struct CullBatch
+{
+	alignas(16) f32 Trs[4][3][CULL_SIMD_WIDTH];
+	alignas(16) f32 Center[3][CULL_SIMD_WIDTH];
+	alignas(16) f32 Extents[3][CULL_SIMD_WIDTH];
+};
+
+// the planes of a row-vector view projection with a [0, 1] depth range, so reversed depth works too
+[[nodiscard]] FrustumPlanes GetFrustumPlanes(const m4x4& viewProjection);
+[[nodiscard]] FrustumPlanesBatch GetFrustumPlanesBatch(const FrustumPlanes& frustum);
+
+// the distance of the box from the outside of the frustum, negative if it's completely behind a plane
+[[nodiscard]] f32 GetBoxFrustumMargin(const m4x4& trs, const OBB& obb, const FrustumPlanes& frustum);
+
+// loads the boxes [first, first + CULL_SIMD_WIDTH) of a chunk, lanes past count repeat the last box
+void FillCullBatch(CullBatch& batch, const component::WorldTransform* transforms, const component::CullableObject* cullables, u32 first, u32 count);
+// the same test as GetBoxFrustumMargin for CULL_SIMD_WIDTH boxes, returns a bit per visible lane
+[[nodiscard]] u32 CullBoxBatch(const CullBatch& batch, const FrustumPlanesBatch& frustum);
+}
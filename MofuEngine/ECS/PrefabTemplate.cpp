@@ -0,0 +1,168 @@
+#include "PrefabTemplate.h"
+#include "Scene.h"
+#include "TransformHierarchy.h"
+
+namespace mofu::ecs::prefab {
+namespace {
+// the original's render items and bodies stay with it, copies that don't get their own have none
+void
+ResetResourceIDs(PrefabTemplate::Group& group)
+{
+	const u32 rowCount{ (u32)group.Entities.size() };
+	for (u32 c{ 0 }; c < group.ComponentIDs.size(); ++c)
+	{
+		u8* const column{ group.Data.data() + group.ColumnOffsets[c] };
+		if (group.ComponentIDs[c] == component::ID<component::RenderMesh>)
+		{
+			for (u32 row{ 0 }; row < rowCount; ++row) ((component::RenderMesh*)column)[row].RenderItemID = id::INVALID_ID;
+		}
+		else if (group.ComponentIDs[c] == component::ID<component::Collider>)
+		{
+			for (u32 row{ 0 }; row < rowCount; ++row) ((component::Collider*)column)[row].BodyID = JPH::BodyID{};
+		}
+	}
+}
+} // anonymous namespace
+
+void
+Compile(std::span<const Entity> entities, PrefabTemplate& outTemplate)
+{
+	outTemplate = {};
+	outTemplate.EntityCount = (u32)entities.size();
+	HashMap<id_t, u32> templateIndices{};
+	templateIndices.reserve(entities.size());
+	for (u32 i{ 0 }; i < entities.size(); ++i) templateIndices.emplace((id_t)entities[i], i);
+
+	HashMap<CetMask, u32> groupIndices{};
+	for (u32 i{ 0 }; i < entities.size(); ++i)
+	{
+		const EntityData& data{ scene::GetEntityData(entities[i]) };
+		CetMask signature{ data.block->Signature };
+		scene::ForEachSparseComponent(entities[i], [&signature](ComponentID cid) { signature.set(cid); });
+
+		auto [it, isNew]{ groupIndices.try_emplace(signature, (u32)outTemplate.Groups.size()) };
+		if (isNew)
+		{
+			PrefabTemplate::Group* const group{ outTemplate.Groups.emplace_back() };
+			group->Signature = signature;
+			for (ComponentID cid : data.block->GetComponentView()) group->ComponentIDs.emplace_back(cid);
+		}
+		PrefabTemplate::Group& group{ outTemplate.Groups[it->second] };
+		group.Entities.emplace_back(i);
+		group.Enabled.emplace_back((u8)data.block->IsRowEnabled(data.row));
+	}
+
+	for (PrefabTemplate::Group& group : outTemplate.Groups)
+	{
+		const u32 rowCount{ (u32)group.Entities.size() };
+		u32 size{ 0 };
+		for (ComponentID cid : group.ComponentIDs)
+		{
+			group.ColumnOffsets.emplace_back(size);
+			size += component::GetComponentSize(cid) * rowCount;
+		}
+		group.Data.resize(size);
+
+		for (u32 row{ 0 }; row < rowCount; ++row)
+		{
+			const EntityData& data{ scene::GetEntityData(entities[group.Entities[row]]) };
+			for (u32 c{ 0 }; c < group.ComponentIDs.size(); ++c)
+			{
+				const ComponentID cid{ group.ComponentIDs[c] };
+				CopyColumnRows(cid, group.Data.data() + group.ColumnOffsets[c], rowCount, row,
+					data.block->ComponentData + data.block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, data.row, 1);
+			}
+		}
+		ResetResourceIDs(group);
+
+		for (const component::EntityReferenceField& field : component::ENTITY_REFERENCE_FIELDS)
+		{
+			if (!group.Signature.test(field.Component)) continue;
+			const u32 c{ (u32)(std::find(group.ComponentIDs.begin(), group.ComponentIDs.end(), field.Component) - group.ComponentIDs.begin()) };
+			const u32 componentSize{ component::GetComponentSize(field.Component) };
+			for (u32 row{ 0 }; row < rowCount; ++row)
+			{
+				const Entity referenced{ *(const Entity*)(group.Data.data() + group.ColumnOffsets[c] + componentSize * row + field.Offset) };
+				auto target{ templateIndices.find((id_t)referenced) };
+				if (target == templateIndices.end()) continue;
+				outTemplate.References.emplace_back(PrefabTemplate::Reference{ group.Entities[row], field.Component, field.Offset, target->second });
+			}
+		}
+	}
+}
+
+void
+Instantiate(const PrefabTemplate& prefabTemplate, u32 count, Vec<Entity>& outEntities)
+{
+	const u32 entityCount{ prefabTemplate.EntityCount };
+	if (count == 0 || entityCount == 0) return;
+	const u32 firstEntity{ (u32)outEntities.size() };
+	outEntities.resize(firstEntity + entityCount * count);
+	// the entity of a template index in one of the copies
+	const auto copyOf{ [&outEntities, firstEntity, entityCount](u32 copy, u32 index) -> Entity& {
+		return outEntities[firstEntity + entityCount * copy + index];
+		} };
+
+	Vec<scene::BlockRange> ranges{};
+	for (const PrefabTemplate::Group& group : prefabTemplate.Groups)
+	{
+		const u32 rowCount{ (u32)group.Entities.size() };
+		const u32 firstRange{ (u32)ranges.size() };
+		scene::CreateEntities(group.Signature, rowCount * count, ranges);
+
+		// the copies of the group follow each other in the rows, so a range is filled with runs of whole or partial copies
+		u32 groupRow{ 0 };
+		for (u32 r{ firstRange }; r < ranges.size(); ++r)
+		{
+			const scene::BlockRange& range{ ranges[r] };
+			EntityBlock* const block{ range.Block };
+			for (u32 i{ 0 }; i < range.Count;)
+			{
+				const u32 templateRow{ (groupRow + i) % rowCount };
+				const u32 run{ std::min(rowCount - templateRow, (u32)range.Count - i) };
+				for (u32 c{ 0 }; c < group.ComponentIDs.size(); ++c)
+				{
+					const ComponentID cid{ group.ComponentIDs[c] };
+					CopyColumnRows(cid, block->ComponentData + block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, range.FirstRow + i,
+						group.Data.data() + group.ColumnOffsets[c], rowCount, templateRow, run);
+				}
+				i += run;
+			}
+
+			for (u32 i{ 0 }; i < range.Count; ++i, ++groupRow)
+			{
+				const u32 templateRow{ groupRow % rowCount };
+				copyOf(groupRow / rowCount, group.Entities[templateRow]) = block->Entities[range.FirstRow + i];
+				if (!group.Enabled[templateRow]) block->SetRowEnabled(range.FirstRow + i, false);
+			}
+		}
+	}
+
+	for (const PrefabTemplate::Reference& reference : prefabTemplate.References)
+	{
+		const u32 componentSize{ component::GetComponentSize(reference.Component) };
+		for (u32 copy{ 0 }; copy < count; ++copy)
+		{
+			const EntityData& data{ scene::GetEntityData(copyOf(copy, reference.Source)) };
+			u8* const column{ data.block->ComponentData + data.block->ComponentOffsets[reference.Component] };
+			*(Entity*)(column + componentSize * data.row + reference.Offset) = copyOf(copy, reference.Target);
+		}
+	}
+
+	// staging worlds don't have a hierarchy, MergeWorld adds the merged entities
+	if (!scene::IsMainWorld()) return;
+	Vec<Entity> transformEntities{};
+	Vec<Entity> parents{};
+	transformEntities.reserve(entityCount * count);
+	parents.reserve(entityCount * count);
+	for (u32 i{ firstEntity }; i < outEntities.size(); ++i)
+	{
+		const EntityData& data{ scene::GetEntityData(outEntities[i]) };
+		if (!data.block->Signature.test(component::ID<component::WorldTransform>)) continue;
+		transformEntities.emplace_back(outEntities[i]);
+		parents.emplace_back(data.block->Signature.test(component::ID<component::Child>)
+			? data.block->GetComponentArray<component::Child>()[data.row].ParentEntity : Entity{ id::INVALID_ID });
+	}
+	transform::AddEntitiesToHierarchy(transformEntities, parents);
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ECSCommon.h"
+#include <span>
+
+/*
+* a hierarchy of entities compiled once into packed columns, grouped by signature the same way the blocks are
+* instantiating copies is a batched fill of block rows per group and fixing up the entity references between the copies,
+* the copies join the transform hierarchy in one batch instead of one by one through the deferred spawns
+*/
+
+namespace mofu::ecs::prefab {
+
+struct PrefabTemplate
+{
+	// the template entities with one signature (sparse tags included), each column is laid out like a block column of their rows
+	struct Group
+	{
+		CetMask Signature{};
+		Vec<u32> Entities{}; // template indices, in row order
+		Vec<ComponentID> ComponentIDs{};
+		Vec<u32> ColumnOffsets{}; // into Data, in the order of ComponentIDs
+		Vec<u8> Data{};
+		Vec<u8> Enabled{}; // by row
+	};
+
+	// a component field of a template entity that points at another template entity, each copy points at its own
+	struct Reference
+	{
+		u32 Source; // template index
+		ComponentID Component;
+		u32 Offset; // of the field in the component
+		u32 Target; // template index
+	};
+
+	Vec<Group> Groups{};
+	Vec<Reference> References{};
+	u32 EntityCount{ 0 };
+};
+
+// the template indices are the positions in entities, parents have to come before their children like in saved hierarchies
+// render item and body ids aren't kept, the copies start without them
+void Compile(std::span<const Entity> entities, PrefabTemplate& outTemplate);
+// appends count copies to outEntities, copy after copy and in template order within a copy
+// references to entities outside the template are copied as they are
+void Instantiate(const PrefabTemplate& prefabTemplate, u32 count, Vec<Entity>& outEntities);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "ECSCommon.h"
+#include "ComponentRegistry.h"
+#include <tuple>
+
+/*
+* filters that can go into the component list of a query, e.g. GetRW<WorldTransform, Without<StaticObject>, Changed<LocalTransform>>()
+* With/Changed components are required like any other but aren't returned, Without components exclude the block,
+* Optional<C> is returned as a C* that's null where the entity doesn't have C
+* the required and excluded components are matched against the block signature, so skipped blocks are never touched
+* sparse components (component::SparseComponent) aren't part of the block signature, they're joined row by row
+*/
+
+namespace mofu::ecs {
+
+// only blocks where C was written to by a writable query since the current system last ran
+template<IsComponent C>
+struct Changed {};
+
+template<IsComponent C>
+struct With {};
+
+template<IsComponent C>
+struct Without {};
+
+template<IsComponent C>
+struct Optional {};
+
+// the block signature filter of a query
+struct QueryMask
+{
+	CetMask All{}; // blocks need all of these
+	CetMask None{}; // and none of these
+
+	[[nodiscard]] bool Matches(const CetMask& blockSignature) const
+	{
+		return (blockSignature & All) == All && (blockSignature & None).none();
+	}
+
+	bool operator==(const QueryMask& o) const { return All == o.All && None == o.None; }
+};
+
+namespace detail {
+template<typename T>
+struct QueryTerm
+{
+	using Type = T;
+	static constexpr bool IsFilter{ false }; // not returned by the iteration
+	static constexpr bool IsChangedFilter{ false };
+	static constexpr bool IsExcluded{ false };
+	static constexpr bool IsOptional{ false };
+	static constexpr bool IsSparse{ component::IsSparse<T> };
+};
+
+template<IsComponent C>
+struct QueryTerm<Changed<C>> : QueryTerm<C>
+{
+	static_assert(!component::IsSparse<C>, "sparse components don't track change versions");
+	static constexpr bool IsFilter{ true };
+	static constexpr bool IsChangedFilter{ true };
+};
+
+template<IsComponent C>
+struct QueryTerm<With<C>> : QueryTerm<C>
+{
+	static constexpr bool IsFilter{ true };
+};
+
+template<IsComponent C>
+struct QueryTerm<Without<C>> : QueryTerm<C>
+{
+	static constexpr bool IsFilter{ true };
+	static constexpr bool IsExcluded{ true };
+};
+
+template<IsComponent C>
+struct QueryTerm<Optional<C>> : QueryTerm<C>
+{
+	// a chunk gets one pointer per column, a sparse tag would need one per row
+	static_assert(!component::IsSparse<C>, "sparse components can't be optional, use EntityHasComponent");
+	static constexpr bool IsOptional{ true };
+};
+
+template<typename Term>
+void
+AddToQueryMask(QueryMask& mask)
+{
+	using T = QueryTerm<Term>;
+	if constexpr (T::IsSparse || T::IsOptional) return;
+	else if constexpr (T::IsExcluded) mask.None.set(component::ID<typename T::Type>);
+	else mask.All.set(component::ID<typename T::Type>);
+}
+
+// the components a query returns, as a tuple
+template<typename... Term>
+using ReturnedComponents = decltype(std::tuple_cat(std::declval<std::conditional_t<QueryTerm<Term>::IsFilter, std::tuple<>, std::tuple<Term>>>()...));
+} // detail
+
+// the block signature filter of the query, sparse components are checked per row
+template<typename... Term>
+const QueryMask&
+GetQueryMask()
+{
+	static const QueryMask mask = [] {
+		QueryMask m;
+		(detail::AddToQueryMask<Term>(m), ...);
+		assert((m.All & m.None).none());
+		return m;
+		}();
+	return mask;
+}
+
+}
+
+namespace std {
+template<>
+struct hash<mofu::ecs::QueryMask>
+{
+	size_t operator()(const mofu::ecs::QueryMask& mask) const
+	{
+		const hash<mofu::ecs::CetMask> hasher{};
+		return hasher(mask.All) ^ (hasher(mask.None) * 31);
+	}
+};
+}
@@ -1,17 +1,116 @@
 #pragma once
 #include "ECSCommon.h"
 #include "ECSCore.h"
+#include "QueryFilters.h"
+#include "SparseSet.h"
+#include "Utilities/JobSystem.h"
 
 namespace mofu::ecs {
+namespace detail {
+// how a returned term is read from a block, Optional<C> gives a null array when the block doesn't have C
+template<bool Writable, typename T>
+struct ReturnedColumn
+{
+	using Array = ColumnArray<T, Writable>;
+	using Element = ColumnElement<T, Writable>;
+
+	static Array Get(EntityBlock* block) { return GetColumn<T, Writable>(block); }
+	static Array Offset(Array array, u32 first) { return array + first; }
+	static Element At(Array array, u32 row) { return array[row]; }
+
+	static void MarkWritten(EntityBlock* block, u32 version)
+	{
+		if constexpr (!component::IsSparse<T>) block->ComponentVersions[component::ID<T>] = version;
+	}
+};
+
+template<bool Writable, IsComponent C>
+struct ReturnedColumn<Writable, Optional<C>>
+{
+	static_assert(!component::IsFieldSplit<C>, "split components can't be optional yet");
+	using Array = std::conditional_t<Writable, C*, const C*>;
+	using Element = Array;
+
+	static Array Get(EntityBlock* block) { return block->Signature.test(component::ID<C>) ? block->GetComponentArray<C>() : nullptr; }
+	static Array Offset(Array array, u32 first) { return array ? array + first : nullptr; }
+	static Element At(Array array, u32 row) { return array ? array + row : nullptr; }
+
+	static void MarkWritten(EntityBlock* block, u32 version)
+	{
+		if (block->Signature.test(component::ID<C>)) block->ComponentVersions[component::ID<C>] = version;
+	}
+};
+
+// access to the returned component arrays of a block
+template<bool Writable, typename Components>
+struct BlockAccess;
+
+template<bool Writable, typename... C>
+struct BlockAccess<Writable, std::tuple<C...>>
+{
+	template<typename T>
+	using Column = ReturnedColumn<Writable, T>;
+	using Row = std::tuple<Entity, typename Column<C>::Element...>;
+
+	static Row GetRow(EntityBlock* block, u32 row)
+	{
+		return { block->Entities[row], Column<C>::At(Column<C>::Get(block), row)... };
+	}
+
+	// one call per run of matching rows, so a block without disabled entities is a single call
+	template<typename Fun>
+	static void CallChunks(EntityBlock* block, const u64* rows, Fun& func)
+	{
+		const u32 count{ block->EntityCount };
+		for (u32 first{ NextSetRow(rows, 0, count) }; first < count;)
+		{
+			const u32 end{ NextClearRow(rows, first, count) };
+			func(end - first, (const Entity*)block->Entities + first, Column<C>::Offset(Column<C>::Get(block), first)...);
+			first = NextSetRow(rows, end, count);
+		}
+	}
+
+	template<typename Fun>
+	static void CallRows(EntityBlock* block, const u64* rows, Fun& func)
+	{
+		const Entity* const entities{ block->Entities };
+		[rows, entities, &func](typename Column<C>::Array... arrays) {
+			for (u32 word{ 0 }; word < ENABLED_MASK_WORDS; ++word)
+			{
+				u64 bits{ rows[word] };
+				while (bits)
+				{
+					const u32 row{ word * 64 + (u32)std::countr_zero(bits) };
+					bits &= bits - 1;
+					func(entities[row], Column<C>::At(arrays, row)...);
+				}
+			}
+			}(Column<C>::Get(block)...);
+	}
+
+	static void MarkWritten(EntityBlock* block, u32 version)
+	{
+		(Column<C>::MarkWritten(block, version), ...);
+	}
+};
+} // detail
+
 //TODO: might add bool WithEntities here but idk
 template<bool Writable, typename... Component>
 class QueryView
 {
 	using BlockPtr = EntityBlock*;
+	using Access = detail::BlockAccess<Writable, detail::ReturnedComponents<Component...>>;
+	static constexpr bool HAS_CHANGED_FILTER{ (detail::QueryTerm<Component>::IsChangedFilter || ...) };
+	static constexpr bool HAS_SPARSE_TERM{ (detail::QueryTerm<Component>::IsSparse || ...) };
+	// the rows of a block that get iterated
+	using RowMask = u64[ENABLED_MASK_WORDS];
 
 public:
-	explicit QueryView(Vec<BlockPtr>& blocks)
-		: _blocks(std::move(blocks))
+	// NOTE: the view doesn't own the block list, it points into the scene's query cache,
+	// so structural changes (creating or removing blocks) while iterating invalidate it
+	explicit QueryView(std::span<BlockPtr const> blocks)
+		: _blocks(blocks), _writeVersion{ Writable ? GetWriteVersion() : 0 }, _lastRunVersion{ GetLastRunVersion() }
 	{
 	}
 
@@ -21,26 +120,28 @@ public:
 	public:
 		// TODO: actual read-only views
 
-		//TODO: rethink my first idea 
-		Iterator(BlockPtr* blockOffset, BlockPtr* blockEnd)
-			: _currentBlock(blockOffset), _lastBlock(blockEnd)
+		//TODO: rethink my first idea
+		Iterator(const QueryView* view, BlockPtr const* blockOffset, BlockPtr const* blockEnd)
+			: _view(view), _currentBlock(blockOffset), _lastBlock(blockEnd)
 		{
+			// cached block lists can contain blocks that are still empty
+			SkipBlocks();
 		}
 
-		using returned_type = std::conditional_t<Writable, std::tuple<Entity, Component&...>, std::tuple<Entity, const Component&...>>;
+		using returned_type = typename Access::Row;
 
 		returned_type operator*() const
 		{
-			return { (*_currentBlock)->Entities[_index], (*_currentBlock)->GetComponentArray<Component>()[_index]... };
+			return Access::GetRow(*_currentBlock, _index);
 		}
 
 		Iterator& operator++()
 		{
-			++_index;
-			while (_currentBlock != _lastBlock && (_index == (*_currentBlock)->EntityCount || _index > (*_currentBlock)->LastEnabledIdx))
+			_index = NextSetRow(_rows, _index + 1, (*_currentBlock)->EntityCount);
+			if (_index == (*_currentBlock)->EntityCount)
 			{
 				++_currentBlock;
-				_index = 0;
+				SkipBlocks();
 			}
 			return *this;
 		}
@@ -51,16 +152,112 @@ public:
 		}
 
 	private:
-		BlockPtr* _currentBlock{ nullptr };
-		BlockPtr* _lastBlock{ nullptr };
+		void SkipBlocks()
+		{
+			while (_currentBlock != _lastBlock && !_view->BeginBlock(*_currentBlock, _rows)) ++_currentBlock;
+			_index = _currentBlock != _lastBlock ? NextSetRow(_rows, 0, (*_currentBlock)->EntityCount) : 0;
+		}
+
+		const QueryView* _view{ nullptr };
+		BlockPtr const* _currentBlock{ nullptr };
+		BlockPtr const* _lastBlock{ nullptr };
 		u32 _index{ 0 };
+		RowMask _rows{};
 	};
 
-	Iterator begin() { return { _blocks.data(), _blocks.data() + _blocks.size() }; }
-	Iterator end() { return { _blocks.data() + _blocks.size(), _blocks.data() + _blocks.size() }; }
+	Iterator begin() { return { this, _blocks.data(), _blocks.data() + _blocks.size() }; }
+	Iterator end() { return { this, _blocks.data() + _blocks.size(), _blocks.data() + _blocks.size() }; }
+
+	template<typename C>
+	using ComponentPtr = std::conditional_t<Writable, C*, const C*>;
+
+	// calls func(entityCount, entities, componentArrays...) for every run of enabled rows in a block, optional arrays can be null
+	template<typename Fun>
+	void ForEachChunk(Fun&& func) const
+	{
+		for (BlockPtr block : _blocks)
+		{
+			RowMask rows;
+			if (!BeginBlock(block, rows)) continue;
+			Access::CallChunks(block, rows, func);
+		}
+	}
+
+	// same as ForEachChunk, but the blocks are spread across worker threads
+	// func can't make structural changes and mustn't write to data shared between blocks
+	template<typename Fun>
+	void ParallelForEachChunk(Fun&& func) const
+	{
+		jobs::ParallelFor((u32)_blocks.size(), 1, [this, &func](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i)
+			{
+				BlockPtr block{ _blocks[i] };
+				RowMask rows;
+				if (!BeginBlock(block, rows)) continue;
+				Access::CallChunks(block, rows, func);
+			}
+			});
+	}
+
+	// calls func(entity, components&...) for every enabled entity, with whole blocks given to the worker threads
+	template<typename Fun>
+	void ParallelForEach(Fun&& func) const
+	{
+		jobs::ParallelFor((u32)_blocks.size(), 1, [this, &func](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i)
+			{
+				BlockPtr block{ _blocks[i] };
+				RowMask rows;
+				if (!BeginBlock(block, rows)) continue;
+				Access::CallRows(block, rows, func);
+			}
+			});
+	}
+
+	[[nodiscard]] u32 BlockCount() const { return (u32)_blocks.size(); }
 
 private:
-	Vec<BlockPtr> _blocks{};
+	template<typename Term>
+	static bool IsTermChanged(const EntityBlock* const block, u32 sinceVersion)
+	{
+		if constexpr (detail::QueryTerm<Term>::IsChangedFilter)
+			return IsNewerVersion(block->ComponentVersions[component::ID<typename detail::QueryTerm<Term>::Type>], sinceVersion);
+		else
+			return false;
+	}
+
+	template<typename Term>
+	static void JoinTerm(const EntityBlock* const block, u64* rows)
+	{
+		using T = detail::QueryTerm<Term>;
+		if constexpr (T::IsSparse)
+			JoinSparseSet(block, scene::GetSparseSet(component::ID<typename T::Type>), rows, T::IsExcluded);
+	}
+
+	// false if the block is skipped, otherwise outRows gets the enabled rows that pass the sparse terms
+	// writable views mark the returned arrays as written when they enter a block
+	bool BeginBlock(EntityBlock* block, u64* outRows) const
+	{
+		if (!block->HasEnabledRows()) return false;
+		if constexpr (HAS_CHANGED_FILTER)
+		{
+			if (!(IsTermChanged<Component>(block, _lastRunVersion) || ...)) return false;
+		}
+		memcpy(outRows, block->EnabledMask, sizeof(block->EnabledMask));
+		if constexpr (HAS_SPARSE_TERM)
+		{
+			(JoinTerm<Component>(block, outRows), ...);
+			u64 any{ 0 };
+			for (u32 word{ 0 }; word < ENABLED_MASK_WORDS; ++word) any |= outRows[word];
+			if (!any) return false;
+		}
+		if constexpr (Writable) Access::MarkWritten(block, _writeVersion);
+		return true;
+	}
+
+	std::span<BlockPtr const> _blocks{};
+	u32 _writeVersion{ 0 };
+	u32 _lastRunVersion{ 0 };
 };
 
-}
\ No newline at end of file
+}
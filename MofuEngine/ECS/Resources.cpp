@@ -0,0 +1,64 @@
+#include "Resources.h"
+#include "Scene.h"
+#include <atomic>
+
+namespace mofu::ecs::resources::detail {
+namespace {
+
+std::atomic<u32> _nextTypeIndex{ 0 };
+
+void
+DestroySlot(ResourceSlot& slot)
+{
+	if (slot.Data) slot.Destroy(slot.Data);
+	slot = {};
+}
+
+} // anonymous namespace
+
+void
+ResourceStore::Clear()
+{
+	for (ResourceSlot& slot : Slots) DestroySlot(slot);
+}
+
+u32
+NextTypeIndex()
+{
+	return _nextTypeIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+void*
+GetSlot(u32 typeIndex)
+{
+	const Vec<ResourceSlot>& slots{ scene::GetResourceStore().Slots };
+	return typeIndex < slots.size() ? slots[typeIndex].Data : nullptr;
+}
+
+void
+SetSlot(u32 typeIndex, void* data, Destructor destructor)
+{
+	Vec<ResourceSlot>& slots{ scene::GetResourceStore().Slots };
+	if (typeIndex >= slots.size()) slots.resize(typeIndex + 1);
+	DestroySlot(slots[typeIndex]);
+	slots[typeIndex] = { data, destructor };
+}
+
+void
+ResetSlot(u32 typeIndex)
+{
+	Vec<ResourceSlot>& slots{ scene::GetResourceStore().Slots };
+	if (typeIndex < slots.size()) DestroySlot(slots[typeIndex]);
+}
+
+} // mofu::ecs::resources::detail
+
+namespace mofu::ecs::resources {
+
+void
+Clear()
+{
+	scene::GetResourceStore().Clear();
+}
+
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include "ECSCommon.h"
+#include "Utilities/Math.h"
+
+/*
+* world-level resources, one value per type that doesn't belong to any entity (frame info, main camera, light set...)
+* they don't take up an entity block like a singleton entity would and a lookup is just an array index
+* shared values are interned per type and referenced through a handle, so a group of entities can point at one copy
+* every world has its own resources, the functions here work on the world that's current on the calling thread
+* NOTE: adding and removing resources isn't thread safe, Get/TryGet are
+*/
+
+namespace mofu::ecs::resources {
+namespace detail {
+using Destructor = void(*)(void*);
+
+struct ResourceSlot
+{
+	void* Data{ nullptr };
+	Destructor Destroy{ nullptr };
+};
+
+// the resources of one world, destroyed with it
+struct ResourceStore
+{
+	Vec<ResourceSlot> Slots{};
+
+	ResourceStore() = default;
+	ResourceStore(ResourceStore&& o) noexcept : Slots{ std::move(o.Slots) } {}
+	ResourceStore& operator=(ResourceStore&& o) noexcept
+	{
+		if (this != &o)
+		{
+			Clear();
+			Slots = std::move(o.Slots);
+		}
+		return *this;
+	}
+	~ResourceStore() { Clear(); }
+
+	void Clear();
+};
+
+u32 NextTypeIndex();
+void* GetSlot(u32 typeIndex);
+void SetSlot(u32 typeIndex, void* data, Destructor destructor);
+void ResetSlot(u32 typeIndex);
+
+template<typename T>
+u32
+TypeIndex()
+{
+	static const u32 index{ NextTypeIndex() };
+	return index;
+}
+} // detail
+
+// creates the resource, replacing the previous value of the type
+template<typename T, typename... Args>
+T&
+Emplace(Args&&... args)
+{
+	T* const resource{ new T{ std::forward<Args>(args)... } };
+	detail::SetSlot(detail::TypeIndex<T>(), resource, [](void* data) { delete (T*)data; });
+	return *resource;
+}
+
+template<typename T>
+[[nodiscard]] T*
+TryGet()
+{
+	return (T*)detail::GetSlot(detail::TypeIndex<T>());
+}
+
+template<typename T>
+[[nodiscard]] T&
+Get()
+{
+	T* const resource{ TryGet<T>() };
+	assert(resource);
+	return *resource;
+}
+
+template<typename T>
+[[nodiscard]] bool
+Has()
+{
+	return TryGet<T>() != nullptr;
+}
+
+template<typename T>
+void
+Remove()
+{
+	detail::ResetSlot(detail::TypeIndex<T>());
+}
+
+// destroys every resource of the current world, the type indices stay valid
+void Clear();
+
+template<typename T>
+struct SharedHandle
+{
+	u32 Index{ U32_INVALID_ID };
+	[[nodiscard]] bool IsValid() const { return Index != U32_INVALID_ID; }
+	bool operator==(const SharedHandle&) const = default;
+};
+
+// interned values of T, acquiring a value that's already stored returns its handle and bumps the ref count
+// equality is bytewise, so T should be trivially copyable and have no padding that could differ
+template<typename T>
+class SharedValues
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	static constexpr u64 ALIGNED_SIZE{ math::AlignUp<sizeof(u64)>(sizeof(T)) };
+
+public:
+	[[nodiscard]] SharedHandle<T> Acquire(const T& value)
+	{
+		const u64 key{ GetKey(value) };
+		auto it{ _keyToIndex.find(key) };
+		if (it != _keyToIndex.end() && memcmp(&_values[it->second], &value, sizeof(T)) == 0)
+		{
+			_refCounts[it->second]++;
+			return { it->second };
+		}
+
+		u32 index{ U32_INVALID_ID };
+		if (!_freeSlots.empty())
+		{
+			index = _freeSlots.back();
+			_freeSlots.pop_back();
+			_values[index] = value;
+			_refCounts[index] = 1;
+		}
+		else
+		{
+			index = (u32)_values.size();
+			_values.emplace_back(value);
+			_refCounts.emplace_back(1);
+		}
+		// a crc collision with a different value just doesn't get deduplicated
+		if (it == _keyToIndex.end()) _keyToIndex.emplace(key, index);
+		return { index };
+	}
+
+	void Release(SharedHandle<T> handle)
+	{
+		assert(handle.Index < _values.size() && _refCounts[handle.Index] != 0);
+		if (--_refCounts[handle.Index] != 0) return;
+
+		auto it{ _keyToIndex.find(GetKey(_values[handle.Index])) };
+		if (it != _keyToIndex.end() && it->second == handle.Index) _keyToIndex.erase(it);
+		_freeSlots.emplace_back(handle.Index);
+	}
+
+	[[nodiscard]] const T& Get(SharedHandle<T> handle) const
+	{
+		assert(handle.Index < _values.size() && _refCounts[handle.Index] != 0);
+		return _values[handle.Index];
+	}
+
+	[[nodiscard]] u32 GetRefCount(SharedHandle<T> handle) const { return handle.Index < _refCounts.size() ? _refCounts[handle.Index] : 0; }
+	[[nodiscard]] u32 UniqueCount() const { return (u32)(_values.size() - _freeSlots.size()); }
+
+private:
+	static u64 GetKey(const T& value)
+	{
+		// CRC32_u64 works on 8 byte chunks, so hash a zero-padded copy
+		alignas(u64) u8 bytes[ALIGNED_SIZE]{};
+		memcpy(bytes, &value, sizeof(T));
+		return math::CRC32_u64(bytes, ALIGNED_SIZE);
+	}
+
+	Vec<T> _values{};
+	Vec<u32> _refCounts{};
+	Vec<u32> _freeSlots{};
+	HashMap<u64, u32> _keyToIndex{};
+};
+
+// the shared values of T live in the resource store like any other resource, so every world interns its own
+template<typename T>
+SharedValues<T>&
+GetSharedValues()
+{
+	SharedValues<T>* values{ TryGet<SharedValues<T>>() };
+	return values ? *values : Emplace<SharedValues<T>>();
+}
+
+}
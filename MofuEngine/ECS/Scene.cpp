@@ -10,54 +10,274 @@
 #include "Utilities/SlabAllocator.h"
 #include "ComponentRegistry.h"
 #include "TransformHierarchy.h"
+#include "EntityCommandBuffer.h"
+#include "SystemMessages.h"
 #include "Physics/BodyManager.h"
+#include "Utilities/JobSystem.h"
+#include "EditorMetadata.h"
+#include "Graphics/Lights/Light.h"
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
 
 namespace mofu::ecs::scene {
 
+// the column copies for moving a row between two archetypes, all blocks of an archetype share the layout so they work for any pair of blocks
+struct ColumnCopy
+{
+	u32 SrcOffset;
+	u32 DstOffset;
+	u32 Size;
+};
+
+struct ArchetypeEdge
+{
+	Archetype* Target{ nullptr };
+	Vec<ColumnCopy> Copies{};
+	Vec<ColumnCopy> Clears{}; // components only the target has, SrcOffset is unused
+};
+
+struct Archetype
+{
+	CetLayout Layout{};
+	Vec<EntityBlock*> Blocks{};
+	// single component edges, filled in the first time they're taken
+	ArchetypeEdge* AddEdges[component::ComponentTypeCount]{};
+	ArchetypeEdge* RemoveEdges[component::ComponentTypeCount]{};
+	// owns the edges, changes of several components at once only go through here
+	HashMap<CetMask, ArchetypeEdge> Transitions{};
+};
+
 namespace
 {
-bool
-MatchCet(const CetMask& querySignature, const CetMask& blockSignature)
+// structural changes move rows around, so every array of the block counts as written
+void
+MarkBlockChanged(EntityBlock* block)
 {
-	return (querySignature & blockSignature) == querySignature;
+	const u32 version{ GetWriteVersion() };
+	for (ComponentID cid : block->GetComponentView()) block->ComponentVersions[cid] = version;
 }
 
-constexpr u32 MAX_DEFERRED_SPAWNS_PER_FRAME{ 8192 };
-u32 _deferredSpawnsCount{ 0 };
-Entity _deferredSpawns[MAX_DEFERRED_SPAWNS_PER_FRAME]{};
+constexpr u32 DEFERRED_SPAWNS_RESERVE{ 8192 };
 Vec<Entity> _newPhysicsEntities{};
 
 u32 currentSceneIndex;
 Vec<Scene> scenes;
 
-HashMap<CetMask, Vec<EntityBlock*>> queryToBlockMap;
-//constexpr u32 TEST_ENTITY_COUNT{ 1 }; //TODO: temporarily cause only one entity with render mesh actually has data
-//constexpr u32 TEST_BLOCK_COUNT{ 5 };
-Vec<EntityBlock*> blocks{};
-
-// NOTE: entity IDs globally unique, in format generation | index, index goes into entityData, generation is compared
-Vec<EntityData> _entityDatas{};
-// Vec<EntityData> _disabledEntitiesDatas{};
-Vec<bool> _isEntityEnabled{}; // TODO: idk yet
-Deque<u32> _freeEntityIDs; // TODO: recycling, also then do this when unloading the scene
-
 constexpr size_t ENTITY_BLOCK_SIZE{ 32 * 1024 }; // 64 KiB per block
 constexpr size_t ENTITY_BLOCK_ALIGNMENT{ 64 }; // 64 byte alignment
+// shared by all worlds so merged blocks can be released by the world they end up in, staging worlds allocate from other threads
 memory::SlabAllocator<ENTITY_BLOCK_SIZE, ENTITY_BLOCK_ALIGNMENT> entityBlockAllocator;
 memory::PoolAllocator<EntityBlock> entityBlockHeaderPool;
+std::mutex blockAllocatorMutex{};
+
+} // anonymous namespace
+
+struct World
+{
+	// persistent query registry: each distinct query mask keeps the list of blocks matching it,
+	// the lists are built on the first query and then maintained by CreateBlock/RemoveBlock
+	HashMap<QueryMask, Vec<EntityBlock*>> QueryToBlockMap{};
+	Vec<EntityBlock*> Blocks{};
+	// every signature that ever had a block, kept across scenes so the layouts and edges don't have to be rebuilt
+	HashMap<CetMask, Archetype> Archetypes{};
+
+	// NOTE: entity IDs unique within the world, in format generation | index, index goes into EntityDatas, generation is compared
+	Vec<EntityData> EntityDatas{};
+	// indices of destroyed entities, their EntityData already holds the id with the next generation
+	// NOTE: only reused once there are id::MIN_DELETED_ELEMENTS of them, so a generation doesn't come back around too soon
+	Deque<u32> FreeEntityIDs{};
+	// the last entity GetSingleton found for a component, checked before scanning the blocks again
+	Entity Singletons[component::ComponentTypeCount]{};
+	// only the sets of sparse components are used
+	SparseSet SparseSets[component::ComponentTypeCount]{};
+	Vec<Entity> DeferredSpawns{};
+
+	// set whenever rows are removed, no need to look for underfilled blocks otherwise
+	bool IsCompactionPending{ false };
+	u32 CompactionReleasedBlocks{ 0 };
+	u32 CompactionMovedRows{ 0 };
+
+	// only clones of the main world have these, they're put back when the clone is restored
+	transform::HierarchySnapshot* Hierarchy{ nullptr };
+#if EDITOR_BUILD
+	metadata::Snapshot* Metadata{ nullptr };
+#endif
+	// the saved bodies of a clone or the staged ones of a staging world, the main world's bodies live in the physics system
+	Vec<physics::SavedBody> Bodies{};
+
+	resources::detail::ResourceStore Resources{};
+};
+
+namespace {
+World _mainWorld{};
+thread_local World* _threadWorld{ nullptr };
+// the systems of a step look up queries and singletons from several workers, this guards QueryToBlockMap and Singletons
+// NOTE: the block lists only change outside of parallel steps (RegisterBlock/RemoveBlock assert it), so the spans stay valid
+std::shared_mutex _queryCacheMutex{};
+
+World&
+CurrentWorld()
+{
+	return _threadWorld ? *_threadWorld : _mainWorld;
+}
+
+bool
+IsMainWorld(const World& world)
+{
+	return &world == &_mainWorld;
+}
+
+// the path tracer keeps its instance list until one of these comes in
+void
+NotifyPathTraceableChanged(const World& world, Entity entity)
+{
+	if (IsMainWorld(world)) messages::PathTraceableChangedEvents().Push(entity);
+}
+
+// empties the world without releasing its blocks, they're either released or owned by another world by now
+void
+ClearWorld(World& world)
+{
+	world.Blocks.clear();
+	// keep the registered queries and archetypes, only their block lists go away with the scene
+	for (auto& [query, queryBlocks] : world.QueryToBlockMap) queryBlocks.clear();
+	for (auto& [signature, archetype] : world.Archetypes) archetype.Blocks.clear();
+	world.IsCompactionPending = false;
+	world.CompactionMovedRows = 0;
+	world.CompactionReleasedBlocks = 0;
+	world.EntityDatas.clear();
+	world.FreeEntityIDs.clear();
+	world.DeferredSpawns.clear();
+	world.Bodies.clear();
+	for (Entity& singleton : world.Singletons) singleton = Entity{ id::INVALID_ID };
+	for (SparseSet& set : world.SparseSets) set.Clear();
+}
+
+// one per job system thread
+std::unique_ptr<EntityCommandBuffer[]> _commandBuffers{};
+u32 _commandBufferCount{ 0 };
+
+// a pending component change of one entity, all the commands for the same entity are merged into one
+struct PendingMigration
+{
+	Entity Entity;
+	EntityBlock* Source;
+	CetMask Signature;
+	size_t SignatureHash;
+};
+
+struct PendingComponentData
+{
+	Entity Entity;
+	ComponentID ID;
+	const u8* Data;
+};
+
+Vec<PendingMigration> _pendingMigrations{};
+Vec<PendingComponentData> _pendingComponentData{};
+Vec<Entity> _pendingDestroys{};
+HashMap<id_t, u32> _pendingMigrationIndices{};
+
+// compaction empties the least filled blocks of an archetype into the fuller ones, a few rows per frame
+constexpr u32 COMPACTION_ROW_BUDGET{ 1024 };
+// freed slabs kept for new blocks, the rest goes back to the system once a pass is done
+constexpr u32 MAX_CACHED_FREE_SLABS{ 16 };
+
+Archetype&
+GetArchetype(World& world, const CetMask& signature)
+{
+	auto [it, isNew] { world.Archetypes.try_emplace(signature) };
+	if (isNew) it->second.Layout = GenerateCetLayout(signature);
+	return it->second;
+}
+
+Archetype&
+GetArchetype(const CetMask& signature)
+{
+	return GetArchetype(CurrentWorld(), signature);
+}
+
+ArchetypeEdge&
+GetTransition(Archetype& src, const CetMask& dstSignature)
+{
+	auto [it, isNew] { src.Transitions.try_emplace(dstSignature) };
+	ArchetypeEdge& edge{ it->second };
+	if (!isNew) return edge;
+
+	edge.Target = &GetArchetype(dstSignature);
+	const CetLayout& srcLayout{ src.Layout };
+	const CetLayout& dstLayout{ edge.Target->Layout };
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (!dstSignature.test(cid)) continue;
+		// a split component gets a copy per field array
+		for (const component::ColumnField& field : component::GetColumnFields(cid))
+		{
+			const u32 fieldOffset{ field.Offset * MAX_ENTITIES_PER_BLOCK };
+			if (srcLayout.Signature.test(cid)) edge.Copies.emplace_back(srcLayout.ComponentOffsets[cid] + fieldOffset, dstLayout.ComponentOffsets[cid] + fieldOffset, field.Size);
+			else edge.Clears.emplace_back(0u, dstLayout.ComponentOffsets[cid] + fieldOffset, field.Size);
+		}
+	}
+	return edge;
+}
+
+ArchetypeEdge&
+GetAddEdge(Archetype& src, ComponentID cid)
+{
+	if (!src.AddEdges[cid])
+	{
+		CetMask signature{ src.Layout.Signature };
+		signature.set(cid);
+		src.AddEdges[cid] = &GetTransition(src, signature);
+	}
+	return *src.AddEdges[cid];
+}
+
+ArchetypeEdge&
+GetRemoveEdge(Archetype& src, ComponentID cid)
+{
+	if (!src.RemoveEdges[cid])
+	{
+		CetMask signature{ src.Layout.Signature };
+		signature.reset(cid);
+		src.RemoveEdges[cid] = &GetTransition(src, signature);
+	}
+	return *src.RemoveEdges[cid];
+}
+
+// adds the block to the world's block list, its archetype and the query lists it matches
+void
+RegisterBlock(World& world, EntityBlock* block)
+{
+	assert(!IsRunningParallelStep());
+	for (auto& [query, queryBlocks] : world.QueryToBlockMap)
+	{
+		if (query.Matches(block->Signature)) queryBlocks.emplace_back(block);
+	}
+	block->Archetype->Blocks.emplace_back(block);
+	world.Blocks.emplace_back(block);
+}
 
 EntityBlock*
-CreateBlock(const CetLayout& layout)
+CreateBlock(Archetype& archetype)
 {
-	EntityBlock* block{ entityBlockHeaderPool.Allocate() };
-	assert(block);
+	EntityBlock* block{ nullptr };
+	{
+		std::lock_guard lock{ blockAllocatorMutex };
+		block = entityBlockHeaderPool.Allocate();
+		assert(block);
+		block->ComponentData = (u8*)entityBlockAllocator.Allocate();
+	}
+	const CetLayout& layout{ archetype.Layout };
 
 	memcpy(block->ComponentOffsets, layout.ComponentOffsets, sizeof(layout.ComponentOffsets));
 	block->Signature = layout.Signature;
 	block->Capacity = layout.Capacity;
 	block->CetSize = layout.CetSize;
 	block->EntityCount = 0;
-	block->LastEnabledIdx = MAX_ENTITIES_PER_BLOCK - 1;
+	memset(block->EnabledMask, 0, sizeof(block->EnabledMask));
+	block->Archetype = &archetype;
 
 	Vec<ComponentID> componentIDs{};
 	for (ComponentID cid = 0; cid < component::ComponentTypeCount; ++cid)
@@ -69,67 +289,147 @@ CreateBlock(const CetLayout& layout)
 	block->ComponentCount = componentCount;
 	block->ComponentIDs = new ComponentID[componentCount];
 	std::copy(componentIDs.begin(), componentIDs.end(), block->ComponentIDs);
-	block->ComponentData = (u8*)entityBlockAllocator.Allocate();
 	block->Entities = reinterpret_cast<Entity*>(block->ComponentData);
+	memset(block->ComponentVersions, 0, sizeof(block->ComponentVersions));
+	MarkBlockChanged(block);
 
-	blocks.emplace_back(std::move(block));
-	return blocks.back();
+	RegisterBlock(CurrentWorld(), block);
+	return block;
 }
 
-//TODO: defer operations on EntityBlocks to the end of the frame
 void
-AddEntity(Vec<EntityBlock*> matchingBlocks, Entity entity)
+ReleaseBlock(EntityBlock* block)
 {
-	// store in first free index of the arrays
-	EntityBlock* chosenBlock{ nullptr };
-	for (auto b : matchingBlocks)
+	std::lock_guard lock{ blockAllocatorMutex };
+	entityBlockAllocator.Deallocate(block->ComponentData);
+	entityBlockHeaderPool.Deallocate(block);
+}
+
+// an exact copy of the block for another world, the slab is copied whole so the rows, columns and versions stay the same
+EntityBlock*
+CloneBlock(const EntityBlock* src, Archetype& archetype)
+{
+	EntityBlock* block{ nullptr };
 	{
-		u16 row{ b->EntityCount };
-		if (row < b->Capacity)
-		{
-			chosenBlock = b;
-			break;
-		}
+		std::lock_guard lock{ blockAllocatorMutex };
+		block = entityBlockHeaderPool.Allocate();
+		assert(block);
+		block->ComponentData = (u8*)entityBlockAllocator.Allocate();
 	}
-	if(!chosenBlock)
+	u8* const componentData{ block->ComponentData };
+	*block = *src;
+	block->ComponentData = componentData;
+	block->Entities = reinterpret_cast<Entity*>(componentData);
+	block->Archetype = &archetype;
+	block->ComponentIDs = new ComponentID[src->ComponentCount];
+	std::copy_n(src->ComponentIDs, src->ComponentCount, block->ComponentIDs);
+	memcpy(componentData, src->ComponentData, ENTITY_BLOCK_SIZE);
+	return block;
+}
+
+void
+RemoveBlock(EntityBlock* block)
+{
+	World& world{ CurrentWorld() };
+	assert(!IsRunningParallelStep());
+	for (auto& [query, queryBlocks] : world.QueryToBlockMap)
 	{
-		assert(!matchingBlocks.empty());
-		log::Info("EntityBlock is full");
-		chosenBlock = CreateBlock(GenerateCetLayout(matchingBlocks[0]->Signature));
+		if (!query.Matches(block->Signature)) continue;
+		EntityBlock** it{ std::find(queryBlocks.begin(), queryBlocks.end(), block) };
+		assert(it != queryBlocks.end());
+		queryBlocks.erase_unordered(it);
 	}
-	assert(chosenBlock);
+	Vec<EntityBlock*>& archetypeBlocks{ block->Archetype->Blocks };
+	archetypeBlocks.erase_unordered(std::find(archetypeBlocks.begin(), archetypeBlocks.end(), block));
 
-	u16 row{ chosenBlock->EntityCount };
-	chosenBlock->Entities[row] = entity;
-	chosenBlock->EntityCount++;
+	world.Blocks.erase_unordered(std::find(world.Blocks.begin(), world.Blocks.end(), block));
+	ReleaseBlock(block);
+}
+
+u32
+GetFreeRowCount(const EntityBlock* const block)
+{
+	return block->Capacity - block->EntityCount;
+}
 
-	u32 idx{ id::Index(entity) };
-	_entityDatas.emplace_back(chosenBlock, row, id::Generation(entity), entity); // TODO: what to do here
+EntityBlock*
+GetBlockWithSpace(Archetype& archetype)
+{
+	const Vec<EntityBlock*>& archetypeBlocks{ archetype.Blocks };
+	// the newest blocks are the most likely to have space
+	for (u32 i{ (u32)archetypeBlocks.size() }; i-- > 0;)
+	{
+		if (GetFreeRowCount(archetypeBlocks[i]) != 0) return archetypeBlocks[i];
+	}
+	return CreateBlock(archetype);
+}
+
+EntityBlock*
+GetBlockWithSpace(const CetMask& signature)
+{
+	return GetBlockWithSpace(GetArchetype(signature));
+}
+
+// a recycled index with its generation advanced, or a new index past the end
+Entity
+AcquireEntityID()
+{
+	World& world{ CurrentWorld() };
+	if (world.FreeEntityIDs.size() >= id::MIN_DELETED_ELEMENTS)
+	{
+		const u32 index{ world.FreeEntityIDs.front() };
+		world.FreeEntityIDs.pop_front();
+		assert(!world.EntityDatas[index].block);
+		return world.EntityDatas[index].id;
+	}
+
+	world.EntityDatas.emplace_back();
 	//_disabledEntitiesDatas.emplace_back(); // TODO: idk yet
-	_isEntityEnabled.emplace_back(true); // TODO: idk yet
+	return Entity{ (u32)world.EntityDatas.size() - 1 };
+}
+
+// NOTE: changes from inside systems should go through an EntityCommandBuffer, these apply immediately
+void
+AddEntity(EntityBlock* block, Entity entity)
+{
+	World& world{ CurrentWorld() };
+	// store in first free index of the arrays
+	assert(block && GetFreeRowCount(block) != 0);
+	u16 row{ block->EntityCount };
+	block->Entities[row] = entity;
+	block->SetRowEnabled(row, true);
+	// blocks are recycled, so the row can still hold a removed entity's components
+	for (ComponentID cid : block->GetComponentView())
+	{
+		ClearColumnRows(cid, block->ComponentData + block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, row, 1);
+	}
+	block->EntityCount++;
+	MarkBlockChanged(block);
+
+	world.EntityDatas[id::Index(entity)] = { block, row, id::Generation(entity), entity };
 }
 
 
 void
 RemoveEntity(EntityBlock* block, Entity entity)
 {
+	World& world{ CurrentWorld() };
 	// the last entity in block moved in to fill the gap
 	// if its the last entity remove the block
 
+	world.IsCompactionPending = true;
 	const u32 lastRow{ --block->EntityCount };
 	if (lastRow == 0)
 	{
-		// delete the block
+		block->SetRowEnabled(0, false);
 		//TODO: anything more?
-		blocks.erase_unordered(std::find(blocks.begin(), blocks.end(), block));
+		RemoveBlock(block);
 		return;
 	}
 
 	const EntityData& data{ GetEntityData(entity) };
 	block->Entities[data.row] = ecs::Entity{ U32_INVALID_ID };
 
-	if (EntityHasComponent<ecs::component::Collider>(entity)) physics::DestroyPhysicsBody(entity);
-
 	if (data.row != lastRow)
 	{
 		const u32 newRow{ data.row };
@@ -141,128 +441,473 @@ RemoveEntity(EntityBlock* block, Entity entity)
 		// copy over component values
 		for (ComponentID cid : block->GetComponentView())
 		{
-			const u32 componentSize{ component::GetComponentSize(cid) };
-			const u32 oldOffset{ block->ComponentOffsets[cid] + componentSize * lastRow };
-			const u32 newOffset{ block->ComponentOffsets[cid] + componentSize * newRow };
-			memcpy(block->ComponentData + newOffset, block->ComponentData + oldOffset, componentSize);
-			memset(block->ComponentData + oldOffset, 0, component::GetComponentSize(cid));
+			u8* const column{ block->ComponentData + block->ComponentOffsets[cid] };
+			CopyColumnRows(cid, column, MAX_ENTITIES_PER_BLOCK, newRow, column, MAX_ENTITIES_PER_BLOCK, lastRow, 1);
+			ClearColumnRows(cid, column, MAX_ENTITIES_PER_BLOCK, lastRow, 1);
 		}
 
 		Entity movedEntity{ block->Entities[newRow] };
-		_entityDatas[id::Index(movedEntity)].row = newRow;
+		world.EntityDatas[id::Index(movedEntity)].row = newRow;
+		block->SetRowEnabled(newRow, block->IsRowEnabled(lastRow));
+		block->Entities[lastRow] = ecs::Entity{ U32_INVALID_ID };
+		ValidateTransform(movedEntity);
 	}
-
-	ValidateTransform(entity);
+	block->SetRowEnabled(lastRow, false);
+	MarkBlockChanged(block);
 }
 
 
 void
-MigrateEntity(EntityData& entityData, EntityBlock* oldBlock, EntityBlock* newBlock)
+MigrateEntity(EntityData& entityData, const ArchetypeEdge& edge)
 {
 	const Entity entity{ entityData.id };
+	EntityBlock* const oldBlock{ entityData.block };
+	EntityBlock* const newBlock{ GetBlockWithSpace(*edge.Target) };
 	const u16 oldRow{ entityData.row };
 	const u16 newRow{ newBlock->EntityCount };
 
-	// copy over component values
-	for (ComponentID cid : oldBlock->GetComponentView())
+	for (const ColumnCopy& copy : edge.Copies)
 	{
-		if (newBlock->Signature.test(cid))
-		{
-			const u32 componentSize{ component::GetComponentSize(cid) };
-			const u32 oldOffset{ oldBlock->ComponentOffsets[cid] + componentSize * oldRow };
-			const u32 newOffset{ newBlock->ComponentOffsets[cid] + componentSize * newRow };
-			memcpy(newBlock->ComponentData + newOffset, oldBlock->ComponentData + oldOffset, component::GetComponentSize(cid));
-			memset(oldBlock->ComponentData + oldOffset, 0, component::GetComponentSize(cid));
-		}
+		memcpy(newBlock->ComponentData + copy.DstOffset + copy.Size * newRow, oldBlock->ComponentData + copy.SrcOffset + copy.Size * oldRow, copy.Size);
 	}
+	for (const ColumnCopy& clear : edge.Clears)
+	{
+		memset(newBlock->ComponentData + clear.DstOffset + clear.Size * newRow, 0, clear.Size);
+	}
+	newBlock->SetRowEnabled(newRow, oldBlock->IsRowEnabled(oldRow));
+	// the old block is released when the entity was its last one
+	const ComponentID pathTraceable{ component::ID<component::PathTraceable> };
+	const bool wasPathTraceable{ oldBlock->Signature.test(pathTraceable) };
 
 	RemoveEntity(oldBlock, entity);
 	entityData.block = newBlock;
 	entityData.row = newRow;
 	newBlock->Entities[newRow] = entity;
 	newBlock->EntityCount++;
+	MarkBlockChanged(newBlock);
+	if (wasPathTraceable != newBlock->Signature.test(pathTraceable)) NotifyPathTraceableChanged(CurrentWorld(), entity);
 
 	ValidateTransform(entity);
+}
 
-	//TODO: to avoid updating all possible references, implement the generations finally
-	/*if (EntityHasComponent<component::WorldTransform>(entity))
+// removes the given rows (sorted ascending) by moving the last rows of the block into the holes
+void
+RemoveRows(EntityBlock* block, std::span<const u16> rows)
+{
+	World& world{ CurrentWorld() };
+	world.IsCompactionPending = true;
+	for (u32 i{ (u32)rows.size() }; i-- > 0;)
 	{
-		transform::UpdateEntityComponents(entity);
-	}*/
+		// going from the highest row, so the last row is never one of the remaining holes
+		const u16 row{ rows[i] };
+		const u16 lastRow{ --block->EntityCount };
+		if (row != lastRow)
+		{
+			for (ComponentID cid : block->GetComponentView())
+			{
+				u8* const column{ block->ComponentData + block->ComponentOffsets[cid] };
+				CopyColumnRows(cid, column, MAX_ENTITIES_PER_BLOCK, row, column, MAX_ENTITIES_PER_BLOCK, lastRow, 1);
+			}
+			const Entity movedEntity{ block->Entities[lastRow] };
+			block->Entities[row] = movedEntity;
+			block->SetRowEnabled(row, block->IsRowEnabled(lastRow));
+			world.EntityDatas[id::Index(movedEntity)].row = row;
+			ValidateTransform(movedEntity);
+		}
+		block->Entities[lastRow] = ecs::Entity{ U32_INVALID_ID };
+		block->SetRowEnabled(lastRow, false);
+	}
+
+	if (block->EntityCount == 0) RemoveBlock(block);
+	else MarkBlockChanged(block);
+}
+
+// moves a batch of entities that share the source block and the new signature,
+// every component column is copied in runs of consecutive rows instead of row by row
+void
+MigrateEntities(EntityBlock* srcBlock, const CetMask& dstSignature, std::span<const PendingMigration> migrations)
+{
+	World& world{ CurrentWorld() };
+	// rows are read now, earlier batches might have moved rows around in the source block
+	Vec<u16> rows{};
+	rows.reserve(migrations.size());
+	for (const PendingMigration& migration : migrations)
+	{
+		rows.emplace_back(world.EntityDatas[id::Index(migration.Entity)].row);
+	}
+	std::sort(rows.begin(), rows.end());
+
+	const ArchetypeEdge& edge{ GetTransition(*srcBlock->Archetype, dstSignature) };
+	const ComponentID pathTraceable{ component::ID<component::PathTraceable> };
+	const bool pathTraceableChanged{ srcBlock->Signature.test(pathTraceable) != dstSignature.test(pathTraceable) };
+	const u32 count{ (u32)rows.size() };
+	u32 moved{ 0 };
+	while (moved < count)
+	{
+		EntityBlock* dstBlock{ GetBlockWithSpace(*edge.Target) };
+		const u32 batchCount{ std::min(count - moved, GetFreeRowCount(dstBlock)) };
+		const u16 firstDstRow{ dstBlock->EntityCount };
+
+		for (const ColumnCopy& clear : edge.Clears)
+		{
+			memset(dstBlock->ComponentData + clear.DstOffset + clear.Size * firstDstRow, 0, clear.Size * batchCount);
+		}
+		for (const ColumnCopy& copy : edge.Copies)
+		{
+			u8* const dstColumn{ dstBlock->ComponentData + copy.DstOffset + copy.Size * firstDstRow };
+			const u8* const srcColumn{ srcBlock->ComponentData + copy.SrcOffset };
+			u32 runStart{ 0 };
+			while (runStart < batchCount)
+			{
+				u32 runEnd{ runStart + 1 };
+				while (runEnd < batchCount && rows[moved + runEnd] == rows[moved + runEnd - 1] + 1) ++runEnd;
+				memcpy(dstColumn + copy.Size * runStart, srcColumn + copy.Size * rows[moved + runStart], copy.Size * (runEnd - runStart));
+				runStart = runEnd;
+			}
+		}
+
+		for (u32 i{ 0 }; i < batchCount; ++i)
+		{
+			const Entity entity{ srcBlock->Entities[rows[moved + i]] };
+			const u16 dstRow{ (u16)(firstDstRow + i) };
+			dstBlock->Entities[dstRow] = entity;
+			dstBlock->SetRowEnabled(dstRow, srcBlock->IsRowEnabled(rows[moved + i]));
+			EntityData& data{ world.EntityDatas[id::Index(entity)] };
+			data.block = dstBlock;
+			data.row = dstRow;
+			if (pathTraceableChanged) NotifyPathTraceableChanged(world, entity);
+			ValidateTransform(entity);
+		}
+		dstBlock->EntityCount += (u16)batchCount;
+		MarkBlockChanged(dstBlock);
+		moved += batchCount;
+	}
+
+	RemoveRows(srcBlock, { rows.data(), rows.size() });
+}
+
+// moves count rows starting at srcRow to the end of dstBlock, both blocks share the signature
+void
+MoveRows(EntityBlock* srcBlock, u16 srcRow, EntityBlock* dstBlock, u32 count)
+{
+	World& world{ CurrentWorld() };
+	assert(srcBlock->Signature == dstBlock->Signature && GetFreeRowCount(dstBlock) >= count);
+	const u16 dstRow{ dstBlock->EntityCount };
+	for (ComponentID cid : dstBlock->GetComponentView())
+	{
+		CopyColumnRows(cid, dstBlock->ComponentData + dstBlock->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, dstRow,
+			srcBlock->ComponentData + srcBlock->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, srcRow, count);
+	}
+
+	for (u32 i{ 0 }; i < count; ++i)
+	{
+		const Entity entity{ srcBlock->Entities[srcRow + i] };
+		dstBlock->Entities[dstRow + i] = entity;
+		dstBlock->SetRowEnabled(dstRow + i, srcBlock->IsRowEnabled(srcRow + i));
+		srcBlock->Entities[srcRow + i] = ecs::Entity{ U32_INVALID_ID };
+		srcBlock->SetRowEnabled(srcRow + i, false);
+		EntityData& data{ world.EntityDatas[id::Index(entity)] };
+		data.block = dstBlock;
+		data.row = (u16)(dstRow + i);
+		ValidateTransform(entity);
+	}
+	dstBlock->EntityCount += (u16)count;
+	srcBlock->EntityCount -= (u16)count;
+	MarkBlockChanged(dstBlock);
+	MarkBlockChanged(srcBlock);
+}
+
+// empties the least filled block of the archetype into the others if they have room for all of its rows,
+// returns false if there is nothing to compact
+bool
+CompactArchetype(const Vec<EntityBlock*>& archetypeBlocks, u32& rowBudget)
+{
+	World& world{ CurrentWorld() };
+	EntityBlock* srcBlock{ nullptr };
+	u32 freeRows{ 0 };
+	for (EntityBlock* block : archetypeBlocks)
+	{
+		freeRows += GetFreeRowCount(block);
+		if (!srcBlock || block->EntityCount < srcBlock->EntityCount) srcBlock = block;
+	}
+	if (!srcBlock || freeRows - GetFreeRowCount(srcBlock) < srcBlock->EntityCount) return false;
+
+	while (srcBlock->EntityCount != 0 && rowBudget != 0)
+	{
+		// fill the fullest blocks first so they don't become the next sources
+		EntityBlock* dstBlock{ nullptr };
+		for (EntityBlock* block : archetypeBlocks)
+		{
+			if (block == srcBlock || GetFreeRowCount(block) == 0) continue;
+			if (!dstBlock || block->EntityCount > dstBlock->EntityCount) dstBlock = block;
+		}
+		assert(dstBlock);
+
+		const u32 count{ std::min({ (u32)srcBlock->EntityCount, GetFreeRowCount(dstBlock), rowBudget }) };
+		MoveRows(srcBlock, (u16)(srcBlock->EntityCount - count), dstBlock, count);
+		rowBudget -= count;
+		world.CompactionMovedRows += count;
+	}
+
+	if (srcBlock->EntityCount == 0)
+	{
+		RemoveBlock(srcBlock);
+		world.CompactionReleasedBlocks++;
+	}
+	return true;
+}
+
+// runs until the row budget is used up, the rest of the work is picked up in the next frames
+void
+CompactBlocks(u32 rowBudget)
+{
+	World& world{ CurrentWorld() };
+	if (!world.IsCompactionPending) return;
+
+	for (auto& [signature, archetype] : world.Archetypes)
+	{
+		while (rowBudget != 0 && CompactArchetype(archetype.Blocks, rowBudget)) {}
+		if (rowBudget == 0) return;
+	}
+
+	// nothing left to compact
+	world.IsCompactionPending = false;
+	{
+		std::lock_guard lock{ blockAllocatorMutex };
+		entityBlockAllocator.ReleaseFreeSlabs(MAX_CACHED_FREE_SLABS);
+	}
+	if (world.CompactionReleasedBlocks != 0)
+	{
+		const FragmentationStats stats{ GetFragmentationStats() };
+		log::Info("ECS compaction: moved %u rows, released %u blocks, %u blocks left at %.1f%% occupancy",
+			world.CompactionMovedRows, world.CompactionReleasedBlocks, stats.BlockCount, stats.Occupancy * 100.f);
+	}
+	world.CompactionMovedRows = 0;
+	world.CompactionReleasedBlocks = 0;
+}
+
+void
+WriteComponentData(Entity entity, ComponentID cid, const u8* data)
+{
+	World& world{ CurrentWorld() };
+	const EntityData& entityData{ world.EntityDatas[id::Index(entity)] };
+	EntityBlock* const block{ entityData.block };
+	if (!block->Signature.test(cid)) return; // removed again later in the frame
+	WriteComponentRow(block, cid, entityData.row, data);
+}
+
+void
+ReadCommandComponentData(const EntityCommandBuffer& buffer, const EntityCommandBuffer::Command& command, Entity entity)
+{
+	const u8* data{ buffer.GetData(command) };
+	const u8* const end{ data + command.DataSize };
+	while (data < end)
+	{
+		EntityCommandBuffer::ComponentDataHeader header{};
+		memcpy(&header, data, sizeof(header));
+		data += sizeof(header);
+		assert(header.Size == component::GetComponentSize(header.ID));
+		_pendingComponentData.emplace_back(entity, header.ID, data);
+		data += header.Size;
+	}
+}
+
+void
+InsertSparseComponents(u32 entityIndex, const CetMask& components)
+{
+	World& world{ CurrentWorld() };
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (components.test(cid)) world.SparseSets[cid].Insert(entityIndex);
+	}
 }
 
 void
 SpawnDeferredEntities()
 {
+	World& world{ CurrentWorld() };
 	//TODO: for now its just for the hierarchy, to make sure parent/children components are initialized
-	for (u32 i{ 0 }; i < _deferredSpawnsCount; ++i)
+	for (Entity entity : world.DeferredSpawns)
 	{
-		Entity entity{ _deferredSpawns[i] };
+		if (!IsEntityAlive(entity)) continue; // destroyed later in the same frame
 		ecs::transform::ValidateHierarchyForEntity(entity);
 	}
-	_deferredSpawnsCount = 0;
+	world.DeferredSpawns.clear();
+}
+
+// render items only exist for the enabled RenderMesh rows of the main world
+void
+RemoveRenderItems(World& world)
+{
+	for (EntityBlock* block : world.Blocks)
+	{
+		if (!block->Signature.test(component::ID<component::RenderMesh>)) continue;
+		const component::RenderMesh* const meshes{ block->GetComponentArray<component::RenderMesh>() };
+		for (u32 row{ block->NextEnabledRow(0) }; row < block->EntityCount; row = block->NextEnabledRow(row + 1))
+		{
+			graphics::RemoveRenderItem(meshes[row].RenderItemID);
+		}
+	}
+}
+
+void
+AddRenderItems(EntityBlock* block)
+{
+	if (!block->Signature.test(component::ID<component::RenderMesh>)) return;
+	component::RenderMesh* const meshes{ block->GetComponentArray<component::RenderMesh>() };
+	const component::RenderMaterial* const materials{ block->GetComponentArray<component::RenderMaterial>() };
+	for (u32 row{ block->NextEnabledRow(0) }; row < block->EntityCount; row = block->NextEnabledRow(row + 1))
+	{
+		meshes[row].RenderItemID = graphics::AddRenderItem(block->Entities[row], meshes[row].MeshID, materials[row].MaterialCount, materials[row].MaterialID);
+	}
+}
+
+void
+AddRenderItems(World& world)
+{
+	for (EntityBlock* block : world.Blocks) AddRenderItems(block);
+}
+
+// the light set only knows the main world's lights, their LightDataIndex points into it
+void
+AddLights(World& world)
+{
+	using graphics::light::LightType;
+	const u32 lightSet{ graphics::light::GetCurrentLightSetKey() };
+	graphics::light::ClearLights(lightSet);
+	for (EntityBlock* block : world.Blocks)
+	{
+		const CetMask& signature{ block->Signature };
+		if (!signature.test(component::ID<component::Light>)) continue;
+		LightType::Type type{ LightType::Count };
+		if (signature.test(component::ID<component::DirectionalLight>)) type = LightType::Directional;
+		else if (signature.test(component::ID<component::PointLight>)) type = LightType::Point;
+		else if (signature.test(component::ID<component::SpotLight>)) type = LightType::Spot;
+		if (type == LightType::Count) continue;
+
+		for (u32 row{ 0 }; row < block->EntityCount; ++row)
+		{
+			graphics::light::AddLightToLightSet(lightSet, block->Entities[row], type);
+		}
+	}
 }
 
 } // anonymous namespace
 
-Vec<EntityBlock*>
-GetBlocksFromCet(const CetMask& querySignature)
+std::span<EntityBlock* const>
+GetBlocksFromCet(const QueryMask& query)
 {
-	//TODO: caching has to be updated, also just better query mechanism overall is needed
-	//auto it = queryToBlockMap.find(querySignature);
-	//if (it != queryToBlockMap.end())
-	//{
-	//	return it->second;
-	//}
+	World& world{ CurrentWorld() };
+	{
+		std::shared_lock lock{ _queryCacheMutex };
+		auto it{ world.QueryToBlockMap.find(query) };
+		if (it != world.QueryToBlockMap.end()) return { it->second.data(), it->second.size() };
+	}
 
-	// Build the list if not cached
-	Vec<EntityBlock*> result;
-	for (auto block : blocks)
+	// first time seeing this query, from now on the list is kept up to date when blocks are created or removed
+	// NOTE: the map's nodes don't move on a rehash, so the spans other threads hold stay valid
+	std::unique_lock lock{ _queryCacheMutex };
+	auto [it, isNew] { world.QueryToBlockMap.try_emplace(query) };
+	Vec<EntityBlock*>& result{ it->second };
+	if (isNew)
 	{
-		if ((block->Signature & querySignature) == querySignature && block->EntityCount > 0)
+		for (EntityBlock* block : world.Blocks)
 		{
-			result.push_back(block);
+			if (query.Matches(block->Signature)) result.emplace_back(block);
 		}
 	}
-	queryToBlockMap[querySignature] = result;
-	return queryToBlockMap[querySignature];
+	return { result.data(), result.size() };
 }
 
 EntityData&
 GetEntityData(Entity id)
 {
+	World& world{ CurrentWorld() };
 	assert(IsEntityAlive(id));
 	u32 entityIdx{ id::Index(id) };
-	assert(entityIdx < _entityDatas.size());
-	return _entityDatas[entityIdx];
+	assert(entityIdx < world.EntityDatas.size());
+	return world.EntityDatas[entityIdx];
 }
 const Vec<EntityData>& GetAllEntityData()
 {
-	return _entityDatas;
+	return CurrentWorld().EntityDatas;
 }
 
 EntityData&
 CreateEntity(const CetMask& signature)
 {
-	Vec<EntityBlock*> matchingBlocks{};
-	for (EntityBlock* b : blocks)
+	World& world{ CurrentWorld() };
+	const Entity entity{ AcquireEntityID() };
+	const CetMask& sparseMask{ component::GetSparseMask() };
+	AddEntity(GetBlockWithSpace(signature & ~sparseMask), entity);
+	if ((signature & sparseMask).any()) InsertSparseComponents(id::Index(entity), signature & sparseMask);
+	if (signature.test(component::ID<component::PathTraceable>)) NotifyPathTraceableChanged(world, entity);
+	return world.EntityDatas[id::Index(entity)];
+}
+
+void
+CreateEntities(const CetMask& signature, u32 count, Vec<BlockRange>& outRanges)
+{
+	World& world{ CurrentWorld() };
+	const u32 recycledCount{ world.FreeEntityIDs.size() >= id::MIN_DELETED_ELEMENTS ? std::min(count, (u32)world.FreeEntityIDs.size()) : 0u };
+	world.EntityDatas.reserve(world.EntityDatas.size() + count - recycledCount);
+	const CetMask sparseComponents{ signature & component::GetSparseMask() };
+	const bool isPathTraceable{ signature.test(component::ID<component::PathTraceable>) };
+	Archetype& archetype{ GetArchetype(signature & ~component::GetSparseMask()) };
+
+	u32 created{ 0 };
+	while (created < count)
 	{
-		if (signature == b->Signature) // match the whole signature not just a part of it
+		EntityBlock* const block{ GetBlockWithSpace(archetype) };
+		const u16 firstRow{ block->EntityCount };
+		const u16 rangeCount{ (u16)std::min(count - created, GetFreeRowCount(block)) };
+
+		for (u16 i{ 0 }; i < rangeCount; ++i)
 		{
-			matchingBlocks.emplace_back(b);
+			const Entity entity{ AcquireEntityID() };
+			block->Entities[firstRow + i] = entity;
+			block->SetRowEnabled(firstRow + i, true);
+			world.EntityDatas[id::Index(entity)] = { block, (u16)(firstRow + i), id::Generation(entity), entity };
+			if (sparseComponents.any()) InsertSparseComponents(id::Index(entity), sparseComponents);
+			if (isPathTraceable) NotifyPathTraceableChanged(world, entity);
+		}
+		// new rows start zeroed, one memset per column
+		for (ComponentID cid : block->GetComponentView())
+		{
+			ClearColumnRows(cid, block->ComponentData + block->ComponentOffsets[cid], MAX_ENTITIES_PER_BLOCK, firstRow, rangeCount);
 		}
-	}
-	if (matchingBlocks.empty())
-	{
-		// if no matching block found, create a new one
-		CetLayout layout{ GenerateCetLayout(signature) };
 
-		EntityBlock* b{ CreateBlock(layout) };
-		matchingBlocks.emplace_back(b);
+		block->EntityCount += rangeCount;
+		MarkBlockChanged(block);
+		outRanges.emplace_back(block, firstRow, rangeCount);
+		created += rangeCount;
 	}
+}
 
-	AddEntity(matchingBlocks, Entity{ (u32)_entityDatas.size() }); // create a new entity with the next ID
-	return _entityDatas.back();
+FragmentationStats
+GetFragmentationStats()
+{
+	World& world{ CurrentWorld() };
+	FragmentationStats stats{};
+	for (const auto& [signature, archetype] : world.Archetypes)
+	{
+		const Vec<EntityBlock*>& archetypeBlocks{ archetype.Blocks };
+		if (archetypeBlocks.empty()) continue;
+		u32 usedRows{ 0 };
+		for (const EntityBlock* block : archetypeBlocks)
+		{
+			usedRows += MAX_ENTITIES_PER_BLOCK - GetFreeRowCount(block);
+		}
+		const u32 blockCount{ (u32)archetypeBlocks.size() };
+		const u32 minBlockCount{ std::max((usedRows + MAX_ENTITIES_PER_BLOCK - 1) / MAX_ENTITIES_PER_BLOCK, 1u) };
+		stats.ArchetypeCount++;
+		stats.BlockCount += blockCount;
+		stats.UsedRows += usedRows;
+		stats.ReclaimableBlocks += blockCount - std::min(blockCount, minBlockCount);
+	}
+	stats.CachedFreeSlabs = entityBlockAllocator.FreeSlabCount();
+	stats.Occupancy = stats.BlockCount ? (f32)stats.UsedRows / (f32)(stats.BlockCount * MAX_ENTITIES_PER_BLOCK) : 1.f;
+	return stats;
 }
 
 const Scene& 
@@ -291,6 +936,7 @@ GenerateCetLayout(const CetMask& cetMask)
 	{
 		if (layout.Signature.test(componentID))
 		{
+			// a split component's column is its field arrays one after another, see CopyColumnRows
 			layout.ComponentOffsets[componentID] = currentOffset;
 			currentOffset += component::GetComponentSize(componentID) * MAX_ENTITIES_PER_BLOCK;
 		}
@@ -332,53 +978,52 @@ GenerateCetLayout(const CetMask& cetMask)
 ecs::Entity 
 GetSingleton(ecs::ComponentID withComponent)
 {
+	World& world{ CurrentWorld() };
+	assert(withComponent < component::ComponentTypeCount);
+	{
+		std::shared_lock lock{ _queryCacheMutex };
+		const Entity cached{ world.Singletons[withComponent] };
+		if (IsEntityAlive(cached) && GetEntityData(cached).block->Signature.test(withComponent)) return cached;
+	}
+
+	// only scan the blocks when the cached entity went away or lost the component
 	CetMask cetMask{};
 	cetMask.set(withComponent);
-	Vec<EntityBlock*> blocks{ GetBlocksFromCet(cetMask) };
-	assert(blocks.size() == 1);
-	return blocks[0]->Entities[0];
+	Entity found{ id::INVALID_ID };
+	for (EntityBlock* block : GetBlocksFromCet(cetMask))
+	{
+		if (block->EntityCount == 0) continue;
+		assert(!id::IsValid(found) && block->EntityCount == 1);
+		found = block->Entities[0];
+	}
+	assert(id::IsValid(found));
+	std::unique_lock lock{ _queryCacheMutex };
+	world.Singletons[withComponent] = found;
+	return found;
 }
 
 void
 AddComponents(EntityData& data, const CetMask& newSignature, EntityBlock* oldBlock)
 {
-	for (EntityBlock* b : blocks)
-	{
-		if (newSignature == b->Signature && b->EntityCount < b->Capacity) // match the whole signature not just a part of it
-		{
-			// move entity
-			//TODO: IMPLEMENT THIS
-			MigrateEntity(data, oldBlock, b);
-			return;
-		}
-	}
-
-	// if no matching block found, create a new one
-	EntityBlock* newBlock{ CreateBlock(GenerateCetLayout(newSignature)) };
-	Vec<EntityBlock*> b{};
-	b.emplace_back(newBlock);
-	MigrateEntity(data, oldBlock, newBlock);
+	MigrateEntity(data, GetTransition(*oldBlock->Archetype, newSignature));
 }
 
 void
 RemoveComponents(EntityData& data, const CetMask& newSignature, EntityBlock* oldBlock)
 {
-	for (EntityBlock* b : blocks)
-	{
-		if (newSignature == b->Signature && b->EntityCount < b->Capacity) // match the whole signature not just a part of it
-		{
-			// move entity
-			//TODO: IMPLEMENT THIS
-			MigrateEntity(data, oldBlock, b);
-			return;
-		}
-	}
+	MigrateEntity(data, GetTransition(*oldBlock->Archetype, newSignature));
+}
+
+void
+AddComponent(EntityData& data, ComponentID cid)
+{
+	MigrateEntity(data, GetAddEdge(*data.block->Archetype, cid));
+}
 
-	// if no matching block found, create a new one
-	EntityBlock* newBlock{ CreateBlock(GenerateCetLayout(newSignature)) };
-	Vec<EntityBlock*> b{};
-	b.emplace_back(newBlock);
-	MigrateEntity(data, oldBlock, newBlock);
+void
+RemoveComponent(EntityData& data, ComponentID cid)
+{
+	MigrateEntity(data, GetRemoveEdge(*data.block->Archetype, cid));
 }
 
 //template<IsComponent C>
@@ -421,187 +1066,235 @@ RemoveComponents(EntityData& data, const CetMask& newSignature, EntityBlock* old
 //	//data.row = 0;
 //}
 
-void
-FillTestData()
-{
-	// create 5 entities with LocalTransforms
-	//constexpr u32 TEST_BLOCK_COUNT{ 5 };
-	//for (u32 j{ 0 }; j < TEST_BLOCK_COUNT; ++j)
-	//{
-	//	CetLayout layout{};
-	//	layout.Capacity = MAX_ENTITIES_PER_BLOCK;
-	//	if (j == 0)
-	//	{
-	//		layout = GenerateCetLayout(GetCetMask<component::LocalTransform, component::WorldTransform>());
-	//	}
-	//	else if (j == 1)
-	//	{
-	//		//layout = GenerateCetLayout(GetCetMask<component::LocalTransform, component::WorldTransform, component::RenderMesh, component::RenderMaterial>());
-	//		layout = GenerateCetLayout(GetCetMask<component::LocalTransform, component::WorldTransform>());
-	//	}
-	//	else if (j == 2)
-	//	{
-	//		layout = GenerateCetLayout(GetCetMask<component::LocalTransform, component::Parent>());
-	//	}
-	//	else if (j == 3)
-	//	{
-	//		layout = GenerateCetLayout(GetCetMask<component::LocalTransform, component::Parent, component::TestComponent4>());
-	//	}
-	//	else
-	//	{
-	//		layout = GenerateCetLayout(GetCetMask<component::LocalTransform>());
-	//	}
-
-	//	EntityBlock* block{ CreateBlock(layout) };
-	//	
-	//	for (u32 i{ 0 }; i < 1; ++i)
-	//	{
-	//		Entity newId{ (u32)entityData.size()};
-	//		Entity newEntity{ newId };
-
-	//		AddEntity(block, newEntity);
-	//	}
-	//}
-
-	//Entity testEntity{ 0 };
-	//AddComponent<component::RenderMesh>(testEntity);
-	//AddComponents<component::WorldTransform, component::RenderMesh, component::RenderMaterial>(testEntity);
-}
-
-void 
-SerializeTest()
-{
-	
-}
-
 bool
 IsEntityAlive(Entity id)
 {
+	World& world{ CurrentWorld() };
 	// if the generation doesn't match, the entity had to die/never exist
-	return id::IsValid(id) && id::Generation(_entityDatas[id::Index(id)].id) == id::Generation(id);
+	if (!id::IsValid(id) || id::Index(id) >= world.EntityDatas.size()) return false;
+	const EntityData& data{ world.EntityDatas[id::Index(id)] };
+	// dead entities keep their index with the next generation, the block tells them apart until the index is reused
+	return data.block && data.id == id;
 }
 
 bool
 IsEntityEnabledIn(Entity entity)
 {
-	return _isEntityEnabled[id::Index(entity)];
+	const EntityData& data{ GetEntityData(entity) };
+	return data.block->IsRowEnabled(data.row);
 }
 
 void 
 EnableEntityIn(Entity entity)
 {
-	EntityData& data{ _entityDatas[id::Index(entity)] };
+	World& world{ CurrentWorld() };
+	EntityData& data{ world.EntityDatas[id::Index(entity)] };
 	EntityBlock* const block{ data.block };
-	// move the entity to the last existing entity index
-	const u16 oldRow{ data.row };
-	const u16 newRow{ block->EntityCount };
-
-	if (oldRow != newRow)
-	{
-		assert(!id::IsValid(block->Entities[newRow]));
-		for (ComponentID cid : block->GetComponentView())
-		{
-			const u32 componentSize{ component::GetComponentSize(cid) };
-			const u32 oldOffset{ block->ComponentOffsets[cid] + componentSize * oldRow };
-			const u32 newOffset{ block->ComponentOffsets[cid] + componentSize * newRow };
-			memcpy(block->ComponentData + newOffset, block->ComponentData + oldOffset, component::GetComponentSize(cid));
-			memset(block->ComponentData + oldOffset, 0, component::GetComponentSize(cid));
-		}
-		data.row = newRow;
-		block->Entities[newRow] = entity;
-	}
+	if (block->IsRowEnabled(data.row)) return;
 
 	// remove from cache; not very elegant here might want to do sth
-	if (EntityHasComponent<component::RenderMesh>(entity))
+	if (IsMainWorld(world) && EntityHasComponent<component::RenderMesh>(entity))
 	{
 		ecs::component::RenderMesh& mesh{ GetEntityComponent<component::RenderMesh>(entity) };
 		const ecs::component::RenderMaterial& mat{ GetEntityComponent<component::RenderMaterial>(entity) };
 		mesh.RenderItemID = graphics::AddRenderItem(entity, mesh.MeshID, mat.MaterialCount, mat.MaterialID);
 	}
 
-	block->LastEnabledIdx++;
-	block->EntityCount++;
-	assert(block->LastEnabledIdx < MAX_ENTITIES_PER_BLOCK);
-	_isEntityEnabled[id::Index(entity)] = true;
+	// the row stays where it is, queries skip it based on the bit
+	block->SetRowEnabled(data.row, true);
+	// Changed<C> queries didn't see the entity while it was disabled
+	MarkBlockChanged(block);
 }
 
 void 
 DisableEntityIn(Entity entity)
 {
-	EntityData& data{ _entityDatas[id::Index(entity)] };
+	World& world{ CurrentWorld() };
+	EntityData& data{ world.EntityDatas[id::Index(entity)] };
 	EntityBlock* const block{ data.block };
-	// move the entity to the end of the block
-	const u16 oldRow{ data.row };
-	const u16 newRow{ block->LastEnabledIdx };
-	const u16 lastEntityRow{ block->EntityCount - 1u };
+	if (!block->IsRowEnabled(data.row)) return;
 
 	// remove from cache; not very elegant here might want to do sth
-	if (EntityHasComponent<component::RenderMesh>(entity))
+	if (IsMainWorld(world) && EntityHasComponent<component::RenderMesh>(entity))
 		graphics::RemoveRenderItem(GetEntityComponent<component::RenderMesh>(entity).RenderItemID);
 
-	if (oldRow < lastEntityRow)
+	block->SetRowEnabled(data.row, false);
+	//_disabledEntitiesDatas.emplace_back(data);
+}
+
+void
+RemoveEntity(Entity entity)
+{
+	World& world{ CurrentWorld() };
+	assert(IsEntityAlive(entity));
+	EntityData& data{ GetEntityData(entity) };
+	// staging worlds don't have bodies or a hierarchy, their ids would hit main world entities
+	const bool isMainWorld{ IsMainWorld(world) };
+	if (isMainWorld && EntityHasComponent<ecs::component::Collider>(entity)) physics::DestroyPhysicsBody(entity);
+	if (isMainWorld && EntityHasComponent<ecs::component::WorldTransform>(entity)) transform::RemoveEntityFromHierarchy(entity);
+	if (EntityHasComponent<ecs::component::PathTraceable>(entity)) NotifyPathTraceableChanged(world, entity);
+
+	RemoveEntity(data.block, entity);
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
 	{
-		// swap component values
-		const u32 componentBufferSize{ ecs::component::GET_BIGGEST_COMPONENT_SIZE };
-		u8* componentTempBuffer{ (u8*)_alloca(componentBufferSize) };
+		if (component::IsSparseComponent(cid)) world.SparseSets[cid].Erase(id::Index(entity));
+	}
+#if EDITOR_BUILD
+	if (isMainWorld) metadata::RemoveEntity(entity);
+#endif
+
+	id_t nextID{ entity };
+	id::AdvanceGeneration(nextID);
+	data.block = nullptr;
+	data.id = Entity{ nextID };
+	data.generation = id::Generation(nextID);
+	world.FreeEntityIDs.push_back(id::Index(entity));
+}
 
-		for (ComponentID cid : block->GetComponentView())
+const SparseSet&
+GetSparseSet(ComponentID cid)
+{
+	assert(component::IsSparseComponent(cid));
+	return CurrentWorld().SparseSets[cid];
+}
+
+void
+AddSparseComponents(Entity entity, const CetMask& components)
+{
+	assert(IsEntityAlive(entity) && (components & ~component::GetSparseMask()).none());
+	InsertSparseComponents(id::Index(entity), components);
+}
+
+void
+RemoveSparseComponents(Entity entity, const CetMask& components)
+{
+	World& world{ CurrentWorld() };
+	assert(IsEntityAlive(entity) && (components & ~component::GetSparseMask()).none());
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (components.test(cid)) world.SparseSets[cid].Erase(id::Index(entity));
+	}
+}
+
+EntityCommandBuffer&
+GetThreadCommandBuffer()
+{
+	const u32 threadIndex{ jobs::GetThreadIndex() };
+	assert(threadIndex < _commandBufferCount);
+	return _commandBuffers[threadIndex];
+}
+
+void
+PlaybackCommandBuffers()
+{
+	// spawns are applied right away, component changes are merged per entity and destroys go last
+	for (u32 i{ 0 }; i < _commandBufferCount; ++i)
+	{
+		const EntityCommandBuffer& buffer{ _commandBuffers[i] };
+		for (const EntityCommandBuffer::Command& command : buffer.GetCommands())
 		{
-			const u32 componentSize{ component::GetComponentSize(cid) };
-			const u32 e1Offset{ block->ComponentOffsets[cid] + componentSize * oldRow };
-			const u32 e2Offset{ block->ComponentOffsets[cid] + componentSize * lastEntityRow };
-			const u32 disabledOffset{ block->ComponentOffsets[cid] + componentSize * newRow };
-			memcpy(componentTempBuffer, block->ComponentData + e1Offset, component::GetComponentSize(cid));
-			memcpy(block->ComponentData + e1Offset, block->ComponentData + e2Offset, component::GetComponentSize(cid));
-			memcpy(block->ComponentData + disabledOffset, componentTempBuffer, component::GetComponentSize(cid));
-			memset(block->ComponentData + e2Offset, 0, component::GetComponentSize(cid));
+			switch (command.Type)
+			{
+			case EntityCommandBuffer::CommandType::Spawn:
+			{
+				const Entity entity{ CreateEntity(command.Signature).id };
+				ReadCommandComponentData(buffer, command, entity);
+				ValidateTransform(entity);
+				break;
+			}
+			case EntityCommandBuffer::CommandType::Destroy:
+				_pendingDestroys.emplace_back(command.Target);
+				break;
+			case EntityCommandBuffer::CommandType::AddComponents:
+			case EntityCommandBuffer::CommandType::RemoveComponents:
+			{
+				if (!IsEntityAlive(command.Target)) break;
+				// sparse components don't move the entity, they're applied in order right away
+				const CetMask sparseComponents{ command.Signature & component::GetSparseMask() };
+				if (sparseComponents.any())
+				{
+					if (command.Type == EntityCommandBuffer::CommandType::AddComponents) AddSparseComponents(command.Target, sparseComponents);
+					else RemoveSparseComponents(command.Target, sparseComponents);
+					if (sparseComponents == command.Signature) break;
+				}
+
+				auto [it, isNew] { _pendingMigrationIndices.try_emplace(id::Index(command.Target), (u32)_pendingMigrations.size()) };
+				if (isNew)
+				{
+					EntityBlock* const block{ GetEntityData(command.Target).block };
+					_pendingMigrations.emplace_back(command.Target, block, block->Signature, 0);
+				}
+				PendingMigration& migration{ _pendingMigrations[it->second] };
+				if (command.Type == EntityCommandBuffer::CommandType::AddComponents)
+				{
+					migration.Signature |= command.Signature & ~sparseComponents;
+					ReadCommandComponentData(buffer, command, command.Target);
+				}
+				else
+				{
+					migration.Signature &= ~command.Signature;
+				}
+				break;
+			}
+			}
 		}
-		ecs::Entity swappedEntity{ block->Entities[lastEntityRow] };
-		_entityDatas[id::Index(swappedEntity)].row = oldRow;
-		block->Entities[oldRow] = swappedEntity;
-		block->Entities[lastEntityRow] = ecs::Entity{ U32_INVALID_ID };
 	}
-	else
+
+	if (!_pendingMigrations.empty())
 	{
-		// the entity is last so don't need to swap, just move to disabled
-		for (ComponentID cid : block->GetComponentView())
+		for (PendingMigration& migration : _pendingMigrations)
+		{
+			migration.SignatureHash = std::hash<CetMask>{}(migration.Signature);
+		}
+		std::sort(_pendingMigrations.begin(), _pendingMigrations.end(), [](const PendingMigration& a, const PendingMigration& b) {
+			return a.Source != b.Source ? a.Source < b.Source : a.SignatureHash < b.SignatureHash;
+			});
+
+		u32 groupStart{ 0 };
+		const u32 migrationCount{ (u32)_pendingMigrations.size() };
+		while (groupStart < migrationCount)
 		{
-			const u32 componentSize{ component::GetComponentSize(cid) };
-			const u32 oldOffset{ block->ComponentOffsets[cid] + componentSize * oldRow };
-			const u32 newOffset{ block->ComponentOffsets[cid] + componentSize * newRow };
-			memcpy(block->ComponentData + newOffset, block->ComponentData + oldOffset, component::GetComponentSize(cid));
-			memset(block->ComponentData + oldOffset, 0, component::GetComponentSize(cid));
+			const PendingMigration& first{ _pendingMigrations[groupStart] };
+			u32 groupEnd{ groupStart + 1 };
+			while (groupEnd < migrationCount && _pendingMigrations[groupEnd].Source == first.Source
+				&& _pendingMigrations[groupEnd].Signature == first.Signature) ++groupEnd;
+
+			if (first.Signature != first.Source->Signature)
+			{
+				MigrateEntities(first.Source, first.Signature, { _pendingMigrations.data() + groupStart, groupEnd - groupStart });
+			}
+			groupStart = groupEnd;
 		}
-		block->Entities[oldRow] = ecs::Entity{ U32_INVALID_ID };
 	}
 
-	data.row = newRow;
-	block->Entities[newRow] = entity;
-	assert(block->LastEnabledIdx > 0);
-	block->LastEnabledIdx--;
-	block->EntityCount--;
-	//_disabledEntitiesDatas.emplace_back(data);
-	_isEntityEnabled[id::Index(entity)] = false;
-}
+	// component values go in once every entity is in its final block
+	for (const PendingComponentData& data : _pendingComponentData)
+	{
+		if (IsEntityAlive(data.Entity)) WriteComponentData(data.Entity, data.ID, data.Data);
+	}
 
-void
-RemoveEntity(Entity entity)
-{
-	TODO_("call the one with block");
-	assert(IsEntityAlive(entity));
-	u32 entityIdx{ id::Index(entity) };
-	//TODO:
+	for (Entity entity : _pendingDestroys)
+	{
+		if (IsEntityAlive(entity)) RemoveEntity(entity);
+	}
+
+	_pendingMigrations.clear();
+	_pendingComponentData.clear();
+	_pendingDestroys.clear();
+	_pendingMigrationIndices.clear();
+	for (u32 i{ 0 }; i < _commandBufferCount; ++i) _commandBuffers[i].Clear();
 }
 
 void 
 UnloadScene()
 {
+	assert(IsMainWorld());
 	transform::DeleteHierarchy();
-	for (EntityBlock* b : blocks) delete b;
-	blocks.clear();
-	_entityDatas.clear();
-	//_disabledEntityDatas.clear();
-	_isEntityEnabled.clear();
+#if EDITOR_BUILD
+	metadata::Clear();
+#endif
+	for (EntityBlock* b : _mainWorld.Blocks) ReleaseBlock(b);
+	ClearWorld(_mainWorld);
 	//TODO: for now its just an incremental id
 	scenes.emplace_back(Scene{ (u32)scenes.size() });
 	currentSceneIndex = (u32)scenes.size() - 1;
@@ -610,31 +1303,236 @@ UnloadScene()
 void 
 ValidateTransform(Entity entity)
 {
-	_deferredSpawns[_deferredSpawnsCount++] = entity;
+	World& world{ CurrentWorld() };
+	world.DeferredSpawns.emplace_back(entity);
+	if (IsMainWorld(world)) transform::MarkEntityLocationChanged(entity);
+}
+
+void
+RemapEntityReferences(EntityBlock* block, u32 firstRow, u32 count, const HashMap<id_t, Entity>& remappedIDs,
+	std::span<const component::EntityReferenceField> fields)
+{
+	for (const component::EntityReferenceField& field : fields)
+	{
+		if (!block->Signature.test(field.Component)) continue;
+		assert(component::GetColumnFields(field.Component).size() == 1);
+		const u32 componentSize{ component::GetComponentSize(field.Component) };
+		u8* const column{ block->ComponentData + block->ComponentOffsets[field.Component] + field.Offset };
+		for (u32 row{ firstRow }; row < firstRow + count; ++row)
+		{
+			Entity& referenced{ *(Entity*)(column + componentSize * row) };
+			auto it{ remappedIDs.find((id_t)referenced) };
+			referenced = it != remappedIDs.end() ? it->second : Entity{ id::INVALID_ID };
+		}
+	}
+}
+
+World*
+CreateWorld()
+{
+	return new World{};
+}
+
+void
+DestroyWorld(World* world)
+{
+	assert(world && !IsMainWorld(*world) && _threadWorld != world);
+	for (EntityBlock* block : world->Blocks) ReleaseBlock(block);
+	if (world->Hierarchy) transform::DestroyHierarchySnapshot(world->Hierarchy);
+#if EDITOR_BUILD
+	if (world->Metadata) metadata::DestroySnapshot(world->Metadata);
+#endif
+	delete world;
+}
+
+void
+SetThreadWorld(World* world)
+{
+	assert(!world || !IsMainWorld(*world));
+	_threadWorld = world;
+}
+
+bool
+IsMainWorld()
+{
+	return IsMainWorld(CurrentWorld());
+}
+
+void
+StagePhysicsBody(const physics::SavedBody& body)
+{
+	World& world{ CurrentWorld() };
+	assert(!IsMainWorld(world) && EntityHasComponent<component::Collider>(body.Entity));
+	world.Bodies.emplace_back(body);
+}
+
+resources::detail::ResourceStore&
+GetResourceStore()
+{
+	return CurrentWorld().Resources;
+}
+
+void
+MergeWorld(World& staging, HashMap<id_t, Entity>& outMergedIDs)
+{
+	World& world{ CurrentWorld() };
+	assert(IsMainWorld(world) && !IsMainWorld(staging));
+	u32 stagedCount{ 0 };
+	for (const EntityBlock* block : staging.Blocks) stagedCount += block->EntityCount;
+	world.EntityDatas.reserve(world.EntityDatas.size() + stagedCount);
+	outMergedIDs.reserve(outMergedIDs.size() + stagedCount);
+
+	// the blocks keep their component data, the rows only get ids of the main world
+	for (EntityBlock* block : staging.Blocks)
+	{
+		block->Archetype = &GetArchetype(block->Signature);
+		const bool isPathTraceable{ block->Signature.test(component::ID<component::PathTraceable>) };
+		for (u16 row{ 0 }; row < block->EntityCount; ++row)
+		{
+			const Entity entity{ AcquireEntityID() };
+			outMergedIDs.emplace((id_t)block->Entities[row], entity);
+			block->Entities[row] = entity;
+			world.EntityDatas[id::Index(entity)] = { block, row, id::Generation(entity), entity };
+			if (isPathTraceable) NotifyPathTraceableChanged(world, entity);
+		}
+		RegisterBlock(world, block);
+		MarkBlockChanged(block);
+	}
+
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (!component::IsSparseComponent(cid)) continue;
+		for (u32 index : staging.SparseSets[cid].GetIndices())
+		{
+			world.SparseSets[cid].Insert(id::Index(outMergedIDs[(id_t)staging.EntityDatas[index].id]));
+		}
+	}
+
+	for (EntityBlock* block : staging.Blocks)
+	{
+		RemapEntityReferences(block, 0, block->EntityCount, outMergedIDs);
+		// a staging world has no render items, its RenderMesh rows still hold the invalid id they were spawned with
+		AddRenderItems(block);
+		if (!block->Signature.test(component::ID<component::WorldTransform>)) continue;
+		for (u16 row{ 0 }; row < block->EntityCount; ++row) world.DeferredSpawns.emplace_back(block->Entities[row]);
+	}
+
+	// nor bodies, the staged ones are created for the merged entities
+	Vec<physics::SavedBody> bodies{};
+	bodies.reserve(staging.Bodies.size());
+	for (const physics::SavedBody& body : staging.Bodies)
+	{
+		auto it{ outMergedIDs.find((id_t)body.Entity) };
+		// destroyed in the staging world before the merge
+		if (it == outMergedIDs.end()) continue;
+		bodies.emplace_back(physics::SavedBody{ it->second, body.Shape, body.IsStatic });
+	}
+	if (!bodies.empty()) physics::CreatePhysicsBodies(bodies);
+
+	// partially filled staging blocks get packed together with the main world's ones
+	world.IsCompactionPending = true;
+	ClearWorld(staging);
+}
+
+World*
+CloneMainWorld()
+{
+	assert(IsMainWorld());
+	World* clone{ new World{} };
+	HashMap<const EntityBlock*, EntityBlock*> clonedBlocks{};
+	clonedBlocks.reserve(_mainWorld.Blocks.size());
+
+	// registering the queries first so RegisterBlock fills their lists
+	for (const auto& [query, queryBlocks] : _mainWorld.QueryToBlockMap) clone->QueryToBlockMap.try_emplace(query);
+	for (const EntityBlock* block : _mainWorld.Blocks)
+	{
+		auto [it, isNew] { clone->Archetypes.try_emplace(block->Signature) };
+		if (isNew) it->second.Layout = block->Archetype->Layout;
+		EntityBlock* const cloned{ CloneBlock(block, it->second) };
+		clonedBlocks.emplace(block, cloned);
+		RegisterBlock(*clone, cloned);
+	}
+
+	clone->EntityDatas = _mainWorld.EntityDatas;
+	for (EntityData& data : clone->EntityDatas)
+	{
+		if (data.block) data.block = clonedBlocks[data.block];
+	}
+	clone->FreeEntityIDs = _mainWorld.FreeEntityIDs;
+	memcpy(clone->Singletons, _mainWorld.Singletons, sizeof(_mainWorld.Singletons));
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid) clone->SparseSets[cid] = _mainWorld.SparseSets[cid];
+	clone->DeferredSpawns = _mainWorld.DeferredSpawns;
+	clone->IsCompactionPending = _mainWorld.IsCompactionPending;
+
+	clone->Hierarchy = transform::SaveHierarchy();
+#if EDITOR_BUILD
+	clone->Metadata = metadata::SaveSnapshot();
+#endif
+	physics::SavePhysicsBodies(clone->Bodies);
+	return clone;
+}
+
+void
+RestoreMainWorld(World* clone)
+{
+	assert(IsMainWorld() && clone && !IsMainWorld(*clone) && clone->Hierarchy);
+	// whatever was recorded for the world that's going away
+	for (u32 i{ 0 }; i < _commandBufferCount; ++i) _commandBuffers[i].Clear();
+	physics::DestroyAllPhysicsBodies();
+	RemoveRenderItems(_mainWorld);
+	for (EntityBlock* block : _mainWorld.Blocks) ReleaseBlock(block);
+
+	transform::HierarchySnapshot* const hierarchy{ std::exchange(clone->Hierarchy, nullptr) };
+#if EDITOR_BUILD
+	metadata::Snapshot* const metadata{ std::exchange(clone->Metadata, nullptr) };
+#endif
+	const Vec<physics::SavedBody> bodies{ std::move(clone->Bodies) };
+	// the frame info, main camera and light set aren't scene state, they stay with the main world
+	resources::detail::ResourceStore resources{ std::move(_mainWorld.Resources) };
+	// the archetype and query maps are node based, so the blocks' archetype pointers survive the move
+	_mainWorld = std::move(*clone);
+	_mainWorld.Resources = std::move(resources);
+	delete clone;
+
+	transform::RestoreHierarchy(hierarchy);
+#if EDITOR_BUILD
+	metadata::RestoreSnapshot(metadata);
+#endif
+	// everything is different from what the systems saw last
+	for (EntityBlock* block : _mainWorld.Blocks) MarkBlockChanged(block);
+	AddRenderItems(_mainWorld);
+	// the lights spawned or removed in the meantime changed the light set, so it's filled from the restored rows
+	AddLights(_mainWorld);
+	physics::CreatePhysicsBodies(bodies);
 }
 
 void
 Initialize()
 {
 	CreateScene("default");
+	_mainWorld.DeferredSpawns.reserve(DEFERRED_SPAWNS_RESERVE);
 
-	//TODO: bake the EntityBlocks from scene data
+	_commandBufferCount = jobs::GetThreadCount();
+	_commandBuffers = std::make_unique<EntityCommandBuffer[]>(_commandBufferCount);
 
-	//FillTestData();
+	//TODO: bake the EntityBlocks from scene data
 
 	//TestQueries();
-
-	//SerializeTest();
 }
 
 void 
 Shutdown()
 {
+	_commandBuffers.reset();
+	_commandBufferCount = 0;
 }
 
 void
 EndFrame()
 {
+	assert(IsMainWorld());
+	PlaybackCommandBuffers();
+	CompactBlocks(COMPACTION_ROW_BUDGET);
 	SpawnDeferredEntities();
 }
 
@@ -3,11 +3,16 @@
 #include "Transform.h"
 #include "ECSCore.h"
 #include "Component.h"
+#include "SparseSet.h"
+#include "QueryFilters.h"
+#include "Resources.h"
 #include "Utilities/Logger.h"
 /*
 * has an EntityManager
 */
 
+namespace mofu::physics { struct SavedBody; }
+
 namespace mofu::ecs::scene {
 
 class Scene
@@ -75,47 +80,99 @@ bool IsEntityAlive(Entity id);
 EntityData& GetEntityData(Entity id);
 const Vec<EntityData>& GetAllEntityData();
 
-Vec<EntityBlock*> GetBlocksFromCet(const CetMask& querySignature);
+// returns a non-owning view of the cached block list for the query, valid until the next structural change
+std::span<EntityBlock* const> GetBlocksFromCet(const QueryMask& query);
+inline std::span<EntityBlock* const> GetBlocksFromCet(const CetMask& querySignature) { return GetBlocksFromCet(QueryMask{ querySignature }); }
 
+// C&, or the row proxy of a split component
 template<IsComponent C>
-C&
+ColumnElement<C, true>
 GetEntityComponent(Entity id)
 {
 	//TODO: this is definitely wrong
 	assert(IsEntityAlive(id));
 	EntityData data{ GetEntityData(id) };
-	return data.block->GetComponentArray<C>()[data.row];
+	if constexpr (component::IsSparse<C>) assert(GetSparseSet(component::ID<C>).Contains(id::Index(id)));
+	return GetColumn<C>(data.block)[data.row];
 }
 
-// TODO: its a waste that singletons take up a whole block
+// for writes that don't go through a writable query, so Changed<C> filters see them
+template<IsComponent C>
+void
+MarkComponentChanged(Entity id)
+{
+	assert(IsEntityAlive(id));
+	if constexpr (!component::IsSparse<C>) GetEntityData(id).block->ComponentVersions[component::ID<C>] = GetWriteVersion();
+}
+
+template<IsComponent C>
+void
+MarkAllComponentsChanged()
+{
+	const u32 version{ GetWriteVersion() };
+	for (EntityBlock* block : GetBlocksFromCet(GetCetMask<C>()))
+	{
+		block->ComponentVersions[component::ID<C>] = version;
+	}
+}
+
+// the one entity with the component, cached after the first lookup
+// NOTE: data that doesn't need an entity should go into resources (Resources.h) instead, it doesn't take up a block
 ecs::Entity GetSingleton(ecs::ComponentID withComponent);
 
 template<IsComponent C>
 bool
 EntityHasComponent(Entity e)
 {
+	if constexpr (component::IsSparse<C>) return GetSparseSet(component::ID<C>).Contains(id::Index(e));
 	const EntityData& data{ GetEntityData(e) };
 	return data.block->Signature.test(component::ID<C>);
 }
 
+// sparse components are only added to/removed from their sets, the entity stays in its block
+void AddSparseComponents(Entity entity, const CetMask& components);
+void RemoveSparseComponents(Entity entity, const CetMask& components);
+
+// calls func(cid) for every sparse component the entity has, they don't show up in ForEachComponent
+template<typename Fun>
+void
+ForEachSparseComponent(Entity entity, Fun&& func)
+{
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (component::IsSparseComponent(cid) && GetSparseSet(cid).Contains(id::Index(entity))) func(cid);
+	}
+}
+
 void AddComponents(EntityData& data, const CetMask& newSignature, EntityBlock* oldBlock);
 void RemoveComponents(EntityData& data, const CetMask& newSignature, EntityBlock* oldBlock);
+// single component changes follow the cached edge of the entity's archetype
+void AddComponent(EntityData& data, ComponentID cid);
+void RemoveComponent(EntityData& data, ComponentID cid);
 
 template<IsComponent... C>
 void
 AddComponents(Entity entity)
 {
 	assert(IsEntityAlive(entity));
+	const CetMask sparseComponents{ GetCetMask<C...>() & component::GetSparseMask() };
+	if (sparseComponents.any())
+	{
+		AddSparseComponents(entity, sparseComponents);
+		if (sparseComponents == GetCetMask<C...>()) return;
+	}
+
 	EntityData& data{ GetEntityData(entity) };
 	EntityBlock* oldBlock{ data.block };
-	CetMask newSignature{ PreviewCetMaskPlusComponents<C...>(oldBlock->Signature) };
+	CetMask newSignature{ PreviewCetMaskPlusComponents<C...>(oldBlock->Signature) & ~component::GetSparseMask() };
 	if (newSignature == oldBlock->Signature) 
 	{ 
 		log::Info("ecs::scene::AddComponents: Entity already has these components"); 
 		return; 
 	};
 	
-	AddComponents(data, newSignature, oldBlock);
+	if constexpr (sizeof...(C) == 1) AddComponent(data, component::ID<C>...);
+	else AddComponents(data, newSignature, oldBlock);
 }
 
 template<IsComponent... C>
@@ -123,6 +180,13 @@ void
 RemoveComponents(Entity entity)
 {
 	assert(IsEntityAlive(entity));
+	const CetMask sparseComponents{ GetCetMask<C...>() & component::GetSparseMask() };
+	if (sparseComponents.any())
+	{
+		RemoveSparseComponents(entity, sparseComponents);
+		if (sparseComponents == GetCetMask<C...>()) return;
+	}
+
 	EntityData& data{ GetEntityData(entity) };
 	EntityBlock* oldBlock{ data.block };
 	CetMask newSignature{ PreviewCetMaskMinusComponents<C...>(oldBlock->Signature) };
@@ -132,7 +196,8 @@ RemoveComponents(Entity entity)
 		return;
 	};
 
-	RemoveComponents(data, newSignature, oldBlock);
+	if constexpr (sizeof...(C) == 1) RemoveComponent(data, component::ID<C>...);
+	else RemoveComponents(data, newSignature, oldBlock);
 }
 
 template<IsComponent C>
@@ -145,6 +210,31 @@ AddEntityComponent(Entity e)
 
 EntityData& CreateEntity(const CetMask& signature);
 
+// rows [FirstRow, FirstRow + Count) of Block
+struct BlockRange
+{
+	EntityBlock* Block;
+	u16 FirstRow;
+	u16 Count;
+};
+
+// creates count entities with zeroed components, filling the free rows of existing blocks before making new ones,
+// the ranges of rows that were filled are appended to outRanges
+void CreateEntities(const CetMask& signature, u32 count, Vec<BlockRange>& outRanges);
+
+// block usage over all archetypes, blocks are compacted a bit every frame in EndFrame
+struct FragmentationStats
+{
+	u32 ArchetypeCount;
+	u32 BlockCount;
+	u32 UsedRows; // enabled and disabled entities
+	u32 ReclaimableBlocks; // blocks that would be freed if every archetype was packed tightly
+	u32 CachedFreeSlabs;
+	f32 Occupancy; // used rows / block capacity
+};
+
+FragmentationStats GetFragmentationStats();
+
 template<IsComponent... C>
 EntityData& CreateEntity()
 {
@@ -152,7 +242,7 @@ EntityData& CreateEntity()
 	return CreateEntity(cetMask);
 }
 
-// returns the total count of entities where Cet includes all specified components
+// returns the total count of enabled entities where Cet includes all specified components
 template<IsComponent... C>
 u32 GetEntityCount()
 {
@@ -160,7 +250,7 @@ u32 GetEntityCount()
 	u32 count{ 0 };
 	for (EntityBlock* block : GetBlocksFromCet(cetMask))
 	{
-		count += block->EntityCount;
+		count += block->GetEnabledCount();
 	}
 	return count;
 }
@@ -172,8 +262,47 @@ void DisableEntityIn(Entity entity);
 void RemoveEntity(Entity entity);
 void UnloadScene();
 
+// a new or moved row, the entity is (re)checked against the transform hierarchy at the end of the frame
 void ValidateTransform(Entity entity);
 
+// points the entity ids stored in the rows' components at the remapped entities, ids that weren't remapped become invalid
+void RemapEntityReferences(EntityBlock* block, u32 firstRow, u32 count, const HashMap<id_t, Entity>& remappedIDs,
+	std::span<const component::EntityReferenceField> fields = component::ENTITY_REFERENCE_FIELDS);
+
+/*
+* a world owns the entities, blocks and query caches; the functions here work on the world that's current on the calling thread
+* the main world is the one that gets simulated and rendered, the transform hierarchy, physics bodies, render items
+* and editor metadata only exist for it
+* a streaming loader can fill a staging world on a background thread and move it into the main world with MergeWorld
+* NOTE: a staging world is only used by the thread that set it, the job system workers and EndFrame always work on the main world
+*/
+struct World;
+
+[[nodiscard]] World* CreateWorld();
+void DestroyWorld(World* world);
+// nullptr goes back to the main world
+void SetThreadWorld(World* world);
+[[nodiscard]] bool IsMainWorld();
+// the resources (Resources.h) of the current world
+[[nodiscard]] resources::detail::ResourceStore& GetResourceStore();
+// the body of a Collider entity of a staging world, it's created when the world is merged into the main one
+// NOTE: physics::AddStaticBody/AddDynamicBody stage the body on their own when a staging world is set
+void StagePhysicsBody(const physics::SavedBody& body);
+// moves every entity of the staging world into the main world, the blocks are handed over as they are and only get new entity ids
+// the render items of the merged RenderMesh rows and the staged bodies are created for the new ids
+// outMergedIDs maps the staging ids to the main world ones, the staging world is empty afterwards and can be reused
+// NOTE: call on the main thread at a frame boundary, the merged entities join the hierarchy in the next EndFrame
+void MergeWorld(World& staging, HashMap<id_t, Entity>& outMergedIDs);
+
+// a copy of the main world for going back to it later, e.g. when leaving play mode in the editor
+// the blocks are copied slab by slab and the hierarchy and editor metadata tables as they are, the physics bodies are saved by shape
+// NOTE: call at a frame boundary, commands that weren't played back yet aren't part of the clone
+[[nodiscard]] World* CloneMainWorld();
+// replaces the main world with the clone and frees it, the render items and physics bodies of the clone are created again
+// and its lights replace the ones in the current light set
+// NOTE: other graphics resources are not part of the clone, the main world keeps its resources (Resources.h)
+void RestoreMainWorld(World* clone);
+
 void Initialize();
 void Shutdown();
 
@@ -0,0 +1,342 @@
+#include "SceneSnapshot.h"
+#include "Scene.h"
+
+namespace mofu::ecs::snapshot {
+namespace {
+
+// the rows of a block that get saved
+struct BlockRows
+{
+	const EntityBlock* Block;
+	u64 Rows[ENABLED_MASK_WORDS]{};
+	u32 Count{ 0 };
+};
+
+void
+CollectBlockRows(std::span<const Entity> entities, Vec<BlockRows>& outBlocks)
+{
+	HashMap<const EntityBlock*, u32> blockIndices{};
+	for (Entity entity : entities)
+	{
+		const EntityData& data{ scene::GetEntityData(entity) };
+		auto [it, inserted]{ blockIndices.try_emplace(data.block, (u32)outBlocks.size()) };
+		if (inserted) outBlocks.emplace_back(BlockRows{ data.block });
+		outBlocks[it->second].Rows[data.row >> 6] |= 1ull << (data.row & 63);
+	}
+	for (BlockRows& rows : outBlocks)
+	{
+		for (u64 word : rows.Rows) rows.Count += (u32)std::popcount(word);
+	}
+}
+
+// calls func(firstRow, count) for every run of saved rows, a block that's saved whole is a single run
+template<typename Fun>
+void
+ForEachRun(const BlockRows& rows, Fun&& func)
+{
+	const u32 count{ rows.Block->EntityCount };
+	for (u32 first{ NextSetRow(rows.Rows, 0, count) }; first < count;)
+	{
+		const u32 end{ NextClearRow(rows.Rows, first, count) };
+		func(first, end - first);
+		first = NextSetRow(rows.Rows, end, count);
+	}
+}
+
+u64
+GetHeaderSize()
+{
+	return sizeof(u32) * 5 + sizeof(u32) * component::ComponentTypeCount
+		+ sizeof(u32) + sizeof(u32) * 2 * std::size(component::ENTITY_REFERENCE_FIELDS);
+}
+
+u64
+GetBlockRecordSize(const BlockRows& rows)
+{
+	const EntityBlock* const block{ rows.Block };
+	u64 size{ sizeof(u32) + sizeof(u32) * block->ComponentCount + sizeof(u32) + sizeof(Entity) * rows.Count + sizeof(u64) * ENABLED_MASK_WORDS };
+	for (ComponentID cid : block->GetComponentView()) size += (u64)component::GetComponentSize(cid) * rows.Count;
+	return size;
+}
+
+bool
+Reject(const char* reason)
+{
+	log::Warn("ReadSnapshot: %s", reason);
+	return false;
+}
+
+} // anonymous namespace
+
+bool
+ValidateSnapshot(const u8* data, u64 size, u32& outEntityCount, u64& outSnapshotSize)
+{
+	util::BlobStreamReader reader{ data };
+	// the bytes left have to hold the next record before it's read
+	const auto fits{ [&reader, size](u64 bytes) { return bytes <= size - reader.Offset(); } };
+
+	if (!fits(sizeof(u32) * 5) || reader.Read<u32>() != SNAPSHOT_MAGIC) return Reject("not a scene snapshot");
+	const u32 version{ reader.Read<u32>() };
+	const u32 componentTypeCount{ reader.Read<u32>() };
+	const u32 entityCount{ reader.Read<u32>() };
+	const u32 blockCount{ reader.Read<u32>() };
+	if (version != SNAPSHOT_VERSION || componentTypeCount != component::ComponentTypeCount)
+	{
+		log::Warn("ReadSnapshot: snapshot version %u with %u component types is out of date", version, componentTypeCount);
+		return false;
+	}
+	// the columns are copied as they are, so every component has to have the same size
+	if (!fits(sizeof(u32) * component::ComponentTypeCount + sizeof(u32))) return Reject("the component size table is cut off");
+	bool sameLayout{ true };
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		sameLayout &= reader.Read<u32>() == component::GetComponentSize(cid);
+	}
+	if (!sameLayout) return Reject("the snapshot was saved with a different component layout");
+
+	// the references are remapped with this build's table, none of its fields is in a split component
+	const u32 referenceFieldCount{ reader.Read<u32>() };
+	if (referenceFieldCount != std::size(component::ENTITY_REFERENCE_FIELDS)) return Reject("the snapshot has different entity reference fields");
+	if (!fits(sizeof(u32) * 2 * (u64)referenceFieldCount)) return Reject("the entity reference table is cut off");
+	for (const component::EntityReferenceField& field : component::ENTITY_REFERENCE_FIELDS)
+	{
+		const u32 cid{ reader.Read<u32>() };
+		const u32 offset{ reader.Read<u32>() };
+		if (cid != field.Component || offset != field.Offset) return Reject("the snapshot has different entity reference fields");
+	}
+
+	u64 rowTotal{ 0 };
+	for (u32 blockIndex{ 0 }; blockIndex < blockCount; ++blockIndex)
+	{
+		if (!fits(sizeof(u32))) return Reject("a block record is cut off");
+		const u32 componentCount{ reader.Read<u32>() };
+		if (componentCount > MAX_COMPONENT_TYPES || !fits(sizeof(u32) * ((u64)componentCount + 1))) return Reject("a block signature is cut off");
+		CetMask signature{};
+		u64 columnsSize{ 0 };
+		for (u32 i{ 0 }; i < componentCount; ++i)
+		{
+			const u32 cid{ reader.Read<u32>() };
+			if (cid >= component::ComponentTypeCount || component::IsSparseComponent((ComponentID)cid) || signature.test(cid))
+				return Reject("a block signature has an unknown, sparse or repeated component");
+			signature.set(cid);
+			columnsSize += component::GetComponentSize((ComponentID)cid);
+		}
+
+		// the enabled bits only cover one block worth of rows
+		const u32 rowCount{ reader.Read<u32>() };
+		if (rowCount > MAX_ENTITIES_PER_BLOCK) return Reject("a block record has more rows than a block");
+		columnsSize *= rowCount;
+		if (!fits(sizeof(Entity) * (u64)rowCount + sizeof(u64) * ENABLED_MASK_WORDS + columnsSize)) return Reject("a block record is cut off");
+		reader.Skip(sizeof(Entity) * (u64)rowCount + sizeof(u64) * ENABLED_MASK_WORDS + columnsSize);
+		rowTotal += rowCount;
+	}
+	if (rowTotal != entityCount) return Reject("the block records don't add up to the entity count");
+
+	if (!fits(sizeof(u32))) return Reject("the sparse tags are cut off");
+	const u32 sparseCount{ reader.Read<u32>() };
+	for (u32 i{ 0 }; i < sparseCount; ++i)
+	{
+		if (!fits(sizeof(u32) * 2)) return Reject("the sparse tags are cut off");
+		const u32 cid{ reader.Read<u32>() };
+		const u32 taggedCount{ reader.Read<u32>() };
+		if (cid >= component::ComponentTypeCount || !component::IsSparseComponent((ComponentID)cid)) return Reject("a sparse tag isn't a sparse component");
+		if (!fits(sizeof(u32) * (u64)taggedCount)) return Reject("the sparse tags are cut off");
+		for (u32 t{ 0 }; t < taggedCount; ++t)
+		{
+			if (reader.Read<u32>() >= entityCount) return Reject("a sparse tag points past the saved entities");
+		}
+	}
+
+	outEntityCount = entityCount;
+	outSnapshotSize = reader.Offset();
+	return true;
+}
+
+u64
+GetSnapshotSize(std::span<const Entity> entities)
+{
+	Vec<BlockRows> blocks{};
+	CollectBlockRows(entities, blocks);
+
+	u64 size{ GetHeaderSize() };
+	for (const BlockRows& rows : blocks) size += GetBlockRecordSize(rows);
+
+	size += sizeof(u32);
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (!component::IsSparseComponent(cid)) continue;
+		const SparseSet& set{ scene::GetSparseSet(cid) };
+		u32 count{ 0 };
+		for (Entity entity : entities) count += set.Contains(id::Index(entity));
+		size += sizeof(u32) * 2 + sizeof(u32) * count;
+	}
+	return size;
+}
+
+void
+WriteSnapshot(util::BlobStreamWriter& writer, std::span<const Entity> entities, Vec<Entity>& outEntities)
+{
+	Vec<BlockRows> blocks{};
+	CollectBlockRows(entities, blocks);
+	outEntities.clear();
+	outEntities.reserve(entities.size());
+
+	writer.Write<u32>(SNAPSHOT_MAGIC);
+	writer.Write<u32>(SNAPSHOT_VERSION);
+	writer.Write<u32>(component::ComponentTypeCount);
+	writer.Write<u32>((u32)entities.size());
+	writer.Write<u32>((u32)blocks.size());
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid) writer.Write<u32>(component::GetComponentSize(cid));
+	writer.Write<u32>((u32)std::size(component::ENTITY_REFERENCE_FIELDS));
+	for (const component::EntityReferenceField& field : component::ENTITY_REFERENCE_FIELDS)
+	{
+		writer.Write<u32>(field.Component);
+		writer.Write<u32>(field.Offset);
+	}
+
+	for (const BlockRows& rows : blocks)
+	{
+		const EntityBlock* const block{ rows.Block };
+		writer.Write<u32>(block->ComponentCount);
+		for (ComponentID cid : block->GetComponentView()) writer.Write<u32>(cid);
+		writer.Write<u32>(rows.Count);
+
+		// the saved rows are packed, so the enabled bits are re-indexed
+		u64 enabled[ENABLED_MASK_WORDS]{};
+		u32 packedRow{ 0 };
+		ForEachRun(rows, [&](u32 first, u32 count) {
+			writer.WriteBytes((const u8*)(block->Entities + first), sizeof(Entity) * count);
+			for (u32 row{ first }; row < first + count; ++row, ++packedRow)
+			{
+				outEntities.emplace_back(block->Entities[row]);
+				if (block->IsRowEnabled(row)) enabled[packedRow >> 6] |= 1ull << (packedRow & 63);
+			}
+			});
+		for (u64 word : enabled) writer.Write<u64>(word);
+
+		// a split component goes field array by field array, so the saved column is laid out like a block column of rows.Count rows
+		for (ComponentID cid : block->GetComponentView())
+		{
+			const u8* const column{ block->ComponentData + block->ComponentOffsets[cid] };
+			for (const component::ColumnField& field : component::GetColumnFields(cid))
+			{
+				const u8* const fieldArray{ column + field.Offset * MAX_ENTITIES_PER_BLOCK };
+				ForEachRun(rows, [&](u32 first, u32 count) {
+					writer.WriteBytes(fieldArray + field.Size * first, field.Size * count);
+					});
+			}
+		}
+	}
+
+	// sparse tags have no data, just the indices of the entities that have them
+	writer.Write<u32>((u32)component::GetSparseMask().count());
+	Vec<u32> tagged{};
+	for (ComponentID cid{ 0 }; cid < component::ComponentTypeCount; ++cid)
+	{
+		if (!component::IsSparseComponent(cid)) continue;
+		const SparseSet& set{ scene::GetSparseSet(cid) };
+		tagged.clear();
+		for (u32 i{ 0 }; i < outEntities.size(); ++i)
+		{
+			if (set.Contains(id::Index(outEntities[i]))) tagged.emplace_back(i);
+		}
+		writer.Write<u32>(cid);
+		writer.Write<u32>((u32)tagged.size());
+		writer.WriteVector(tagged.data(), (u32)tagged.size());
+	}
+}
+
+bool
+ReadSnapshot(util::BlobStreamReader& reader, u64 size, Vec<Entity>& outEntities)
+{
+	// everything is checked up front, a bad snapshot doesn't leave half of its entities behind
+	u32 entityCount{ 0 };
+	u64 snapshotSize{ 0 };
+	if (!ValidateSnapshot(reader.Position(), size, entityCount, snapshotSize)) return false;
+	const u8* const start{ reader.Position() };
+	reader.Skip(sizeof(u32) * 4); // magic, version, component type count and entity count
+	const u32 blockCount{ reader.Read<u32>() };
+	// the component sizes and the entity reference table, both match this build
+	reader.Skip(sizeof(u32) * component::ComponentTypeCount + sizeof(u32) + sizeof(u32) * 2 * std::size(component::ENTITY_REFERENCE_FIELDS));
+
+	outEntities.clear();
+	outEntities.reserve(entityCount);
+	HashMap<id_t, Entity> loadedEntities{};
+	loadedEntities.reserve(entityCount);
+	Vec<scene::BlockRange> ranges{};
+	ComponentID cids[MAX_COMPONENT_TYPES];
+
+	for (u32 blockIndex{ 0 }; blockIndex < blockCount; ++blockIndex)
+	{
+		CetMask signature{};
+		const u32 componentCount{ reader.Read<u32>() };
+		for (u32 i{ 0 }; i < componentCount; ++i)
+		{
+			cids[i] = (ComponentID)reader.Read<u32>();
+			signature.set(cids[i]);
+		}
+
+		const u32 rowCount{ reader.Read<u32>() };
+		const Entity* const savedEntities{ (const Entity*)reader.Position() };
+		reader.Skip(sizeof(Entity) * rowCount);
+		u64 enabled[ENABLED_MASK_WORDS];
+		for (u64& word : enabled) word = reader.Read<u64>();
+		const u8* const columns{ reader.Position() };
+
+		// the rows can end up split over several blocks if an earlier record left one with free rows
+		const u32 firstRange{ (u32)ranges.size() };
+		scene::CreateEntities(signature, rowCount, ranges);
+		u32 savedRow{ 0 };
+		for (u32 rangeIndex{ firstRange }; rangeIndex < ranges.size(); ++rangeIndex)
+		{
+			const scene::BlockRange& range{ ranges[rangeIndex] };
+			EntityBlock* const block{ range.Block };
+			const u8* column{ columns };
+			for (u32 i{ 0 }; i < componentCount; ++i)
+			{
+				CopyColumnRows(cids[i], block->ComponentData + block->ComponentOffsets[cids[i]], MAX_ENTITIES_PER_BLOCK, range.FirstRow,
+					column, rowCount, savedRow, range.Count);
+				column += component::GetComponentSize(cids[i]) * rowCount;
+			}
+
+			for (u32 i{ 0 }; i < range.Count; ++i, ++savedRow)
+			{
+				const Entity entity{ block->Entities[range.FirstRow + i] };
+				loadedEntities.emplace((id_t)savedEntities[savedRow], entity);
+				outEntities.emplace_back(entity);
+				if (!((enabled[savedRow >> 6] >> (savedRow & 63)) & 1)) block->SetRowEnabled(range.FirstRow + i, false);
+			}
+		}
+
+		u64 columnsSize{ 0 };
+		for (u32 i{ 0 }; i < componentCount; ++i) columnsSize += (u64)component::GetComponentSize(cids[i]) * rowCount;
+		reader.Skip(columnsSize);
+	}
+
+	const u32 sparseCount{ reader.Read<u32>() };
+	for (u32 i{ 0 }; i < sparseCount; ++i)
+	{
+		const ComponentID cid{ (ComponentID)reader.Read<u32>() };
+		CetMask tag{};
+		tag.set(cid);
+		const u32 taggedCount{ reader.Read<u32>() };
+		for (u32 t{ 0 }; t < taggedCount; ++t) scene::AddSparseComponents(outEntities[reader.Read<u32>()], tag);
+	}
+	assert((u64)(reader.Position() - start) == snapshotSize);
+
+	// the entity ids in the components still point at the saved entities
+	for (const scene::BlockRange& range : ranges)
+	{
+		EntityBlock* const block{ range.Block };
+		scene::RemapEntityReferences(block, range.FirstRow, range.Count, loadedEntities);
+
+		if (!block->Signature.test(component::ID<component::WorldTransform>)) continue;
+		for (u32 row{ range.FirstRow }; row < (u32)range.FirstRow + range.Count; ++row)
+		{
+			scene::ValidateTransform(block->Entities[row]);
+		}
+	}
+
+	return true;
+}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "ECSCommon.h"
+#include "Utilities/IOStream.h"
+#include <span>
+
+/*
+* binary scene snapshot, the entities are written block by block as whole column ranges so loading one is a few memcpys per block
+* layout: header, component size table, entity reference fixups, blocks (signature, entity ids, enabled bits, columns), sparse tags
+* component fields holding entity ids (parents, light owners) are listed in the fixup table and remapped to the loaded entities
+* NOTE: the component sizes are stored and checked on load, a snapshot of a different component layout is rejected
+*/
+
+namespace mofu::ecs::snapshot {
+constexpr u32 SNAPSHOT_MAGIC{ 0x504E534D }; // "MSNP"
+constexpr u32 SNAPSHOT_VERSION{ 2 }; // 2: split components are saved field array by field array
+
+// the bytes WriteSnapshot needs for these entities
+[[nodiscard]] u64 GetSnapshotSize(std::span<const Entity> entities);
+// outEntities gets the entities in the order they were written, ReadSnapshot returns the loaded ones in the same order
+void WriteSnapshot(util::BlobStreamWriter& writer, std::span<const Entity> entities, Vec<Entity>& outEntities);
+// checks every record against size without creating anything, false if it isn't a snapshot, is cut off or damaged,
+// or was saved with a different component layout; data saved after the snapshot starts at outSnapshotSize
+[[nodiscard]] bool ValidateSnapshot(const u8* data, u64 size, u32& outEntityCount, u64& outSnapshotSize);
+// creates the snapshot's entities in the current scene, false without creating any if ValidateSnapshot fails
+// size is the number of bytes readable from the reader's position
+[[nodiscard]] bool ReadSnapshot(util::BlobStreamReader& reader, u64 size, Vec<Entity>& outEntities);
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "ECSCommon.h"
+#include "ECSCore.h"
+
+/*
+* storage of sparse components (component::SparseComponent), they're kept out of the blocks so adding and removing them
+* doesn't migrate the entity; only tags for now, so a set just tracks which entity indices have the component
+*/
+
+namespace mofu::ecs {
+
+class SparseSet
+{
+public:
+	[[nodiscard]] bool Contains(u32 index) const { return index < _sparse.size() && _sparse[index] != U32_INVALID_ID; }
+
+	void Insert(u32 index)
+	{
+		if (index >= _sparse.size()) _sparse.resize(index + 1, U32_INVALID_ID);
+		if (_sparse[index] != U32_INVALID_ID) return;
+		_sparse[index] = (u32)_dense.size();
+		_dense.emplace_back(index);
+	}
+
+	void Erase(u32 index)
+	{
+		if (!Contains(index)) return;
+		// the last index takes the erased slot
+		const u32 slot{ _sparse[index] };
+		const u32 lastIndex{ _dense.back() };
+		_dense[slot] = lastIndex;
+		_sparse[lastIndex] = slot;
+		_dense.pop_back();
+		_sparse[index] = U32_INVALID_ID;
+	}
+
+	[[nodiscard]] std::span<const u32> GetIndices() const { return { _dense.data(), _dense.size() }; }
+	[[nodiscard]] u32 Size() const { return (u32)_dense.size(); }
+
+	void Clear()
+	{
+		_sparse.clear();
+		_dense.clear();
+	}
+
+private:
+	Vec<u32> _sparse{}; // entity index -> slot in _dense
+	Vec<u32> _dense{};
+};
+
+namespace scene {
+const SparseSet& GetSparseSet(ComponentID cid);
+}
+
+// the array of C in the block, sparse tags have no data so they all share one dummy column
+// a component stored field by field gives its field arrays instead (FieldSplit)
+template<IsComponent C, bool Writable = true>
+ColumnArray<C, Writable>
+GetColumn(EntityBlock* block)
+{
+	if constexpr (component::IsSparse<C>)
+	{
+		static_assert(std::is_empty_v<C>, "sparse components can only be tags for now");
+		static C tags[MAX_ENTITIES_PER_BLOCK]{};
+		return tags;
+	}
+	else if constexpr (component::IsFieldSplit<C>)
+	{
+		return block->GetComponentColumns<C, Writable>();
+	}
+	else
+	{
+		return block->GetComponentArray<C>();
+	}
+}
+
+// sets count rows of the column to value
+template<IsComponent C>
+void
+FillColumn(EntityBlock* block, u32 firstRow, u32 count, const C& value)
+{
+	if constexpr (component::IsFieldSplit<C>)
+	{
+		const ColumnArray<C, true> column{ GetColumn<C>(block) };
+		for (u32 i{ 0 }; i < count; ++i) column[firstRow + i] = value;
+	}
+	else
+	{
+		std::fill_n(GetColumn<C>(block) + firstRow, count, value);
+	}
+}
+
+// clears the bits of the rows whose entities don't have the sparse component, or the ones that do if it's excluded
+inline void
+JoinSparseSet(const EntityBlock* block, const SparseSet& set, u64* rows, bool excluded = false)
+{
+	for (u32 word{ 0 }; word < ENABLED_MASK_WORDS; ++word)
+	{
+		u64 bits{ rows[word] };
+		while (bits)
+		{
+			const u32 bit{ (u32)std::countr_zero(bits) };
+			bits &= bits - 1;
+			if (set.Contains(id::Index(block->Entities[word * 64 + bit])) == excluded) rows[word] &= ~(1ull << bit);
+		}
+	}
+}
+
+}
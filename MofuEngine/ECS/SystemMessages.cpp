@@ -3,6 +3,11 @@
 namespace mofu::ecs::messages {
 namespace {
 bool _boolMessages[SystemBoolMessage::Count]{ false };
+
+EventChannel<Entity> _transformChangedEvents{ 4096 };
+EventChannel<id_t> _renderItemAddedEvents{ 1024 };
+EventChannel<id_t> _renderItemRemovedEvents{ 1024 };
+EventChannel<Entity> _pathTraceableChangedEvents{ 1024 };
 }
 
 void
@@ -26,4 +31,37 @@ RestartFrameMessages()
 	}
 }
 
-}
\ No newline at end of file
+EventChannel<Entity>&
+TransformChangedEvents()
+{
+	return _transformChangedEvents;
+}
+
+EventChannel<id_t>&
+RenderItemAddedEvents()
+{
+	return _renderItemAddedEvents;
+}
+
+EventChannel<id_t>&
+RenderItemRemovedEvents()
+{
+	return _renderItemRemovedEvents;
+}
+
+EventChannel<Entity>&
+PathTraceableChangedEvents()
+{
+	return _pathTraceableChangedEvents;
+}
+
+void
+PublishEvents()
+{
+	_transformChangedEvents.Publish();
+	_renderItemAddedEvents.Publish();
+	_renderItemRemovedEvents.Publish();
+	_pathTraceableChangedEvents.Publish();
+}
+
+}
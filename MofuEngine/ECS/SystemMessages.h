@@ -1,5 +1,9 @@
 #pragma once
 #include "CommonHeaders.h"
+#include "Entity.h"
+#include <atomic>
+#include <bit>
+#include <span>
 
 namespace mofu::ecs::messages {
 //TODO: something better than an enum boolean
@@ -20,4 +24,72 @@ struct SystemBoolMessage
 void SetMessage(SystemBoolMessage::Type type, bool value);
 bool GetBoolMessage(SystemBoolMessage::Type type);
 void RestartFrameMessages();
-}
\ No newline at end of file
+
+/*
+* a double buffered list of events, any thread can push while a phase runs and the readers see the events after PublishEvents
+* pushing is a fetch_add on the write cursor into a preallocated array, events past the end are only counted
+* and the channel is marked overflowed for that frame, then it grows on publish so the next frames fit
+* NOTE: nothing can push while PublishEvents runs, the readers have to treat an overflowed channel as "everything changed"
+*/
+template<typename T>
+class EventChannel
+{
+public:
+	static constexpr u32 MAX_CAPACITY{ 1u << 20 };
+
+	constexpr explicit EventChannel(u32 capacity) : _write(capacity), _read(capacity), _capacity{ capacity } {}
+	DISABLE_COPY_AND_MOVE(EventChannel);
+
+	void Push(const T& event)
+	{
+		const u32 index{ _writeCount.fetch_add(1, std::memory_order_relaxed) };
+		if (index < _write.size()) _write[index] = event;
+	}
+
+	// one fetch_add for a whole batch, for jobs that collect their events first
+	void Push(std::span<const T> events)
+	{
+		if (events.empty()) return;
+		const u32 first{ _writeCount.fetch_add((u32)events.size(), std::memory_order_relaxed) };
+		if (first >= _write.size()) return;
+		const u32 count{ std::min((u32)events.size(), (u32)_write.size() - first) };
+		std::copy_n(events.data(), count, _write.data() + first);
+	}
+
+	// the pushed events become readable, the ones read until now are dropped
+	void Publish()
+	{
+		const u32 count{ _writeCount.exchange(0, std::memory_order_relaxed) };
+		_write.swap(_read);
+		_readCount = std::min(count, (u32)_read.size());
+		_overflowed = count > _read.size();
+		if (count > _capacity) _capacity = std::min((u32)std::bit_ceil(count), MAX_CAPACITY);
+		if (_write.size() < _capacity) _write.resize(_capacity);
+	}
+
+	[[nodiscard]] std::span<const T> Events() const { return { _read.data(), _readCount }; }
+	[[nodiscard]] bool Overflowed() const { return _overflowed; }
+	// overflowed channels have events even if none could be kept
+	[[nodiscard]] bool HasEvents() const { return _readCount != 0 || _overflowed; }
+
+private:
+	Vec<T> _write;
+	Vec<T> _read;
+	std::atomic<u32> _writeCount{ 0 };
+	u32 _readCount{ 0 };
+	u32 _capacity;
+	bool _overflowed{ false };
+};
+
+// entities whose WorldTransform was recomputed by UpdateHierarchy
+EventChannel<Entity>& TransformChangedEvents();
+// render item ids from graphics::AddRenderItem and graphics::RemoveRenderItem
+EventChannel<id_t>& RenderItemAddedEvents();
+EventChannel<id_t>& RenderItemRemovedEvents();
+// main world entities that gained or lost PathTraceable, or were created or removed with it
+EventChannel<Entity>& PathTraceableChangedEvents();
+
+// publishes every channel, called once a frame before the render systems so they read what the update phases pushed
+// events pushed later (render systems, the editor between frames) are read the next frame
+void PublishEvents();
+}
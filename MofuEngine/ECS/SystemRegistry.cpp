@@ -0,0 +1,161 @@
+#include "SystemRegistry.h"
+#include "ECSCore.h"
+#include "Utilities/Logger.h"
+
+namespace mofu::ecs::system {
+namespace {
+
+constexpr const char* GROUP_NAMES[SystemGroup::Count]{ "Initial", "PreUpdate", "Update", "PostUpdate", "Final" };
+
+void
+RunSystem(SystemEntry& entry, const SystemUpdateData data)
+{
+	// a worker waiting inside a system can pick up another system, so the outer versions are restored after
+	u32 previousVersion{};
+	u32 previousLastRunVersion{};
+	GetSystemVersions(previousVersion, previousLastRunVersion);
+
+	const u32 version{ AdvanceVersion() };
+	SetSystemVersions(version, entry.LastRunVersion);
+	entry.Update(entry.Instance.get(), data);
+	entry.LastRunVersion = version;
+
+	SetSystemVersions(previousVersion, previousLastRunVersion);
+}
+
+} // anonymous namespace
+
+void
+SystemRegistry::UpdateSystems(SystemGroup::Group group, const SystemUpdateData data)
+{
+	SystemSchedule& schedule{ _schedules[group] };
+	if (schedule.IsDirty)
+	{
+		BuildSchedule(group);
+		DumpSchedule(group);
+	}
+
+	std::vector<SystemEntry>& systems{ _systems[group] };
+	for (const SystemSchedule::Step& step : schedule.Steps)
+	{
+		if (step.Exclusive || step.Count == 1)
+		{
+			RunSystem(systems[step.First], data);
+			continue;
+		}
+
+		for (u32 i{ step.First }; i < step.First + step.Count; ++i)
+		{
+			schedule.RemainingDependencies[i].store(schedule.DependencyCounts[i], std::memory_order_relaxed);
+		}
+
+		SetRunningParallelStep(true);
+		jobs::JobCounter counter{};
+		for (u32 i{ step.First }; i < step.First + step.Count; ++i)
+		{
+			if (schedule.DependencyCounts[i] != 0) continue;
+			jobs::Run([this, group, i, data, &counter] { RunScheduledSystem(group, i, data, counter); }, &counter);
+		}
+		jobs::Wait(counter);
+		SetRunningParallelStep(false);
+	}
+}
+
+void
+SystemRegistry::RunScheduledSystem(SystemGroup::Group group, u32 index, const SystemUpdateData data, jobs::JobCounter& counter)
+{
+	RunSystem(_systems[group][index], data);
+
+	// the dependents are queued before this job finishes, so the counter can't reach 0 in between
+	SystemSchedule& schedule{ _schedules[group] };
+	for (u32 dependent : schedule.Dependents[index])
+	{
+		if (schedule.RemainingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			jobs::Run([this, group, dependent, data, &counter] { RunScheduledSystem(group, dependent, data, counter); }, &counter);
+		}
+	}
+}
+
+void
+SystemRegistry::BuildSchedule(SystemGroup::Group group)
+{
+	const std::vector<SystemEntry>& systems{ _systems[group] };
+	SystemSchedule& schedule{ _schedules[group] };
+	const u32 systemCount{ (u32)systems.size() };
+
+	schedule.Steps.clear();
+	schedule.DependencyCounts.clear();
+	schedule.DependencyCounts.resize(systemCount, 0);
+	schedule.Dependents.clear();
+	schedule.Dependents.resize(systemCount);
+	schedule.RemainingDependencies = std::make_unique<std::atomic<u32>[]>(systemCount);
+
+	for (u32 i{ 0 }; i < systemCount; ++i)
+	{
+		const bool exclusive{ systems[i].Access.Exclusive };
+		if (exclusive || schedule.Steps.empty() || schedule.Steps.back().Exclusive)
+		{
+			schedule.Steps.emplace_back(SystemSchedule::Step{ i, 0, exclusive });
+		}
+		SystemSchedule::Step& step{ schedule.Steps.back() };
+		step.Count++;
+		if (exclusive) continue;
+
+		// the order within a group is kept for every pair of systems that conflict
+		for (u32 j{ step.First }; j < i; ++j)
+		{
+			if (!systems[i].Access.ConflictsWith(systems[j].Access)) continue;
+			schedule.Dependents[j].emplace_back(i);
+			schedule.DependencyCounts[i]++;
+		}
+	}
+
+	schedule.IsDirty = false;
+}
+
+void
+SystemRegistry::DumpSchedule(SystemGroup::Group group) const
+{
+	const std::vector<SystemEntry>& systems{ _systems[group] };
+	const SystemSchedule& schedule{ _schedules[group] };
+	log::Info("System schedule [%s]: %u systems, %u steps", GROUP_NAMES[group], (u32)systems.size(), (u32)schedule.Steps.size());
+
+	for (u32 s{ 0 }; s < schedule.Steps.size(); ++s)
+	{
+		const SystemSchedule::Step& step{ schedule.Steps[s] };
+		if (step.Exclusive)
+		{
+			log::Info("  step %u: %s (exclusive)", s, systems[step.First].Name);
+			continue;
+		}
+
+		log::Info("  step %u: %u parallel systems", s, step.Count);
+		for (u32 i{ step.First }; i < step.First + step.Count; ++i)
+		{
+			char after[256]{};
+			u32 length{ 0 };
+			for (u32 j{ step.First }; j < i; ++j)
+			{
+				for (u32 dependent : schedule.Dependents[j])
+				{
+					if (dependent != i || length >= sizeof(after) - 1) continue;
+					length += snprintf(after + length, sizeof(after) - length, length ? ", %s" : "%s", systems[j].Name);
+					length = std::min(length, (u32)sizeof(after) - 1);
+				}
+			}
+			log::Info("    %s%s%s", systems[i].Name, length ? " after " : "", after);
+		}
+	}
+}
+
+void
+SystemRegistry::DumpSchedule() const
+{
+	for (u32 group{ 0 }; group < SystemGroup::Count; ++group)
+	{
+		DumpSchedule((SystemGroup::Group)group);
+	}
+}
+
+}
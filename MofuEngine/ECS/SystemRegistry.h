@@ -1,13 +1,15 @@
 #pragma once
 #include "ECSCommon.h"
 #include "EngineAPI/ECS/SystemAPI.h"
+#include "Utilities/JobSystem.h"
 #include <array>
-#include <functional>
+#include <memory>
 
 /*
 * contains all registered systems
 * these can be grouped together
 * and ordered within the group
+* systems within a group that don't conflict in component access run in parallel
 */
 
 namespace mofu::ecs::system {
@@ -16,8 +18,31 @@ struct SystemEntry
 {
 	u32 GroupOrder{ 0 };
 	SystemGroup::Group Group{ SystemGroup::Update };
-	//std::unique_ptr<System> SystemPtr;
-	std::function<void(SystemUpdateData)> SystemUpdate;
+	const char* Name{ "" };
+	AccessMask Access{};
+	std::shared_ptr<void> Instance{}; // systems keep their state between frames
+	void(*Update)(void* instance, SystemUpdateData data) { nullptr };
+	u32 LastRunVersion{ 0 }; // the change version of the last update, see Changed<C>
+};
+
+/*
+* a group is split into steps, an exclusive system gets a step of its own and runs on the calling thread
+* inside a step every system waits only for the earlier systems it conflicts with, the rest run on the job system
+*/
+struct SystemSchedule
+{
+	struct Step
+	{
+		u32 First{ 0 };
+		u32 Count{ 0 };
+		bool Exclusive{ false };
+	};
+
+	Vec<Step> Steps{};
+	Vec<u32> DependencyCounts{}; // indexed like the group's systems
+	Vec<Vec<u32>> Dependents{};
+	std::unique_ptr<std::atomic<u32>[]> RemainingDependencies{};
+	bool IsDirty{ true };
 };
 
 template<typename T>
@@ -37,48 +62,34 @@ public:
 	}
 
 	// TODO: what should be sent for updates 
-	void UpdateSystems(SystemGroup::Group group, const SystemUpdateData data)
-	{
-		for (auto& systemEntry : _systems[group])
-		{
-			//assert(systemEntry.SystemPtr);
-			//systemEntry.SystemPtr->Update(data);
-			systemEntry.SystemUpdate(data);
-		}
-	}
+	void UpdateSystems(SystemGroup::Group group, const SystemUpdateData data);
+	// logs the steps and dependencies of every group
+	void DumpSchedule() const;
 
 	template<IsSystem T>
-	void RegisterSystem(SystemGroup::Group group = SystemGroup::Update, u32 order = -1)
+	void RegisterSystem(SystemGroup::Group group = SystemGroup::Update, u32 order = U32_INVALID_ID, const char* name = "")
 	{
 		// TODO: make sure to do this only if there is no update going on
-		if (order < 0)
-		{
-			//_systems[group].emplace_back(_systems[group].size(), group, std::make_unique<T>());
-			_systems[group].emplace_back((u32)_systems[group].size(), group, [](SystemUpdateData data) {T system{}; system.Update(data); });
-		}
-		else
+		std::vector<SystemEntry>& systems{ _systems[group] };
+		if (order > (u32)systems.size()) order = (u32)systems.size();
+
+		// insert at the specified order and shift the rest
+		systems.insert(systems.begin() + order, SystemEntry{ order, group, name, GetSystemAccess<T>(), std::make_shared<T>(),
+			[](void* instance, SystemUpdateData data) { static_cast<T*>(instance)->Update(data); } });
+		for (u32 i{ order + 1 }; i < systems.size(); ++i)
 		{
-			if (order > (u32)_systems[group].size()) order = (u32)_systems[group].size();
-			// insert at the specified order and shift the rest
-			//_systems[group].emplace_back();
-			//std::shift_right(_systems[group].begin() + order, _systems[group].end(), 1);
-			//std::for_each(_systems[group].begin() + order + 1, _systems[group].end(), [&](SystemEntry& entry) { entry.GroupOrder++; });
-			
-			_systems[group].insert(_systems[group].begin() + order, SystemEntry{ order, group, [](SystemUpdateData data) {T system{}; system.Update(data); } });
-			for (u32 i{ order + 1 }; i < _systems[group].size(); ++i)
-			{
-				_systems[group][i].GroupOrder++;
-			}
-
-			//_systems[group][order] = SystemEntry{ order, std::make_unique<T>() };
-			new(&_systems[group][order]) SystemEntry{ order, group, [](SystemUpdateData data) {T system{}; system.Update(data); } };
+			systems[i].GroupOrder++;
 		}
+		_schedules[group].IsDirty = true;
 	}
 
 private:
-	// systems' order index -- ptr to System
-	//using SystemEntry = std::pair<u32, std::unique_ptr<System>>;
+	void BuildSchedule(SystemGroup::Group group);
+	void DumpSchedule(SystemGroup::Group group) const;
+	void RunScheduledSystem(SystemGroup::Group group, u32 index, const SystemUpdateData data, jobs::JobCounter& counter);
+
 	std::array<std::vector<SystemEntry>, SystemGroup::Count> _systems; //TODO: own vector
+	std::array<SystemSchedule, SystemGroup::Count> _schedules;
 };
 
 }
@@ -89,9 +100,9 @@ namespace mofu::ecs::system::detail
 	template<IsSystem T>
 	struct RegisterScriptCall
 	{
-		RegisterScriptCall(SystemGroup::Group g, u32 o)
+		RegisterScriptCall(SystemGroup::Group g, u32 o, const char* name)
 		{
-			SystemRegistry::Instance().RegisterSystem<T>(g, o);
+			SystemRegistry::Instance().RegisterSystem<T>(g, o, name);
 		}
 	};
 }
\ No newline at end of file
@@ -4,48 +4,92 @@
 #include "EngineAPI/ECS/SceneAPI.h"
 #include "ECS/QueryView.h"
 
-#include "Graphics/GraphicsTypes.h"
-#include "Graphics/D3D12/D3D12Core.h"
-#include "Graphics/D3D12/D3D12Content.h"
-#include "Graphics/D3D12/D3D12Resources.h"
-#include "Graphics/D3D12/D3D12GPass.h"
-#include "Graphics/D3D12/D3D12Camera.h"
-#include "Graphics/D3D12/D3D12Content/D3D12Geometry.h"
-#include "Graphics/D3D12/D3D12Content/D3D12Material.h"
-#include "Graphics/D3D12/D3D12Content/D3D12Texture.h"
-#include "Graphics/D3D12/GPassCache.h"
+#include "Graphics/Renderer.h"
 
 #include "ECS/Transform.h"
+#include "ECS/FrustumCulling.h"
 #include "Utilities/Logger.h"
 
 #include "tracy/Tracy.hpp"
 
 namespace mofu::graphics::d3d12 {
+
+	/*
+	* culls the render items against the main camera, then fills the visible entities and the frame's render items
+	* only entities with a CullableObject get tested, the rest are always visible
+	* NOTE: uses the camera matrices of the last rendered frame, the camera updates when rendering
+	*/
 	struct FrustumCullingSystem : ecs::system::System<FrustumCullingSystem>
 	{
-		//TODO: figure out caching stuff and not updating unchanged
+		Vec<id_t> RenderItemIDs{};
+		Vec<f32> Thresholds{};
+		Vec<u8> Culled{}; // by entity index, only written for entities with a CullableObject
+
+		void CullEntities(const ecs::culling::FrustumPlanes& frustum)
+		{
+			using namespace ecs::culling;
+			const FrustumPlanesBatch planes{ GetFrustumPlanesBatch(frustum) };
+			Culled.resize(ecs::scene::GetAllEntityData().size());
+			u8* const culled{ Culled.data() };
+
+			// blocks go to different workers and an entity's flag is only written by its own block
+			ecs::scene::GetRO<ecs::component::WorldTransform, ecs::component::CullableObject>().ParallelForEachChunk(
+				[&planes, &frustum, culled](u32 count, const ecs::Entity* entities,
+					const ecs::component::WorldTransform* transforms, const ecs::component::CullableObject* cullables) {
+					CullBatch batch;
+					for (u32 first{ 0 }; first < count; first += CULL_SIMD_WIDTH)
+					{
+						const u32 laneCount{ std::min(CULL_SIMD_WIDTH, count - first) };
+						FillCullBatch(batch, transforms, cullables, first, count);
+						const u32 visible{ CullBoxBatch(batch, planes) };
+						for (u32 lane{ 0 }; lane < laneCount; ++lane)
+						{
+							const bool isVisible{ ((visible >> lane) & 1) != 0 };
+#ifdef _DEBUG
+							const f32 margin{ GetBoxFrustumMargin(transforms[first + lane].TRS, cullables[first + lane].obb, frustum) };
+							assert(isVisible == (margin >= 0.f) || std::abs(margin) < CULL_CHECK_EPSILON);
+#endif
+							culled[id::Index(entities[first + lane])] = !isVisible;
+						}
+					}
+				});
+		}
+
 		void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 		{
 			ZoneScopedN("FrustumCullingSystem");
 			graphics::FrameInfo frameInfo{};
 			graphics::Camera mainCamera{ graphics::GetMainCamera() };
 			Vec<ecs::Entity>& visibleEntities{ graphics::GetVisibleEntities() };
-			using namespace DirectX;
 
+			RenderItemIDs.clear();
+			Thresholds.clear();
 			visibleEntities.clear();
 
 			frameInfo.LastFrameTime = 16.7f;
 			frameInfo.AverageFrameTime = 16.7f;
 			frameInfo.CameraID = camera_id{ 0 };
 
-			for (auto [entity, transform, mesh]
-				: ecs::scene::GetRW<ecs::component::WorldTransform,
-					ecs::component::CullableObject>())
+			// without a camera nothing gets culled
+			const bool canCull{ mainCamera.IsValid() };
+			if (canCull) CullEntities(ecs::culling::GetFrustumPlanes(mainCamera.ViewProjection()));
+
+			for (auto [entity, mesh, cullable]
+				: ecs::scene::GetRO<ecs::component::RenderMesh, ecs::Optional<ecs::component::CullableObject>>())
 			{
+				if (canCull && cullable && Culled[id::Index(entity)]) continue;
+				RenderItemIDs.emplace_back(mesh.RenderItemID);
+				Thresholds.emplace_back(0.f);
+				visibleEntities.emplace_back(entity);
 			}
-			
+
+			frameInfo.RenderItemCount = (u32)RenderItemIDs.size();
+			frameInfo.RenderItemIDs = RenderItemIDs.data();
+			frameInfo.Thresholds = Thresholds.data();
+
+			graphics::SetCurrentFrameInfo(frameInfo);
 		}
 	};
 	REGISTER_SYSTEM(FrustumCullingSystem, ecs::system::SystemGroup::PreUpdate, 1);
 
-}
\ No newline at end of file
+}
@@ -14,6 +14,8 @@
 namespace mofu::graphics::d3d12 {
 struct LightPostFrameSystem : ecs::system::System<LightPostFrameSystem>
 {
+	using Access = ecs::system::SystemAccess<ecs::system::Read<ecs::component::WorldTransform>, ecs::system::Write<ecs::component::CullableLight>>;
+
 	void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 	{
 		ZoneScopedN("LightPostFrameSystem");
@@ -29,7 +31,7 @@ struct LightPostFrameSystem : ecs::system::System<LightPostFrameSystem>
 		//}
 
 		for (auto [entity, wt, light]
-			: ecs::scene::GetRW<ecs::component::WorldTransform, ecs::component::CullableLight>())
+			: ecs::scene::GetRW<ecs::component::WorldTransform, ecs::component::CullableLight, ecs::Changed<ecs::component::WorldTransform>>())
 		{
 			graphics::light::UpdateCullableLightTransform(light, wt);
 		}
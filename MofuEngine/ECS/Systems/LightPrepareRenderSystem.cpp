@@ -12,6 +12,8 @@
 namespace mofu::graphics::d3d12 {
 	struct LightPrepareRenderSystem : ecs::system::System<LightPrepareRenderSystem>
 	{
+		using Access = ecs::system::SystemAccess<>;
+
 		void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 		{
 			ZoneScopedN("LightPrepareRenderSystem");
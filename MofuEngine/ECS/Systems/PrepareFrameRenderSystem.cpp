@@ -27,7 +27,7 @@
 namespace mofu::graphics::d3d12 {
 	struct PrepareFrameRenderSystem : ecs::system::System<PrepareFrameRenderSystem>
 	{
-		void FillPerObjectData(ecs::Entity entity, hlsl::PerObjectData* data, ecs::component::WorldTransform& transform,
+		void FillPerObjectData(ecs::Entity entity, hlsl::PerObjectData* data, const ecs::component::WorldTransform& transform,
 			const MaterialSurface* const materialSurface, id_t materialID, const xmmat& cameraVP, const xmmat& cameraPrevVP)
 		{
 			using namespace DirectX;
@@ -77,7 +77,7 @@ namespace mofu::graphics::d3d12 {
 			Vec<ecs::Entity>& visible{ graphics::GetVisibleEntities() };
 			for (auto e : visible)
 			{
-				auto material{ ecs::scene::GetComponent<ecs::component::RenderMaterial>(e) };
+				auto material{ ecs::scene::GetComponentRO<ecs::component::RenderMaterial>(e) };
 				if (renderItemIndex < renderItemCount)
 				{
 					frameCache.MaterialIDs[renderItemIndex] = material.MaterialID;
@@ -105,7 +105,7 @@ namespace mofu::graphics::d3d12 {
 			const xmmat camPrevVP{ DirectX::XMLoadFloat4x4(frameInfo.Camera->PrevViewProjection()) };
 			for (auto e : visible)
 			{
-				auto& wt{ ecs::scene::GetComponent<ecs::component::WorldTransform>(e) };
+				auto& wt{ ecs::scene::GetComponentRO<ecs::component::WorldTransform>(e) };
 				if (renderItemIndex < renderItemCount)
 				{
 					currentDataPtr = cbuffer.AllocateSpace<hlsl::PerObjectData>();
@@ -170,9 +170,13 @@ namespace mofu::graphics::d3d12 {
 			}
 
 #if RAYTRACING
-			if (ecs::messages::GetBoolMessage(ecs::messages::SystemBoolMessage::TransformChanged) 
-				|| input::WasKeyPressed(input::Keybinds::Debug.RTASRebuild))
-				graphics::d3d12::rt::UpdateAccelerationStructure();
+			// only the moved instances get rewritten, added or removed render items and path traced entities gather all of them again
+			const ecs::messages::EventChannel<ecs::Entity>& movedEntities{ ecs::messages::TransformChangedEvents() };
+			const bool rebuildInstances{ ecs::messages::RenderItemAddedEvents().HasEvents() || ecs::messages::RenderItemRemovedEvents().HasEvents()
+				|| ecs::messages::PathTraceableChangedEvents().HasEvents()
+				|| movedEntities.Overflowed() || input::WasKeyPressed(input::Keybinds::Debug.RTASRebuild) };
+			if (rebuildInstances || !movedEntities.Events().empty())
+				graphics::d3d12::rt::UpdateAccelerationStructure(movedEntities.Events(), rebuildInstances);
 #endif
 
 			//TODO: issue commands
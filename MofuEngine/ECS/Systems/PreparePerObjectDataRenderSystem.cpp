@@ -18,6 +18,8 @@
 namespace mofu::graphics::d3d12 {
 struct PreparePerObjectDataSystem : ecs::system::System<PreparePerObjectDataSystem>
 {
+	using Access = ecs::system::SystemAccess<>;
+
 	//TODO: figure out caching stuff and not updating unchanged
 	void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 	{
@@ -10,6 +10,8 @@
 namespace mofu::ecs::system {
 	struct SubmitEntityRenderSystem : ecs::system::System<SubmitEntityRenderSystem>
 	{
+		using Access = SystemAccess<>;
+
 		void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 		{
 			//log::Info("SubmitEntityRenderSystem::Update");
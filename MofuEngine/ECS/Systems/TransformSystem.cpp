@@ -17,6 +17,9 @@ namespace mofu::ecs::system {
 
 struct TransformSystem : ecs::system::System<TransformSystem>
 {
+	// reparenting reads Child::ParentEntity
+	using Access = SystemAccess<Write<component::LocalTransform, component::WorldTransform>, Read<component::Child>>;
+
 	void Update([[maybe_unused]] const ecs::system::SystemUpdateData data)
 	{
 		ZoneScopedN("TransformSystem");
@@ -11,6 +11,7 @@
 #include "EngineAPI/Camera.h"
 #include "Graphics/Renderer.h"
 #include "Content/SerializationUtils.h"
+#include "ECS/EditorMetadata.h"
 #include "Graphics/Lights/Light.h"
 #include "Graphics/D3D12/D3D12Content/D3D12Geometry.h"
 
@@ -54,9 +55,8 @@ struct RenderMesh : Component
 	id_t MeshID{ id::INVALID_ID };
 	id_t RenderItemID{ id::INVALID_ID };
 
+	// NOTE: the source asset is editor data, see metadata::EntityAssets
 #if EDITOR_BUILD
-	//FIXME: should just have a map of entity and it's asset handles as this makes the size of components unpredictable, or also i do have GetAssetFromResource
-	content::AssetHandle MeshAsset;
 	static void RenderFields([[maybe_unused]] RenderMesh& c)
 	{
 		ImGui::TableNextRow();
@@ -71,7 +71,6 @@ struct RenderMaterial : Component
 	id_t MaterialID{ id::INVALID_ID };
 
 #if EDITOR_BUILD
-	content::AssetHandle MaterialAsset;
 	static void RenderFields([[maybe_unused]] RenderMaterial& c)
 	{
 		ImGui::TableNextRow();
@@ -88,6 +87,10 @@ struct CullableObject : Component
 #if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] CullableObject& c)
 	{
+		ImGui::TableNextRow();
+		editor::ui::DisplayEditableVector3(&c.obb.Center, "Bounds Center");
+		ImGui::TableNextRow();
+		editor::ui::DisplayEditableVector3(&c.obb.Extents, "Bounds Extents", 0.f);
 	}
 #endif
 };
@@ -103,7 +106,7 @@ struct StaticObject : Component // NOTE: for static mesh render optimisation, no
 #endif
 };
 
-struct DynamicObject : Component
+struct DynamicObject : SparseComponent
 {
 #if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] DynamicObject& c)
@@ -114,7 +117,7 @@ struct DynamicObject : Component
 #endif
 };
 
-struct PotentiallyVisible : Component // NOTE: for culling
+struct PotentiallyVisible : SparseComponent // NOTE: for culling
 {
 #if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] PotentiallyVisible& c)
@@ -171,6 +174,7 @@ constexpr inline v3 ToDegrees(const v3& radians)
 static v3 prevEuler = { 0,0,0 };
 
 // exposed to various systems as read-only or read-write
+// stored field by field (see FieldSplit<LocalTransform>), queries and GetComponent give a LocalTransformRef instead of a LocalTransform&
 struct LocalTransform : Component
 {
 	v3 Position{ 0.0f, 0.0f, 0.0f };
@@ -289,6 +293,72 @@ struct LocalTransform : Component
 #endif
 };
 
+// a row of a LocalTransform column, the fields are references into their arrays
+template<bool Writable>
+struct LocalTransformRef
+{
+	template<typename T>
+	using Field = std::conditional_t<Writable, T&, const T&>;
+
+	Field<v3> Position;
+	Field<quat> Rotation;
+	Field<v3> Scale;
+	Field<v3> Forward;
+
+	operator LocalTransform() const { return { {}, Position, Rotation, Scale, Forward }; }
+	operator LocalTransformRef<false>() const requires Writable { return { Position, Rotation, Scale, Forward }; }
+	// LocalTransform lt{ ref } would only initialize the Component base of the aggregate and leave the fields at their defaults,
+	// this makes it a compile error, copy with LocalTransform lt = ref instead
+	operator Component() const = delete;
+
+	const LocalTransformRef& operator=(const LocalTransform& lt) const requires Writable
+	{
+		Position = lt.Position;
+		Rotation = lt.Rotation;
+		Scale = lt.Scale;
+		Forward = lt.Forward;
+		return *this;
+	}
+};
+
+template<bool Writable>
+struct LocalTransformColumns
+{
+	template<typename T>
+	using Array = std::conditional_t<Writable, T*, const T*>;
+
+	Array<v3> Position;
+	Array<quat> Rotation;
+	Array<v3> Scale;
+	Array<v3> Forward;
+
+	LocalTransformRef<Writable> operator[](u32 row) const { return { Position[row], Rotation[row], Scale[row], Forward[row] }; }
+	LocalTransformColumns operator+(u32 first) const { return { Position + first, Rotation + first, Scale + first, Forward + first }; }
+};
+
+// the hierarchy update reads the positions, rotations and scales of a block as three arrays instead of picking them out of the structs
+template<>
+struct FieldSplit<LocalTransform> : std::true_type
+{
+	static constexpr ColumnField Fields[]{
+		{ offsetof(LocalTransform, Position), sizeof(v3) },
+		{ offsetof(LocalTransform, Rotation), sizeof(quat) },
+		{ offsetof(LocalTransform, Scale), sizeof(v3) },
+		{ offsetof(LocalTransform, Forward), sizeof(v3) },
+	};
+
+	template<bool Writable>
+	using Columns = LocalTransformColumns<Writable>;
+
+	template<bool Writable>
+	static Columns<Writable> GetColumns(u8* column, u32 capacity)
+	{
+		return { (v3*)(column + Fields[0].Offset * capacity), (quat*)(column + Fields[1].Offset * capacity),
+			(v3*)(column + Fields[2].Offset * capacity), (v3*)(column + Fields[3].Offset * capacity) };
+	}
+};
+static_assert(sizeof(LocalTransform) == sizeof(v3) * 3 + sizeof(quat), "the fields have to be packed");
+
 struct Camera : Component
 {
 	v3 TargetPos{};
@@ -341,8 +411,9 @@ struct DirtyLight : Component
 
 struct CullableLight : Component
 {
-#if EDITOR_BUILD
 	u32 LightDataIndex{}; // TODO: a better way?
+
+#if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] CullableLight& c)
 	{
 
@@ -359,9 +430,10 @@ struct DirectionalLight : Component
 	//TODO: might want a table
 	bool Enabled{ true };
 
-#if EDITOR_BUILD
 	Entity Owner{};
 	u32 LightDataIndex{}; // TODO: a better way?
+
+#if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] DirectionalLight& c)
 	{
 		ImGui::TableNextRow();
@@ -393,9 +465,10 @@ struct PointLight : Component
 	//TODO: might want a table
 	bool Enabled{ true };
 
-#if EDITOR_BUILD
 	Entity Owner{};
 	u32 LightDataIndex{}; // TODO: a better way?
+
+#if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] PointLight& c)
 	{
 		ImGui::TableNextRow();
@@ -431,9 +504,10 @@ struct SpotLight : Component
 	//TODO: might want a table
 	bool Enabled{ true };
 
-#if EDITOR_BUILD
 	Entity Owner{};
 	u32 LightDataIndex{}; // TODO: a better way?
+
+#if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] SpotLight& c)
 	{
 		ImGui::TableNextRow();
@@ -499,7 +573,6 @@ struct Collider : Component
 	JPH::BodyID BodyID;
 
 #if EDITOR_BUILD
-	content::AssetHandle ShapeAsset;
 	static void RenderFields([[maybe_unused]] Collider& c)
 	{
 		ImGui::TableNextRow();
@@ -512,7 +585,7 @@ struct Collider : Component
 #endif
 };
 
-struct OpaqueObject : Component
+struct OpaqueObject : SparseComponent
 {
 #if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] OpaqueObject& c)
@@ -523,7 +596,7 @@ struct OpaqueObject : Component
 #endif
 };
 
-struct TransparentObject : Component
+struct TransparentObject : SparseComponent
 {
 #if EDITOR_BUILD
 	static void RenderFields([[maybe_unused]] TransparentObject& c)
@@ -568,32 +641,29 @@ inline YAML::Emitter& operator<<(YAML::Emitter& out, const Child& wt)
 	return out;
 }
 
-inline YAML::Emitter& operator<<(YAML::Emitter& out, const RenderMesh& wt)
+// components whose saved data lives in the entity's editor metadata
+inline void SerializeEntityComponent(YAML::Emitter& out, Entity entity, [[maybe_unused]] const RenderMesh& c)
 {
 	out << YAML::BeginMap;
-	out << YAML::Key << "Mesh" << YAML::Value << wt.MeshAsset;
+	out << YAML::Key << "Mesh" << YAML::Value << metadata::GetAssets(entity).Mesh;
 	out << YAML::EndMap;
-	return out;
 }
 
-inline bool operator>>(const YAML::Node& node, RenderMesh& lt)
+inline void DeserializeEntityComponent(const YAML::Node& node, Entity entity, [[maybe_unused]] RenderMesh& c)
 {
-	lt.MeshAsset = node["Mesh"].as<u64>();
-	return true;
+	metadata::GetAssets(entity).Mesh = node["Mesh"].as<u64>();
 }
 
-inline YAML::Emitter& operator<<(YAML::Emitter& out, const RenderMaterial& wt)
+inline void SerializeEntityComponent(YAML::Emitter& out, Entity entity, [[maybe_unused]] const RenderMaterial& c)
 {
 	out << YAML::BeginMap;
-	out << YAML::Key << "Material" << YAML::Value << wt.MaterialAsset;
+	out << YAML::Key << "Material" << YAML::Value << metadata::GetAssets(entity).Material;
 	out << YAML::EndMap;
-	return out;
 }
 
-inline bool operator>>(const YAML::Node& node, RenderMaterial& lt)
+inline void DeserializeEntityComponent(const YAML::Node& node, Entity entity, [[maybe_unused]] RenderMaterial& c)
 {
-	lt.MaterialAsset = node["Material"].as<u64>();
-	return true;
+	metadata::GetAssets(entity).Material = node["Material"].as<u64>();
 }
 
 inline YAML::Emitter& operator<<(YAML::Emitter& out, const PointLight& wt)
@@ -634,18 +704,16 @@ inline bool operator>>(const YAML::Node& node, NameComponent& lt)
 	return true;
 }
 
-inline YAML::Emitter& operator<<(YAML::Emitter& out, const Collider& c)
+inline void SerializeEntityComponent(YAML::Emitter& out, Entity entity, [[maybe_unused]] const Collider& c)
 {
 	out << YAML::BeginMap;
-	out << YAML::Key << "Shape" << YAML::Value << c.ShapeAsset;
+	out << YAML::Key << "Shape" << YAML::Value << metadata::GetAssets(entity).Shape;
 	out << YAML::EndMap;
-	return out;
 }
 
-inline bool operator>>(const YAML::Node& node, Collider& c)
+inline void DeserializeEntityComponent(const YAML::Node& node, Entity entity, [[maybe_unused]] Collider& c)
 {
-	c.ShapeAsset = node["Shape"].as<u64>();
-	return true;
+	metadata::GetAssets(entity).Shape = node["Shape"].as<u64>();
 }
 
 #endif
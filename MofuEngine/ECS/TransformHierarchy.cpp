@@ -1,252 +1,755 @@
 #include "TransformHierarchy.h"
 #include "Scene.h"
 #include "SystemMessages.h"
+#include "Utilities/JobSystem.h"
+#include <numeric>
 
 namespace mofu::ecs::transform {
 namespace {
 
 /*
-* a table for each corresponding number of parents influencing the final transform
-* the tables are ordered based on the index of influencing entity in the i-1 table
-* Vec[0] = transforms of entities with no parents
-* Vec[1] = with one parent
+* a level for each corresponding number of parents influencing the final transform
+* a level is kept sorted by the index of the parent in the level above, so the parents are read in order
+* _levels[0] = entities with no parents
+* _levels[1] = with one parent
 * ...
+* adding, removing and reparenting only append/swap-remove and mark the level dirty,
+* the sorting and the parent indices are fixed up in one go by ReconfigureHierarchy
+* every per-entity array of a level is indexed like Entities and moves along with it
 */
-//NOTE: for now, im assuming that every entity needs a WorldTransform, which is not true
-Vec<Vec<EntityFinalTRS>> finalTransforms{};
+constexpr u32 SIMD_WIDTH{ 4 };
 
-// this could be more packed cause it's only needed for motion vectors so for entities that have a WorldTransform; 
-// unless i find some nice other usage for previous transforms
-Vec<m4x4> _previousTransforms{};
+// the position, rotation and scale of SIMD_WIDTH entities of a level, lane l of batch b is the entity at b * SIMD_WIDTH + l
+struct LocalTransformBatch
+{
+	alignas(16) f32 Position[3][SIMD_WIDTH];
+	alignas(16) f32 Rotation[4][SIMD_WIDTH];
+	alignas(16) f32 Scale[3][SIMD_WIDTH];
+};
 
-//TODO: when i stack all added entities to add them at the end i should just have one sort instead of inserting in the right place immediately
-constexpr bool SORT_DEFERRED{ false };
+struct HierarchyLevel
+{
+	Vec<Entity> Entities{};
+	Vec<Entity> Parents{};
+	Vec<u32> ParentIndices{}; // into the level above
+	// where the entities are, a nullptr block means the row has to be looked up again (see MarkEntityLocationChanged)
+	Vec<EntityBlock*> Blocks{};
+	Vec<u16> Rows{};
+	// resolved with the location, the level below reads its parents' matrices through them
+	Vec<component::WorldTransform*> WorldTransforms{};
+	// copies of the LocalTransforms, only refreshed for the entities whose LocalTransform changed,
+	// so the kernel streams through them instead of picking the fields out of the blocks
+	Vec<LocalTransformBatch> Locals{};
+	// the world transforms before their last recompute, for motion vectors
+	Vec<m4x4> PreviousTransforms{};
+	Vec<u8> UpdateFlags{};
+	// whether the world transform was recomputed in the last update, the children of moved entities move too
+	Vec<u8> Moved{};
+	bool IsDirty{ false };
+};
 
-struct EntityLevelIndex
+//NOTE: for now, im assuming that every entity needs a WorldTransform, which is not true
+Vec<HierarchyLevel> _levels{};
+// entity index -> where the entity is in _levels
+Vec<EntityLevelIndex> _locations{};
+// entities whose parent changed, they might have to go to another level with their children
+Vec<Entity> _reparentedEntities{};
+
+struct UpdateFlags
 {
-	u32 Level;
-	u32 Index;
+	enum Flags : u8
+	{
+		None = 0x00,
+		MovedLastUpdate = 0x01, // the previous transform still has to catch up once the entity stops
+		ForceUpdate = 0x02, // added, reparented or marked with MarkLocalTransformChanged, the block version doesn't say anything about it
+	};
 };
+// the LocalTransform version of a block has to be newer than this for its entities to be recomputed
+u32 _lastUpdateVersion{ 0 };
+// see SetScalarUpdate
+bool _isScalarUpdate{ false };
+
+Entity
+GetParentEntity(Entity entity)
+{
+	if (!ecs::scene::EntityHasComponent<ecs::component::Child>(entity)) return Entity{ id::INVALID_ID };
+	return ecs::scene::GetEntityComponent<ecs::component::Child>(entity).ParentEntity;
+}
+
+bool
+IsInHierarchy(Entity entity)
+{
+	const u32 index{ id::Index(entity) };
+	if (index >= _locations.size() || _locations[index].Level == U32_INVALID_ID) return false;
+	const EntityLevelIndex location{ _locations[index] };
+	return _levels[location.Level].Entities[location.Index] == entity;
+}
 
 u32
-GetEntityIndexInLevel(Entity entity, u32 level)
+GetDepth(Entity entity)
 {
-	if (finalTransforms.empty()) return U32_INVALID_ID;
-	const Vec<EntityFinalTRS>& transforms{ finalTransforms[level] };
-	for (u32 i = 0; i < transforms.size(); ++i)
+	u32 depth{ 0 };
+	for (Entity parent{ GetParentEntity(entity) }; id::IsValid(parent); parent = GetParentEntity(parent))
 	{
-		if (transforms[i].Entity == entity) return i;
+		depth++;
 	}
-	return U32_INVALID_ID;
+	return depth;
 }
 
-EntityLevelIndex
-GetEntityLevelIndex(Entity entity)
+void
+SetLocation(Entity entity, EntityLevelIndex location)
 {
-	ecs::Entity currentEntity{ entity };
-	u32 level{ 0 };
-	while (ecs::scene::EntityHasComponent<ecs::component::Child>(currentEntity))
-	{
-		currentEntity = ecs::scene::GetEntityComponent<ecs::component::Child>(currentEntity).ParentEntity;
-		level++;
-	}
-	level = level ? level - 1 : 0;
-	return { level, GetEntityIndexInLevel(entity, level) };
+	const u32 index{ id::Index(entity) };
+	if (index >= _locations.size()) _locations.resize(index + 1);
+	_locations[index] = location;
 }
 
-EntityFinalTRS&
-FindEntityFinalTRS(Entity entity)
+// lane copy between the Locals of two levels
+void
+CopyLocal(LocalTransformBatch* dst, u32 dstIndex, const LocalTransformBatch* src, u32 srcIndex)
 {
-	Entity currentEntity{ entity };
-	u32 level{ 0 };
-	while (ecs::scene::EntityHasComponent<ecs::component::Child>(currentEntity))
+	LocalTransformBatch& to{ dst[dstIndex / SIMD_WIDTH] };
+	const LocalTransformBatch& from{ src[srcIndex / SIMD_WIDTH] };
+	const u32 toLane{ dstIndex % SIMD_WIDTH };
+	const u32 fromLane{ srcIndex % SIMD_WIDTH };
+	for (u32 i{ 0 }; i < 3; ++i) to.Position[i][toLane] = from.Position[i][fromLane];
+	for (u32 i{ 0 }; i < 4; ++i) to.Rotation[i][toLane] = from.Rotation[i][fromLane];
+	for (u32 i{ 0 }; i < 3; ++i) to.Scale[i][toLane] = from.Scale[i][fromLane];
+}
+
+// the new entity gets computed in the next update, its location and LocalTransform are read then
+void
+InsertIntoLevel(Entity entity, Entity parent, u32 level)
+{
+	while (_levels.size() <= level) _levels.emplace_back();
+	HierarchyLevel& hierarchyLevel{ _levels[level] };
+	const u32 index{ (u32)hierarchyLevel.Entities.size() };
+	SetLocation(entity, { level, index });
+	hierarchyLevel.Entities.emplace_back(entity);
+	hierarchyLevel.Parents.emplace_back(parent);
+	hierarchyLevel.ParentIndices.emplace_back(U32_INVALID_ID);
+	hierarchyLevel.Blocks.emplace_back(nullptr);
+	hierarchyLevel.Rows.emplace_back(u16{ 0 });
+	hierarchyLevel.WorldTransforms.emplace_back(nullptr);
+	if (index % SIMD_WIDTH == 0) hierarchyLevel.Locals.emplace_back();
+	hierarchyLevel.PreviousTransforms.emplace_back();
+	hierarchyLevel.UpdateFlags.emplace_back(u8{ UpdateFlags::ForceUpdate });
+	hierarchyLevel.IsDirty = true;
+}
+
+// the last entity of the level takes the removed slot
+void
+EraseFromLevel(EntityLevelIndex location)
+{
+	HierarchyLevel& level{ _levels[location.Level] };
+	_locations[id::Index(level.Entities[location.Index])] = {};
+
+	const u32 last{ (u32)level.Entities.size() - 1 };
+	if (location.Index != last)
 	{
-		currentEntity = ecs::scene::GetEntityComponent<ecs::component::Child>(currentEntity).ParentEntity;
-		level++;
+		const u32 i{ location.Index };
+		level.Entities[i] = level.Entities[last];
+		level.Parents[i] = level.Parents[last];
+		level.ParentIndices[i] = level.ParentIndices[last];
+		level.Blocks[i] = level.Blocks[last];
+		level.Rows[i] = level.Rows[last];
+		level.WorldTransforms[i] = level.WorldTransforms[last];
+		CopyLocal(level.Locals.data(), i, level.Locals.data(), last);
+		level.PreviousTransforms[i] = level.PreviousTransforms[last];
+		level.UpdateFlags[i] = level.UpdateFlags[last];
+		_locations[id::Index(level.Entities[i])] = location;
 	}
-	level = level ? level - 1 : 0;
+	level.Entities.pop_back();
+	level.Parents.pop_back();
+	level.ParentIndices.pop_back();
+	level.Blocks.pop_back();
+	level.Rows.pop_back();
+	level.WorldTransforms.pop_back();
+	if (last % SIMD_WIDTH == 0) level.Locals.pop_back();
+	level.PreviousTransforms.pop_back();
+	level.UpdateFlags.pop_back();
+	level.IsDirty = true;
+	// the children of the moved entity point at its old index
+	if (location.Level + 1 < _levels.size()) _levels[location.Level + 1].IsDirty = true;
+}
 
-	return finalTransforms[level][GetEntityIndexInLevel(entity, level)];
+void
+MoveToLevel(Entity entity, u32 level)
+{
+	const EntityLevelIndex location{ _locations[id::Index(entity)] };
+	const Entity parent{ _levels[location.Level].Parents[location.Index] };
+	const m4x4 previous{ _levels[location.Level].PreviousTransforms[location.Index] };
+	EraseFromLevel(location);
+	InsertIntoLevel(entity, parent, level);
+	_levels[level].PreviousTransforms.back() = previous;
 }
 
-EntityFinalTRS&
-FindEntityFinalTRS(EntityLevelIndex entityLevelIndex)
+// after a reparent changed the depth of an entity, every descendant has to follow it
+void
+FixLevelsOfDescendants()
 {
-	return finalTransforms[entityLevelIndex.Level][entityLevelIndex.Index];
+	for (u32 level{ 1 }; level < _levels.size(); ++level)
+	{
+		// moving down can add a level, so _levels isn't held by reference
+		for (u32 i{ 0 }; i < _levels[level].Entities.size();)
+		{
+			const u32 parentLevel{ _locations[id::Index(_levels[level].Parents[i])].Level };
+			assert(parentLevel != U32_INVALID_ID);
+			if (parentLevel + 1 == level)
+			{
+				++i;
+				continue;
+			}
+			// the swapped-in entity is checked next
+			MoveToLevel(_levels[level].Entities[i], parentLevel + 1);
+		}
+	}
 }
 
-EntityLevelIndex
-AddEntityToHierarchy(Entity entity)
+// sorts by parent index, the parents of the level have to be sorted already
+// returns whether the entities changed places
+bool
+SortLevel(u32 levelIndex)
 {
-	Entity currentEntity{ entity };
-	u32 parentCount{ 0 };
-	while (ecs::scene::EntityHasComponent<ecs::component::Child>(currentEntity))
+	HierarchyLevel& level{ _levels[levelIndex] };
+	const u32 count{ (u32)level.Entities.size() };
+	if (levelIndex != 0)
 	{
-		currentEntity = ecs::scene::GetEntityComponent<ecs::component::Child>(currentEntity).ParentEntity;
-		parentCount++;
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const EntityLevelIndex parentLocation{ _locations[id::Index(level.Parents[i])] };
+			assert(parentLocation.Level == levelIndex - 1); // children have to be removed before their parent
+			level.ParentIndices[i] = parentLocation.Index;
+		}
+	}
+	else
+	{
+		std::fill(level.ParentIndices.begin(), level.ParentIndices.end(), 0);
 	}
 
-	EntityFinalTRS finalTRS{};
-	finalTRS.Entity = entity;
-	finalTRS.ParentIdx = parentCount ? GetEntityIndexInLevel(ecs::scene::GetEntityComponent<ecs::component::Child>(entity).ParentEntity, parentCount - 1) : 0;
-	assert(ecs::scene::EntityHasComponent<ecs::component::WorldTransform>(entity));
-	assert(ecs::scene::EntityHasComponent<ecs::component::LocalTransform>(entity));
-	finalTRS.WorldTransform = &ecs::scene::GetEntityComponent<ecs::component::WorldTransform>(entity);
-	finalTRS.LocalTransform = &ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(entity);
+	if (std::is_sorted(level.ParentIndices.begin(), level.ParentIndices.end())) return false;
+
+	Vec<u32> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&level](u32 a, u32 b) { return level.ParentIndices[a] < level.ParentIndices[b]; });
+
+	HierarchyLevel sorted{};
+	sorted.Entities.resize(count);
+	sorted.Parents.resize(count);
+	sorted.ParentIndices.resize(count);
+	sorted.Blocks.resize(count);
+	sorted.Rows.resize(count);
+	sorted.WorldTransforms.resize(count);
+	sorted.Locals.resize(level.Locals.size());
+	sorted.PreviousTransforms.resize(count);
+	sorted.UpdateFlags.resize(count);
+	for (u32 i{ 0 }; i < count; ++i)
+	{
+		const u32 from{ order[i] };
+		sorted.Entities[i] = level.Entities[from];
+		sorted.Parents[i] = level.Parents[from];
+		sorted.ParentIndices[i] = level.ParentIndices[from];
+		sorted.Blocks[i] = level.Blocks[from];
+		sorted.Rows[i] = level.Rows[from];
+		sorted.WorldTransforms[i] = level.WorldTransforms[from];
+		CopyLocal(sorted.Locals.data(), i, level.Locals.data(), from);
+		sorted.PreviousTransforms[i] = level.PreviousTransforms[from];
+		sorted.UpdateFlags[i] = level.UpdateFlags[from];
+		_locations[id::Index(sorted.Entities[i])] = { levelIndex, i };
+	}
+	sorted.IsDirty = level.IsDirty;
+	level = std::move(sorted);
+	return true;
+}
+
+// levels are split into jobs of this many entities, smaller levels run on the calling thread
+// NOTE: a multiple of SIMD_WIDTH, so a job never shares a LocalTransformBatch with another one
+constexpr u32 HIERARCHY_JOB_SIZE{ 1024 };
+static_assert(HIERARCHY_JOB_SIZE % SIMD_WIDTH == 0);
 
-	_previousTransforms.emplace_back();
-	assert(id::Index(entity) < _previousTransforms.size());
-	_previousTransforms[id::Index(entity)] = {};
+/*
+* the parent input and the output of the transform kernel, every array holds one value of SIMD_WIDTH entities,
+* so one xmm does the same step for all of them
+*/
+struct TransformBatch
+{
+	alignas(16) f32 Parent[4][4][SIMD_WIDTH];
+	alignas(16) f32 World[4][4][SIMD_WIDTH];
+	alignas(16) f32 Forward[3][SIMD_WIDTH];
+};
 
-	u32 entityIndexInLevel{ 0 };
-	if constexpr (SORT_DEFERRED)
+// world = parent * scale * rotation * translation, the same as XMMatrixAffineTransformation followed by XMMatrixMultiply(parent, trs)
+template<bool HasParent>
+void
+ComputeTransformBatch(const LocalTransformBatch& local, TransformBatch& batch)
+{
+	using namespace DirectX;
+	const auto load{ [](const f32* lanes) { return XMLoadFloat4A((const XMFLOAT4A*)lanes); } };
+	const auto store{ [](f32* lanes, xmm v) { XMStoreFloat4A((XMFLOAT4A*)lanes, v); } };
+
+	const xmm one{ XMVectorReplicate(1.f) };
+	const xmm x{ load(local.Rotation[0]) };
+	const xmm y{ load(local.Rotation[1]) };
+	const xmm z{ load(local.Rotation[2]) };
+	const xmm w{ load(local.Rotation[3]) };
+	const xmm x2{ XMVectorAdd(x, x) };
+	const xmm y2{ XMVectorAdd(y, y) };
+	const xmm z2{ XMVectorAdd(z, z) };
+	const xmm xx{ XMVectorMultiply(x, x2) };
+	const xmm yy{ XMVectorMultiply(y, y2) };
+	const xmm zz{ XMVectorMultiply(z, z2) };
+	const xmm xy{ XMVectorMultiply(x, y2) };
+	const xmm xz{ XMVectorMultiply(x, z2) };
+	const xmm yz{ XMVectorMultiply(y, z2) };
+	const xmm wx{ XMVectorMultiply(w, x2) };
+	const xmm wy{ XMVectorMultiply(w, y2) };
+	const xmm wz{ XMVectorMultiply(w, z2) };
+
+	const xmm sx{ load(local.Scale[0]) };
+	const xmm sy{ load(local.Scale[1]) };
+	const xmm sz{ load(local.Scale[2]) };
+	// rows of the local matrix, the 4th column is 0 0 0 1
+	xmm localRows[4][3]{
+		{ XMVectorMultiply(sx, XMVectorSubtract(one, XMVectorAdd(yy, zz))), XMVectorMultiply(sx, XMVectorAdd(xy, wz)), XMVectorMultiply(sx, XMVectorSubtract(xz, wy)) },
+		{ XMVectorMultiply(sy, XMVectorSubtract(xy, wz)), XMVectorMultiply(sy, XMVectorSubtract(one, XMVectorAdd(xx, zz))), XMVectorMultiply(sy, XMVectorAdd(yz, wx)) },
+		{ XMVectorMultiply(sz, XMVectorAdd(xz, wy)), XMVectorMultiply(sz, XMVectorSubtract(yz, wx)), XMVectorMultiply(sz, XMVectorSubtract(one, XMVectorAdd(xx, yy))) },
+		{ load(local.Position[0]), load(local.Position[1]), load(local.Position[2]) },
+	};
+
+	// forward is the rotated +z, the third row before scaling
 	{
+		const xmm fx{ XMVectorAdd(xz, wy) };
+		const xmm fy{ XMVectorSubtract(yz, wx) };
+		const xmm fz{ XMVectorSubtract(one, XMVectorAdd(xx, yy)) };
+		const xmm length{ XMVectorSqrt(XMVectorMultiplyAdd(fx, fx, XMVectorMultiplyAdd(fy, fy, XMVectorMultiply(fz, fz)))) };
+		store(batch.Forward[0], XMVectorDivide(fx, length));
+		store(batch.Forward[1], XMVectorDivide(fy, length));
+		store(batch.Forward[2], XMVectorDivide(fz, length));
+	}
 
+	if constexpr (!HasParent)
+	{
+		for (u32 row{ 0 }; row < 4; ++row)
+		{
+			for (u32 col{ 0 }; col < 3; ++col) store(batch.World[row][col], localRows[row][col]);
+			store(batch.World[row][3], row == 3 ? one : XMVectorZero());
+		}
 	}
 	else
 	{
-		if (finalTransforms.size() <= parentCount) finalTransforms.emplace_back();
+		for (u32 row{ 0 }; row < 4; ++row)
+		{
+			const xmm p0{ load(batch.Parent[row][0]) };
+			const xmm p1{ load(batch.Parent[row][1]) };
+			const xmm p2{ load(batch.Parent[row][2]) };
+			const xmm p3{ load(batch.Parent[row][3]) };
+			for (u32 col{ 0 }; col < 3; ++col)
+			{
+				xmm v{ XMVectorMultiply(p3, localRows[3][col]) };
+				v = XMVectorMultiplyAdd(p2, localRows[2][col], v);
+				v = XMVectorMultiplyAdd(p1, localRows[1][col], v);
+				v = XMVectorMultiplyAdd(p0, localRows[0][col], v);
+				store(batch.World[row][col], v);
+			}
+			store(batch.World[row][3], p3);
+		}
+	}
+}
+
+// the LocalTransform columns of the block an entity is in, looked up again only when the block changes between entities
+struct BlockColumns
+{
+	const EntityBlock* Block{ nullptr };
+	component::LocalTransformColumns<true> Columns{};
+
+	const component::LocalTransformColumns<true>& Get(EntityBlock* block)
+	{
+		if (block != Block)
+		{
+			Block = block;
+			Columns = block->GetComponentColumns<component::LocalTransform>();
+		}
+		return Columns;
+	}
+};
+
+/*
+* transforms the entities in [begin, end) of a level that moved since the last update, the level above has to be done already
+* an entity moved if its block's LocalTransform was written to, it was marked, added or reparented, or its parent moved
+* only the changed LocalTransforms are copied into the level, the rest of the work streams through the level's arrays
+* the blocks with recomputed entities get their WorldTransform version stamped here, so there's no pass over the entities afterwards
+* returns the number of moved entities
+*/
+template<bool HasParent>
+u32
+UpdateLevelRange(HierarchyLevel& level, const HierarchyLevel* parents, u32 begin, u32 end, u32 sinceVersion, u32 version)
+{
+	assert(begin % SIMD_WIDTH == 0 && end - begin <= HIERARCHY_JOB_SIZE);
+	constexpr ComponentID localTransformID{ component::ID<component::LocalTransform> };
+	u32 moved[HIERARCHY_JOB_SIZE];
+	u32 movedCount{ 0 };
+	BlockColumns blockColumns{};
+	for (u32 i{ begin }; i < end; ++i)
+	{
+		EntityBlock* block{ level.Blocks[i] };
+		if (!block)
+		{
+			const EntityData& data{ scene::GetEntityData(level.Entities[i]) };
+			block = level.Blocks[i] = data.block;
+			level.Rows[i] = data.row;
+			level.WorldTransforms[i] = block->GetComponentArray<component::WorldTransform>() + data.row;
+		}
+
+		u8& flags{ level.UpdateFlags[i] };
+		const bool isChanged{ (flags & UpdateFlags::ForceUpdate) || IsNewerVersion(block->ComponentVersions[localTransformID], sinceVersion) };
+		if (isChanged)
+		{
+			const component::LocalTransformColumns<true>& columns{ blockColumns.Get(block) };
+			const u32 row{ level.Rows[i] };
+			LocalTransformBatch& local{ level.Locals[i / SIMD_WIDTH] };
+			const u32 lane{ i % SIMD_WIDTH };
+			const v3& position{ columns.Position[row] };
+			const quat& rotation{ columns.Rotation[row] };
+			const v3& scale{ columns.Scale[row] };
+			local.Position[0][lane] = position.x;
+			local.Position[1][lane] = position.y;
+			local.Position[2][lane] = position.z;
+			local.Rotation[0][lane] = rotation.x;
+			local.Rotation[1][lane] = rotation.y;
+			local.Rotation[2][lane] = rotation.z;
+			local.Rotation[3][lane] = rotation.w;
+			local.Scale[0][lane] = scale.x;
+			local.Scale[1][lane] = scale.y;
+			local.Scale[2][lane] = scale.z;
+		}
+
+		bool isMoved{ isChanged };
+		if constexpr (HasParent) isMoved = isMoved || parents->Moved[level.ParentIndices[i]];
+		level.Moved[i] = isMoved;
+
+		if (isMoved)
+		{
+			moved[movedCount++] = i;
+			flags = UpdateFlags::MovedLastUpdate;
+		}
+		else if (flags & UpdateFlags::MovedLastUpdate)
+		{
+			// stopped moving, the previous transform catches up so motion vectors go back to zero
+			level.PreviousTransforms[i] = level.WorldTransforms[i]->TRS;
+			flags = UpdateFlags::None;
+		}
+	}
+
+	// whole batches go through the kernel, only the lanes of moved entities are written back
+	TransformBatch batch;
+	const EntityBlock* stampedBlock{ nullptr };
+	for (u32 m{ 0 }; m < movedCount;)
+	{
+		const u32 first{ moved[m] - moved[m] % SIMD_WIDTH };
+		if constexpr (HasParent)
+		{
+			for (u32 lane{ 0 }; lane < SIMD_WIDTH; ++lane)
+			{
+				// the lanes past the end of the level repeat the last entity
+				const u32 i{ std::min(first + lane, end - 1) };
+				assert(level.ParentIndices[i] < parents->Entities.size());
+				const m4x4& parentTrs{ parents->WorldTransforms[level.ParentIndices[i]]->TRS };
+				for (u32 row{ 0 }; row < 4; ++row)
+					for (u32 col{ 0 }; col < 4; ++col) batch.Parent[row][col][lane] = parentTrs.m[row][col];
+			}
+		}
 
-		Vec<EntityFinalTRS>& transforms{ finalTransforms[parentCount] };
-		for (u32 i = 0; i < transforms.size(); ++i)
+		ComputeTransformBatch<HasParent>(level.Locals[first / SIMD_WIDTH], batch);
+		// back to a matrix per lane, every row is a transpose of its four columns
+		m4x4 worlds[SIMD_WIDTH];
+		for (u32 row{ 0 }; row < 4; ++row)
 		{
-			if (finalTRS.ParentIdx < transforms[i].ParentIdx)
+			using namespace DirectX;
+			const auto load{ [](const f32* lanes) { return XMLoadFloat4A((const XMFLOAT4A*)lanes); } };
+			const XMMATRIX rows{ XMMatrixTranspose({ load(batch.World[row][0]), load(batch.World[row][1]), load(batch.World[row][2]), load(batch.World[row][3]) }) };
+			for (u32 lane{ 0 }; lane < SIMD_WIDTH; ++lane) XMStoreFloat4((XMFLOAT4*)worlds[lane].m[row], rows.r[lane]);
+		}
+
+		for (; m < movedCount && moved[m] < first + SIMD_WIDTH; ++m)
+		{
+			const u32 i{ moved[m] };
+			const u32 lane{ i - first };
+			EntityBlock* const block{ level.Blocks[i] };
+			blockColumns.Get(block).Forward[level.Rows[i]] = { batch.Forward[0][lane], batch.Forward[1][lane], batch.Forward[2][lane] }; //TODO: this belong to local transform updates
+
+			m4x4& trs{ level.WorldTransforms[i]->TRS };
+			level.PreviousTransforms[i] = trs;
+			trs = worlds[lane];
+
+			// only the blocks with recomputed transforms count as changed for Changed<WorldTransform>
+			if (block != stampedBlock)
 			{
-				finalTransforms[parentCount].insert(i, finalTRS);
-				entityIndexInLevel = i;
-				return { parentCount, entityIndexInLevel };
+				block->ComponentVersions[component::ID<component::WorldTransform>] = version;
+				stampedBlock = block;
 			}
 		}
+	}
+
+	// the range's moved entities go out in one push
+	Entity movedEntities[HIERARCHY_JOB_SIZE];
+	for (u32 m{ 0 }; m < movedCount; ++m) movedEntities[m] = level.Entities[moved[m]];
+	messages::TransformChangedEvents().Push({ movedEntities, movedCount });
+	return movedCount;
+}
 
-		entityIndexInLevel = transforms.size();
-		transforms.emplace_back(finalTRS);
+// one entity at a time with XMMatrixAffineTransformation, looking every entity up in the scene and reading its LocalTransform from the block,
+// what UpdateLevelRange replaced; only used to compare the two in the ECS benchmarks
+template<bool HasParent>
+u32
+UpdateLevelRangeScalar(HierarchyLevel& level, const HierarchyLevel* parents, u32 begin, u32 end, u32 sinceVersion, u32 version)
+{
+	using namespace DirectX;
+	const xmm forward{ XMVectorSet(0.f, 0.f, 1.f, 0.f) };
+	Entity movedEntities[HIERARCHY_JOB_SIZE];
+	u32 movedCount{ 0 };
+	for (u32 i{ begin }; i < end; ++i)
+	{
+		const Entity entity{ level.Entities[i] };
+		const EntityData& data{ scene::GetEntityData(entity) };
+		level.WorldTransforms[i] = data.block->GetComponentArray<component::WorldTransform>() + data.row;
+
+		u8& flags{ level.UpdateFlags[i] };
+		bool isMoved{ (flags & UpdateFlags::ForceUpdate)
+			|| IsNewerVersion(data.block->ComponentVersions[component::ID<component::LocalTransform>], sinceVersion) };
+		if constexpr (HasParent) isMoved = isMoved || parents->Moved[level.ParentIndices[i]];
+		level.Moved[i] = isMoved;
+		m4x4& trs{ level.WorldTransforms[i]->TRS };
+		if (!isMoved)
+		{
+			if (flags & UpdateFlags::MovedLastUpdate) level.PreviousTransforms[i] = trs;
+			flags = UpdateFlags::None;
+			continue;
+		}
+		flags = UpdateFlags::MovedLastUpdate;
+		movedEntities[movedCount++] = entity;
+
+		const component::LocalTransformColumns<true> columns{ data.block->GetComponentColumns<component::LocalTransform>() };
+		const xmm rotation{ XMLoadFloat4(&columns.Rotation[data.row]) };
+		XMStoreFloat3(&columns.Forward[data.row], XMVector3Normalize(XMVector3Rotate(forward, rotation)));
+
+		level.PreviousTransforms[i] = trs;
+		xmmat world{ XMMatrixAffineTransformation(XMLoadFloat3(&columns.Scale[data.row]), g_XMZero, rotation, XMLoadFloat3(&columns.Position[data.row])) };
+		if constexpr (HasParent) world = XMMatrixMultiply(XMLoadFloat4x4(&parents->WorldTransforms[level.ParentIndices[i]]->TRS), world);
+		XMStoreFloat4x4(&trs, world);
+		data.block->ComponentVersions[component::ID<component::WorldTransform>] = version;
 	}
-	return { parentCount, entityIndexInLevel };
+	messages::TransformChangedEvents().Push({ movedEntities, movedCount });
+	return movedCount;
 }
 
 } // anonymous namespace
 
-void 
+struct HierarchySnapshot
+{
+	Vec<HierarchyLevel> Levels{};
+	Vec<EntityLevelIndex> Locations{};
+	Vec<Entity> ReparentedEntities{};
+	u32 LastUpdateVersion{ 0 };
+};
+
+void
 ValidateHierarchyForEntity(Entity entity)
 {
-	EntityLevelIndex levelIndex{ GetEntityLevelIndex(entity) };
+	//FIXME: right now its assuming each entity must have a transform
+	assert(ecs::scene::EntityHasComponent<ecs::component::WorldTransform>(entity));
+	assert(ecs::scene::EntityHasComponent<ecs::component::LocalTransform>(entity));
 
-	//FIXME: right now its assuming each entity must have a transform, and stuff like _previousTransforms[entity] won't work if i don't create space for each entity
-	/*if(!ecs::scene::EntityHasComponent<ecs::component::LocalTransform>(entity) ||
-		!ecs::scene::EntityHasComponent<ecs::component::WorldTransform>(entity))
+	if (IsInHierarchy(entity))
 	{
-		if(levelIndex.Index != U32_INVALID_ID)
-		{
-			RemoveEntityFromHierarchy(entity);
-		}
+		// moving between blocks doesn't matter anymore, the components are looked up by entity
+		const EntityLevelIndex location{ _locations[id::Index(entity)] };
+		if (_levels[location.Level].Parents[location.Index] != GetParentEntity(entity)) MoveEntityInHierarchy(entity);
 		return;
-	}*/
+	}
 
-	if(levelIndex.Index == U32_INVALID_ID)
+	const Entity parent{ GetParentEntity(entity) };
+	u32 level{ 0 };
+	if (id::IsValid(parent))
 	{
-		levelIndex = AddEntityToHierarchy(entity);
+		// the parent usually got here first, otherwise walk up the chain
+		level = IsInHierarchy(parent) ? _locations[id::Index(parent)].Level + 1 : GetDepth(entity);
 	}
-	else
+	InsertIntoLevel(entity, parent, level);
+}
+
+void
+AddEntitiesToHierarchy(std::span<const Entity> entities, std::span<const Entity> parents)
+{
+	assert(entities.size() == parents.size());
+	// the tables grow once for the whole batch
+	u32 maxIndex{ 0 };
+	for (Entity entity : entities) maxIndex = std::max(maxIndex, (u32)id::Index(entity));
+	if (maxIndex >= _locations.size()) _locations.resize(maxIndex + 1);
+
+	for (u32 i{ 0 }; i < entities.size(); ++i)
 	{
-		//TODO: change parents etc
-		EntityFinalTRS& finalTRS{ FindEntityFinalTRS(levelIndex) };
-		finalTRS.Entity = entity;
-		finalTRS.ParentIdx = levelIndex.Level;
-		finalTRS.WorldTransform = &ecs::scene::GetEntityComponent<ecs::component::WorldTransform>(entity);
-		finalTRS.LocalTransform = &ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(entity);
+		const Entity entity{ entities[i] };
+		const Entity parent{ parents[i] };
+		assert(!IsInHierarchy(entity));
+		u32 level{ 0 };
+		if (id::IsValid(parent)) level = IsInHierarchy(parent) ? _locations[id::Index(parent)].Level + 1 : GetDepth(entity);
+		InsertIntoLevel(entity, parent, level);
 	}
 }
 
 void
-MoveEntityInHierarchy(Entity entity)
+MarkLocalTransformChanged(Entity entity)
 {
+	// entities that aren't in the hierarchy yet are recomputed once they're added anyway
+	if (!IsInHierarchy(entity)) return;
+	const EntityLevelIndex location{ _locations[id::Index(entity)] };
+	_levels[location.Level].UpdateFlags[location.Index] |= UpdateFlags::ForceUpdate;
 }
 
 void
-RemoveEntityFromHierarchy(Entity entity)
+MarkEntityLocationChanged(Entity entity)
 {
-	log::Warn("RemoveEntityFromHierarchy is TODO");
+	if (!IsInHierarchy(entity)) return;
+	const EntityLevelIndex location{ _locations[id::Index(entity)] };
+	_levels[location.Level].Blocks[location.Index] = nullptr;
 }
 
-void 
-UpdateEntityComponents(Entity entity)
+void
+MoveEntityInHierarchy(Entity entity)
 {
-	//TODO: the Entity values might change depending on how i implement generations
-	EntityFinalTRS& entityTransform{ FindEntityFinalTRS(entity) };
-	assert(ecs::scene::EntityHasComponent<ecs::component::WorldTransform>(entity));
-	assert(ecs::scene::EntityHasComponent<ecs::component::LocalTransform>(entity));
-	entityTransform.WorldTransform = &ecs::scene::GetEntityComponent<ecs::component::WorldTransform>(entity);
-	entityTransform.LocalTransform = &ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(entity);
+	assert(IsInHierarchy(entity));
+	const EntityLevelIndex location{ _locations[id::Index(entity)] };
+	HierarchyLevel& level{ _levels[location.Level] };
+	level.Parents[location.Index] = GetParentEntity(entity);
+	level.IsDirty = true;
+	level.UpdateFlags[location.Index] |= UpdateFlags::ForceUpdate;
+	_reparentedEntities.emplace_back(entity);
 }
 
 void
-ReconfigureHierarchy()
+RemoveEntityFromHierarchy(Entity entity)
 {
+	if (!IsInHierarchy(entity)) return;
+	EraseFromLevel(_locations[id::Index(entity)]);
 }
 
-void 
-UpdateHierarchy()
+void
+ReconfigureHierarchy()
 {
-	using namespace DirectX;
-	if (finalTransforms.empty()) return;
-	bool transformChanged{ false };
+	bool depthChanged{ false };
+	for (Entity entity : _reparentedEntities)
+	{
+		if (!IsInHierarchy(entity)) continue;
+		const u32 level{ GetDepth(entity) };
+		if (level == _locations[id::Index(entity)].Level) continue;
+		MoveToLevel(entity, level);
+		depthChanged = true;
+	}
+	_reparentedEntities.clear();
+	if (depthChanged) FixLevelsOfDescendants();
 
-	for (auto& rootTransform : finalTransforms[0])
+	// a re-sorted level changes the parent indices of the one below
+	bool parentsMoved{ false };
+	for (u32 i{ 0 }; i < _levels.size(); ++i)
 	{
-		component::LocalTransform* lt{ rootTransform.LocalTransform };
-		component::WorldTransform* wt{ rootTransform.WorldTransform };
+		HierarchyLevel& level{ _levels[i] };
+		if (!level.IsDirty && !parentsMoved) continue;
+		parentsMoved = SortLevel(i);
+		level.IsDirty = false;
+	}
 
-		xmm scale{ XMLoadFloat3(&lt->Scale) };
-		xmm rot{ XMLoadFloat4(&lt->Rotation) };
-		xmm pos{ XMLoadFloat3(&lt->Position) };
-		xmm dir{ 0.f, 0.f, 1.f, 0.f };
-		XMStoreFloat3(&lt->Forward, XMVector3Normalize(XMVector3Rotate(dir, rot))); //TODO: this belong to local transform updates
+	while (!_levels.empty() && _levels.back().Entities.empty()) _levels.pop_back();
+}
 
-		memcpy(&_previousTransforms[id::Index(rootTransform.Entity)], &wt->TRS, sizeof(m4x4));
-		xmmat trs{XMMatrixAffineTransformation(scale, g_XMZero, rot, pos) };
-		XMStoreFloat4x4(&wt->TRS, trs);
+u32
+UpdateHierarchy()
+{
+	ReconfigureHierarchy();
+	const u32 sinceVersion{ _lastUpdateVersion };
+	const u32 version{ GetWriteVersion() };
+	_lastUpdateVersion = version;
+	if (_levels.empty()) return 0;
+
+	// entities of a level don't depend on each other, so a level is split across the workers
+	const auto updateRoots{ _isScalarUpdate ? UpdateLevelRangeScalar<false> : UpdateLevelRange<false> };
+	const auto updateChildren{ _isScalarUpdate ? UpdateLevelRangeScalar<true> : UpdateLevelRange<true> };
+	std::atomic<u32> movedCount{ 0 };
+	for (u32 levelIndex{ 0 }; levelIndex < _levels.size(); ++levelIndex)
+	{
+		HierarchyLevel& level{ _levels[levelIndex] };
+		const HierarchyLevel* parents{ levelIndex == 0 ? nullptr : &_levels[levelIndex - 1] };
+		level.Moved.resize(level.Entities.size());
+		const auto update{ levelIndex == 0 ? updateRoots : updateChildren };
+		jobs::ParallelFor((u32)level.Entities.size(), HIERARCHY_JOB_SIZE, [&level, parents, update, sinceVersion, version, &movedCount](u32 begin, u32 end) {
+			movedCount.fetch_add(update(level, parents, begin, end, sinceVersion, version), std::memory_order_relaxed);
+			});
 	}
 
-	for (u32 level{ 1 }; level < finalTransforms.size(); ++level)
+	const u32 moved{ movedCount.load(std::memory_order_relaxed) };
+	messages::SetMessage(messages::SystemBoolMessage::TransformChanged, moved != 0);
+	return moved;
+}
+
+void
+SetScalarUpdate(bool isScalar)
+{
+	if (_isScalarUpdate && !isScalar)
 	{
-		auto& transforms{ finalTransforms[level] };
-		auto& parents{ finalTransforms[level - 1] };
-		for (auto& finalTRS : transforms)
+		// the scalar update reads the blocks directly and leaves the level copies behind
+		for (HierarchyLevel& level : _levels)
 		{
-			assert(finalTRS.ParentIdx < parents.size());
-			component::WorldTransform* parentWt{ parents[finalTRS.ParentIdx].WorldTransform};
-
-			component::LocalTransform* lt{ finalTRS.LocalTransform };
-			component::WorldTransform* wt{ finalTRS.WorldTransform };
-			
-			xmm scale{ XMLoadFloat3(&lt->Scale) };
-			xmm rot{ XMLoadFloat4(&lt->Rotation) };
-			xmm pos{ XMLoadFloat3(&lt->Position) };
-			xmm dir{ 0.f, 0.f, 1.f, 0.f };
-			XMStoreFloat3(&lt->Forward, XMVector3Normalize(XMVector3Rotate(dir, rot))); //TODO: this belong to local transform updates
-
-			memcpy(&_previousTransforms[id::Index(finalTRS.Entity)], &wt->TRS, sizeof(m4x4));
-			xmmat trs{XMMatrixAffineTransformation(scale, g_XMZero, rot, pos) };
-			xmmat parentTrs{ XMLoadFloat4x4(&parentWt->TRS) };
-			trs = XMMatrixMultiply(parentTrs, trs);
-			XMStoreFloat4x4(&wt->TRS, trs);
+			for (u8& flags : level.UpdateFlags) flags |= UpdateFlags::ForceUpdate;
 		}
 	}
-
-	messages::SetMessage(messages::SystemBoolMessage::TransformChanged, transformChanged);
+	_isScalarUpdate = isScalar;
 }
 
-void 
+void
 DeleteHierarchy()
 {
-	finalTransforms.clear();
+	_levels.clear();
+	_locations.clear();
+	_reparentedEntities.clear();
+}
+
+HierarchySnapshot*
+SaveHierarchy()
+{
+	return new HierarchySnapshot{ _levels, _locations, _reparentedEntities, _lastUpdateVersion };
+}
+
+void
+RestoreHierarchy(HierarchySnapshot* snapshot)
+{
+	assert(snapshot);
+	_levels = std::move(snapshot->Levels);
+	_locations = std::move(snapshot->Locations);
+	_reparentedEntities = std::move(snapshot->ReparentedEntities);
+	_lastUpdateVersion = snapshot->LastUpdateVersion;
+	delete snapshot;
+	// the restored world has its own blocks
+	for (HierarchyLevel& level : _levels) std::fill(level.Blocks.begin(), level.Blocks.end(), nullptr);
+}
+
+void
+DestroyHierarchySnapshot(HierarchySnapshot* snapshot)
+{
+	delete snapshot;
+}
+
+EntityLevelIndex
+GetEntityLevelIndex(Entity entity)
+{
+	return IsInHierarchy(entity) ? _locations[id::Index(entity)] : EntityLevelIndex{};
 }
 
 const m4x4* const
 GetPreviousTransform(Entity entity)
 {
-	assert(id::Index(entity) < _previousTransforms.size());
-	return &_previousTransforms[id::Index(entity)];
+	// not added yet, so it didn't move
+	if (!IsInHierarchy(entity)) return &scene::GetEntityComponent<component::WorldTransform>(entity).TRS;
+	const EntityLevelIndex location{ _locations[id::Index(entity)] };
+	return &_levels[location.Level].PreviousTransforms[location.Index];
 }
 
 
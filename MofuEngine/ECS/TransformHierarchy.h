@@ -2,29 +2,55 @@
 #include "CommonHeaders.h"
 #include "Entity.h"
 #include "Transform.h"
+#include <span>
 
 namespace mofu::ecs::transform {
 
-struct EntityFinalTRS
+struct EntityLevelIndex
 {
-	u32 ParentIdx;
-	Entity Entity;
-//	m4x4 TRS;
-	component::WorldTransform* WorldTransform;
-	component::LocalTransform* LocalTransform;
+	u32 Level{ U32_INVALID_ID };
+	u32 Index{ U32_INVALID_ID };
 };
 
 //void AddEntityToHierarchy(Entity entity);
+// adds the entity or picks up a new parent, called for spawned and moved entities
 void ValidateHierarchyForEntity(Entity entity);
+// the entity's Child::ParentEntity changed, the levels get fixed up in ReconfigureHierarchy
 void MoveEntityInHierarchy(Entity entity);
+//NOTE: children have to be removed before their parent
 void RemoveEntityFromHierarchy(Entity entity);
-void UpdateEntityComponents(Entity entity);
+// adds new entities whose parents are already known, like prefab copies, without going through the deferred spawns
+// NOTE: a parent has to be in the hierarchy already or come before its children
+void AddEntitiesToHierarchy(std::span<const Entity> entities, std::span<const Entity> parents);
 
+// the entity's LocalTransform was written without stamping its block, only this entity gets recomputed in the next update
+// NOTE: for writers that touch a few entities of mixed blocks, like the physics write-back; different entities can be marked from several threads
+void MarkLocalTransformChanged(Entity entity);
+// the entity got another block or row, the hierarchy keeps where its entities are and looks this one up again in the next update
+// NOTE: the scene calls it for every moved row of the main world (see scene::ValidateTransform)
+void MarkEntityLocationChanged(Entity entity);
+
+// applies the batched changes: moves reparented entities between levels and re-sorts the dirty levels by parent
 void ReconfigureHierarchy();
-void UpdateHierarchy(); // NOTE: called at the end of the frame, after all local transforms have been updated 
+// NOTE: runs in TransformSystem in the Update group, after the pre-update systems and the physics write-back
+// only recomputes entities marked with MarkLocalTransformChanged or in blocks whose LocalTransform changed since the last update
+// (and their children), returns how many moved
+u32 UpdateHierarchy();
+// UpdateHierarchy computes one entity at a time with XMMatrixAffineTransformation instead of four at a time,
+// only for comparing the two in the ECS benchmarks
+void SetScalarUpdate(bool isScalar);
 
 // when unloading a scene
 void DeleteHierarchy();
 
+// the hierarchy tables saved with a clone of the world, a clone keeps the entity ids so the tables are copied as they are
+struct HierarchySnapshot;
+[[nodiscard]] HierarchySnapshot* SaveHierarchy();
+// puts the saved tables back and frees the snapshot
+void RestoreHierarchy(HierarchySnapshot* snapshot);
+void DestroyHierarchySnapshot(HierarchySnapshot* snapshot);
+
+// INVALID if the entity isn't in the hierarchy, the index is only stable until the next ReconfigureHierarchy
+EntityLevelIndex GetEntityLevelIndex(Entity entity);
 const m4x4* const GetPreviousTransform(Entity entity);
-}
\ No newline at end of file
+}
@@ -18,6 +18,12 @@
 #include "Physics/BodyManager.h"
 #include "Physics/PhysicsShapes.h"
 #include "Physics/PhysicsCore.h"
+#include "ECS/SceneSnapshot.h"
+#include "ECS/PrefabTemplate.h"
+#include "ECS/EditorMetadata.h"
+#include "Utilities/IOStream.h"
+#include <fstream>
+#include <Windows.h>
 
 namespace mofu::editor::assets {
 namespace {
@@ -66,6 +72,7 @@ SerializeEntityHierarchy(YAML::Emitter& out, const Vec<ecs::Entity>& entities)
 		{
 			out << c;
 		}
+		ecs::scene::ForEachSparseComponent(entity, [&out](ecs::ComponentID cid) { out << cid; });
 		out << YAML::EndSeq;
 
 		if (block->Signature.test(ecs::component::ID<ecs::component::Parent>))
@@ -75,7 +82,7 @@ SerializeEntityHierarchy(YAML::Emitter& out, const Vec<ecs::Entity>& entities)
 		}
 		else
 		{
-			if (lastParent.top().first != ecs::scene::GetComponent<ecs::component::Child>(entity).ParentEntity)
+			if (lastParent.top().first != ecs::scene::GetComponentRO<ecs::component::Child>(entity).ParentEntity)
 			{
 				lastParent.pop();
 			}
@@ -86,9 +93,13 @@ SerializeEntityHierarchy(YAML::Emitter& out, const Vec<ecs::Entity>& entities)
 			out << YAML::Key << "Components";
 			out << YAML::Value << YAML::BeginMap;
 
-			ecs::ForEachComponent(block, entityData.row, [&out](ecs::ComponentID cid, u8* data) {
+			ecs::ForEachComponent(block, entityData.row, [&out, entity](ecs::ComponentID cid, u8* data) {
 				out << YAML::Key << ecs::component::ComponentNames[cid];
-				ecs::component::SerializeLUT[cid](out, data);
+				ecs::component::SerializeLUT[cid](out, entity, data);
+				});
+			// sparse components are tags, only the name is saved
+			ecs::scene::ForEachSparseComponent(entity, [&out](ecs::ComponentID cid) {
+				out << YAML::Key << ecs::component::ComponentNames[cid] << YAML::Value << YAML::Null;
 				});
 			out << YAML::EndMap;
 		} // Components
@@ -108,24 +119,77 @@ SerializeEntityHierarchy(YAML::Emitter& out, const Vec<ecs::Entity>& entities)
 	out << YAML::EndMap;
 }
 
+// every RenderMesh of a hierarchy is a submesh of the geometry the first one was created from, in order
+// creates that geometry, the materials, render items and physics bodies from the entities' asset handles
 void
-DeserializeEntityHierarchy(const YAML::Node& entityHierarchyData, Vec<ecs::Entity>& entities)
+CreateHierarchyResources(const Vec<ecs::Entity>& entities)
 {
 	using namespace ecs;
 
-	//TODO: think of something better?
-	struct RenderableEntitySpawnContext
+	Vec<Entity> renderables{};
+	for (Entity entity : entities)
 	{
-		ecs::Entity	entity;
-		ecs::component::RenderMesh& Mesh;
-		ecs::component::RenderMaterial& Material;
+		if (scene::HasComponent<component::RenderMesh>(entity)) renderables.emplace_back(entity);
+	}
+	if (renderables.empty()) return;
+
+	const content::AssetHandle parentGeometryHandle{ metadata::GetAssets(renderables[0]).Mesh };
+	id_t geometry{ content::assets::CreateResourceFromHandle(parentGeometryHandle) };
+	const content::UploadedGeometryInfo uploadedGeometryInfo{ content::GetLastUploadedGeometryInfo() };
+	assert(uploadedGeometryInfo.SubmeshCount == renderables.size()); //TODO: for now thats true
+	u32 i{ 0 };
+	for (Entity entity : renderables)
+	{
+		// saved bounds get replaced by the ones of the uploaded submesh, adding the component moves the entity so it goes first
+		if (!scene::HasComponent<component::CullableObject>(entity)) scene::AddComponents<component::CullableObject>(entity);
+		scene::GetComponent<component::CullableObject>(entity).obb = uploadedGeometryInfo.SubmeshBounds[i];
+
+		component::RenderMesh& mesh{ scene::GetComponent<component::RenderMesh>(entity) };
+		component::RenderMaterial& material{ scene::GetComponent<component::RenderMaterial>(entity) };
+		mesh.MeshID = uploadedGeometryInfo.SubmeshGpuIDs[i++];
+		metadata::EntityAssets& assets{ metadata::GetAssets(entity) };
+
+		if (content::IsValid(assets.Material))
+		{
+			material.MaterialID = content::assets::GetResourceFromAsset(assets.Material, content::AssetType::Material, false);
+			if (!id::IsValid(material.MaterialID))
+			{
+				// load a new material
+				graphics::MaterialInitInfo mat{};
+				material::LoadMaterialDataFromAsset(mat, assets.Material);
+				material.MaterialID = content::CreateMaterial(mat, assets.Material);
+			}
+		}
+		else
+		{
+			material.MaterialID = content::GetDefaultMaterial();
+			assets.Material = content::assets::GetAssetFromResource(material.MaterialID, content::AssetType::Material);
+		}
+		// disabled entities get their render item once they're enabled
+		if (scene::IsEntityEnabledIn(entity))
+			mesh.RenderItemID = graphics::AddRenderItem(entity, mesh.MeshID, material.MaterialCount, material.MaterialID);
 #if RAYTRACING
-		ecs::component::PathTraceable& PathTraceable;
+		scene::GetComponent<component::PathTraceable>(entity).MeshInfo = graphics::d3d12::content::geometry::GetMeshInfo(mesh.MeshID);
 #endif
-		bool hasCollider;
-		ecs::component::Collider& Collider;
-	};
-	Vec<RenderableEntitySpawnContext> renderables{};
+
+		if (scene::HasComponent<component::Collider>(entity))
+		{
+			assert(content::IsValid(assets.Shape));
+			JPH::Ref<JPH::Shape> physicsShape{ physics::shapes::LoadShape(assets.Shape) };
+			if (scene::HasComponent<component::StaticObject>(entity))
+				physics::AddStaticBody(physicsShape, entity);
+			else
+				physics::AddDynamicBody(physicsShape, entity);
+		}
+	}
+	// TODO: needed for materials, force this somewhere
+	content::assets::PairAssetWithResource(parentGeometryHandle, uploadedGeometryInfo.GeometryContentID, content::AssetType::Mesh);
+}
+
+void
+DeserializeEntityHierarchy(const YAML::Node& entityHierarchyData, Vec<ecs::Entity>& entities)
+{
+	using namespace ecs;
 
 	// TODO: prefab handle system if needed
 	Guid prefabID{ entityHierarchyData["Prefab"].as<u64>() };
@@ -150,7 +214,7 @@ DeserializeEntityHierarchy(const YAML::Node& entityHierarchyData, Vec<ecs::Entit
 #endif
 
 		const EntityData& entityData{ ecs::scene::SpawnEntity(mask) };
-		const EntityBlock* block{ entityData.block };
+		EntityBlock* block{ entityData.block };
 		Entity entity{ entityData.id };
 
 		const YAML::Node& components{ componentInfo["Components"] };
@@ -159,91 +223,279 @@ DeserializeEntityHierarchy(const YAML::Node& entityHierarchyData, Vec<ecs::Entit
 		for (auto component : components)
 		{
 			ComponentID cid{ cids[i++] };
+			if (component::IsSparseComponent(cid)) continue; // a tag without data, already added with the mask
 			auto componentData{ component.second };
-			u32 offset = block->ComponentOffsets[cid] + component::GetComponentSize(cid) * entityData.row;
-			component::DeserializeLUT[cid](componentData, block->ComponentData + offset);
+			if (component::GetColumnFields(cid).size() == 1)
+			{
+				u32 offset = block->ComponentOffsets[cid] + component::GetComponentSize(cid) * entityData.row;
+				component::DeserializeLUT[cid](componentData, entity, block->ComponentData + offset);
+				continue;
+			}
+			// a split component is read into a packed copy and written back field by field
+			alignas(16) u8 data[MAX_SPLIT_COMPONENT_SIZE];
+			ReadComponentRow(block, cid, entityData.row, data);
+			component::DeserializeLUT[cid](componentData, entity, data);
+			WriteComponentRow(block, cid, entityData.row, data);
 		}
 
 		entities.emplace_back(entity);
-
-		if (mask.test(component::ID<component::RenderMesh>))
-		{
-			component::RenderMesh& mesh{ ecs::scene::GetComponent<component::RenderMesh>(entity) };
-			component::RenderMaterial& material{ ecs::scene::GetComponent<component::RenderMaterial>(entity) };
-			component::Collider col{};
-#if RAYTRACING
-			component::PathTraceable& pt{ ecs::scene::GetComponent<component::PathTraceable>(entity) };
-			renderables.emplace_back(entity, mesh, material, pt, false, col); //FIXME: doesn't work with submeshes
-#else
-			renderables.emplace_back(entity, mesh, material, false, col); //FIXME: doesn't work with submeshes
-#endif
-		}
-
-		if (mask.test(component::ID<component::Collider>))
-		{
-			component::Collider& collider{ ecs::scene::GetComponent<component::Collider>(entity) };
-			renderables.back().Collider = collider;
-			renderables.back().hasCollider = true;
-		}
 	} // Entities
 
 	auto parentNodes{ entityHierarchyData["Parents"] };
 	{
-		//TODO: noly works if its the only thing adding entities at the moment and if all the entities are from the same generation
-		Entity firstParentID{ entities[0] };
+		// parents are stored as indices into the loaded entities, the entity ids themselves can be recycled ones
 		//NOTE: assumes the first entity is never a child
 		for (u32 i{ 1 }; i < entities.size(); ++i)
 		{
-			Entity parentID{ id::Index(firstParentID) + parentNodes[i].as<u32>() };
+			Entity parentID{ entities[parentNodes[i].as<u32>()] };
 			ecs::scene::GetComponent<component::Child>(entities[i]).ParentEntity = parentID;
 		}
 	} // Parents
 
-	if (!renderables.empty())
+	CreateHierarchyResources(entities);
+}
+
+struct PrefabBody
+{
+	u32 Index; // template index
+	JPH::Ref<JPH::Shape> Shape;
+	bool IsStatic;
+};
+
+// a prefab is parsed and given its resources once, later copies come from the template and share the geometry, materials and shapes
+struct CompiledPrefab
+{
+	ecs::prefab::PrefabTemplate Template{};
+	Vec<std::pair<u32, ecs::metadata::EntityAssets>> Assets{}; // by template index, only the entities that have them
+	Vec<u32> Renderables{}; // template indices of the RenderMesh entities
+	Vec<PrefabBody> Bodies{};
+};
+
+// by canonical path
+HashMap<std::string, CompiledPrefab> _compiledPrefabs{};
+
+std::string
+GetPrefabKey(const std::filesystem::path& path)
+{
+	std::error_code error{};
+	const std::filesystem::path canonical{ std::filesystem::weakly_canonical(path, error) };
+	return error ? path.string() : canonical.string();
+}
+
+// the entities' resources have to exist already, the copies only take their ids
+void
+CompilePrefab(const Vec<ecs::Entity>& entities, CompiledPrefab& outPrefab)
+{
+	using namespace ecs;
+
+	prefab::Compile(entities, outPrefab.Template);
+	for (u32 i{ 0 }; i < entities.size(); ++i)
 	{
-		const content::AssetHandle parentGeometryHandle{ renderables[0].Mesh.MeshAsset };
-		id_t geometry{ content::assets::CreateResourceFromHandle(parentGeometryHandle) };
-		const content::UploadedGeometryInfo uploadedGeometryInfo{ content::GetLastUploadedGeometryInfo() };
-		assert(uploadedGeometryInfo.SubmeshCount == renderables.size()); //TODO: for now thats true
-		u32 i{ 0 };
-		for (auto& e : renderables)
+		const Entity entity{ entities[i] };
+		const metadata::EntityAssets* const assets{ metadata::TryGetAssets(entity) };
+		if (assets) outPrefab.Assets.emplace_back(i, *assets);
+		if (scene::HasComponent<component::RenderMesh>(entity)) outPrefab.Renderables.emplace_back(i);
+		if (!scene::HasComponent<component::Collider>(entity)) continue;
+		if (!assets || !content::IsValid(assets->Shape))
 		{
-			e.Mesh.MeshID = uploadedGeometryInfo.SubmeshGpuIDs[i++];
-			
-			if (content::IsValid(e.Material.MaterialAsset))
-			{
-				e.Material.MaterialID = content::assets::GetResourceFromAsset(e.Material.MaterialAsset, content::AssetType::Material, false);
-				if (!id::IsValid(e.Material.MaterialID))
-				{
-					// load a new material
-					graphics::MaterialInitInfo mat{};
-					material::LoadMaterialDataFromAsset(mat, e.Material.MaterialAsset);
-					e.Material.MaterialID = content::CreateMaterial(mat, e.Material.MaterialAsset);
-				}
-			}
-			else
-			{
-				e.Material.MaterialID = content::GetDefaultMaterial();
-				e.Material.MaterialAsset = content::assets::GetAssetFromResource(e.Material.MaterialID, content::AssetType::Material);
-			}
-			e.Mesh.RenderItemID = graphics::AddRenderItem(e.entity, e.Mesh.MeshID, e.Material.MaterialCount, e.Material.MaterialID);
-#if RAYTRACING
-			e.PathTraceable.MeshInfo = graphics::d3d12::content::geometry::GetMeshInfo(e.Mesh.MeshID);
-#endif
+			log::Warn("CompilePrefab: the collider of entity %u has no shape asset, its copies won't get a body", (u32)entity);
+			continue;
+		}
+		outPrefab.Bodies.emplace_back(PrefabBody{ i, physics::shapes::LoadShape(assets->Shape), scene::HasComponent<component::StaticObject>(entity) });
+	}
+}
 
-			if (e.hasCollider)
-			{
-				assert(content::IsValid(e.Collider.ShapeAsset));
-				JPH::Ref<JPH::Shape> physicsShape{ physics::shapes::LoadShape(e.Collider.ShapeAsset) };
-				if(ecs::scene::HasComponent<ecs::component::StaticObject>(e.entity))
-					physics::AddStaticBody(physicsShape, e.entity);
-				else
-					physics::AddDynamicBody(physicsShape, e.entity);
-			}
+void
+InstantiateCompiledPrefab(const CompiledPrefab& prefab, u32 count, Vec<ecs::Entity>& entities)
+{
+	using namespace ecs;
+
+	const u32 firstEntity{ (u32)entities.size() };
+	prefab::Instantiate(prefab.Template, count, entities);
+
+	const u32 entityCount{ prefab.Template.EntityCount };
+	Vec<physics::SavedBody> bodies{};
+	bodies.reserve(prefab.Bodies.size() * count);
+	for (u32 copy{ 0 }; copy < count; ++copy)
+	{
+		const Entity* const copyEntities{ entities.data() + firstEntity + entityCount * copy };
+		for (const auto& [index, assets] : prefab.Assets) metadata::GetAssets(copyEntities[index]) = assets;
+		for (u32 index : prefab.Renderables)
+		{
+			const Entity entity{ copyEntities[index] };
+			// disabled entities get their render item once they're enabled
+			if (!scene::IsEntityEnabledIn(entity)) continue;
+			component::RenderMesh& mesh{ scene::GetComponent<component::RenderMesh>(entity) };
+			const component::RenderMaterial& material{ scene::GetComponent<component::RenderMaterial>(entity) };
+			mesh.RenderItemID = graphics::AddRenderItem(entity, mesh.MeshID, material.MaterialCount, material.MaterialID);
+		}
+		for (const PrefabBody& body : prefab.Bodies) bodies.emplace_back(physics::SavedBody{ copyEntities[body.Index], body.Shape, body.IsStatic });
+	}
+	physics::CreatePhysicsBodies(bodies);
+}
+
+// read-only view of a whole file
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::filesystem::path& path)
+	{
+		_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) return;
+		_mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping) return;
+		_data = (const u8*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (_data) _size = (u64)size.QuadPart;
+	}
+
+	~MappedFile()
+	{
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+	}
+
+	DISABLE_COPY_AND_MOVE(MappedFile);
+
+	[[nodiscard]] const u8* Data() const { return _data; }
+	[[nodiscard]] u64 Size() const { return _size; }
+
+private:
+	HANDLE _file{ INVALID_HANDLE_VALUE };
+	HANDLE _mapping{ nullptr };
+	const u8* _data{ nullptr };
+	u64 _size{ 0 };
+};
+
+/*
+* the binary scene is the ecs snapshot followed by the editor data:
+* the hierarchies as snapshot indices, then the asset handles of the entities that have any
+*/
+void
+WriteSceneSnapshot(const Vec<Vec<ecs::Entity>>& hierarchies, const std::filesystem::path& path)
+{
+	using namespace ecs;
+
+	Vec<Entity> entities{};
+	for (const Vec<Entity>& hierarchy : hierarchies)
+	{
+		for (Entity entity : hierarchy) entities.emplace_back(entity);
+	}
+
+	u32 assetCount{ 0 };
+	for (Entity entity : entities) assetCount += metadata::TryGetAssets(entity) != nullptr;
+	const u64 snapshotSize{ snapshot::GetSnapshotSize(entities) };
+	const u64 size{ snapshotSize + sizeof(u32) * (1 + hierarchies.size() + entities.size())
+		+ sizeof(u32) + (sizeof(u32) + sizeof(u64) * 3) * assetCount };
+	std::unique_ptr<u8[]> buffer{ std::make_unique<u8[]>(size) };
+	util::BlobStreamWriter writer{ buffer.get(), size };
+
+	Vec<Entity> snapshotEntities{};
+	snapshot::WriteSnapshot(writer, entities, snapshotEntities);
+	HashMap<id_t, u32> snapshotIndices{};
+	for (u32 i{ 0 }; i < snapshotEntities.size(); ++i) snapshotIndices.emplace((id_t)snapshotEntities[i], i);
+
+	writer.Write<u32>((u32)hierarchies.size());
+	for (const Vec<Entity>& hierarchy : hierarchies)
+	{
+		writer.Write<u32>((u32)hierarchy.size());
+		for (Entity entity : hierarchy) writer.Write<u32>(snapshotIndices[(id_t)entity]);
+	}
+
+	// the runtime resource ids in the columns are stale after loading, they get recreated from these
+	writer.Write<u32>(assetCount);
+	for (u32 i{ 0 }; i < snapshotEntities.size(); ++i)
+	{
+		const metadata::EntityAssets* const assets{ metadata::TryGetAssets(snapshotEntities[i]) };
+		if (!assets) continue;
+		writer.Write<u32>(i);
+		writer.Write<u64>(assets->Mesh);
+		writer.Write<u64>(assets->Material);
+		writer.Write<u64>(assets->Shape);
+	}
+	assert(writer.Offset() == size);
+
+	std::ofstream file{ path, std::ios::out | std::ios::binary };
+	file.write((const char*)buffer.get(), size);
+}
+
+// the hierarchies and asset handles saved after the snapshot, every index has to point at one of its entities
+bool
+ValidateSnapshotExtras(const u8* data, u64 size, u32 entityCount)
+{
+	util::BlobStreamReader reader{ data };
+	const auto fits{ [&reader, size](u64 bytes) { return bytes <= size - reader.Offset(); } };
+
+	if (!fits(sizeof(u32))) return false;
+	const u32 hierarchyCount{ reader.Read<u32>() };
+	for (u32 h{ 0 }; h < hierarchyCount; ++h)
+	{
+		if (!fits(sizeof(u32))) return false;
+		const u32 count{ reader.Read<u32>() };
+		if (!fits(sizeof(u32) * (u64)count)) return false;
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			if (reader.Read<u32>() >= entityCount) return false;
 		}
-		// TODO: needed for materials, force this somewhere
-		content::assets::PairAssetWithResource(parentGeometryHandle, uploadedGeometryInfo.GeometryContentID, content::AssetType::Mesh);
 	}
+
+	if (!fits(sizeof(u32))) return false;
+	const u32 assetCount{ reader.Read<u32>() };
+	if (!fits((sizeof(u32) + sizeof(u64) * 3) * (u64)assetCount)) return false;
+	for (u32 i{ 0 }; i < assetCount; ++i)
+	{
+		if (reader.Read<u32>() >= entityCount) return false;
+		reader.Skip(sizeof(u64) * 3);
+	}
+	return reader.Offset() == size;
+}
+
+// false if there's no usable snapshot, nothing is loaded then
+bool
+LoadSceneSnapshot(Vec<Vec<ecs::Entity>>& hierarchies, const std::filesystem::path& path)
+{
+	using namespace ecs;
+
+	const MappedFile file{ path };
+	if (!file.Data()) return false;
+	// the whole file is checked before any entity gets created
+	u32 entityCount{ 0 };
+	u64 snapshotSize{ 0 };
+	if (!snapshot::ValidateSnapshot(file.Data(), file.Size(), entityCount, snapshotSize)) return false;
+	if (!ValidateSnapshotExtras(file.Data() + snapshotSize, file.Size() - snapshotSize, entityCount))
+	{
+		log::Warn("LoadSceneSnapshot: the hierarchies or assets saved with the snapshot are damaged");
+		return false;
+	}
+
+	util::BlobStreamReader reader{ file.Data() };
+	Vec<Entity> entities{};
+	if (!snapshot::ReadSnapshot(reader, file.Size(), entities)) return false;
+
+	const u32 hierarchyCount{ reader.Read<u32>() };
+	for (u32 h{ 0 }; h < hierarchyCount; ++h)
+	{
+		hierarchies.emplace_back();
+		Vec<Entity>& hierarchy{ hierarchies.back() };
+		const u32 count{ reader.Read<u32>() };
+		hierarchy.reserve(count);
+		for (u32 i{ 0 }; i < count; ++i) hierarchy.emplace_back(entities[reader.Read<u32>()]);
+	}
+
+	const u32 assetCount{ reader.Read<u32>() };
+	for (u32 i{ 0 }; i < assetCount; ++i)
+	{
+		metadata::EntityAssets& assets{ metadata::GetAssets(entities[reader.Read<u32>()]) };
+		assets.Mesh = content::AssetHandle{ reader.Read<u64>() };
+		assets.Material = content::AssetHandle{ reader.Read<u64>() };
+		assets.Shape = content::AssetHandle{ reader.Read<u64>() };
+	}
+	assert(reader.Offset() == file.Size());
+
+	for (const Vec<Entity>& hierarchy : hierarchies) CreateHierarchyResources(hierarchy);
+	return true;
 }
 } // anonymous namespace
 
@@ -269,6 +521,7 @@ DropModelIntoScene(std::filesystem::path modelPath, u32* materials /* = nullptr
 	ecs::component::WorldTransform wt{};
 	ecs::component::RenderMaterial material{};
 	ecs::component::RenderMesh mesh{};
+	ecs::component::CullableObject cullable{};
 	ecs::component::NameComponent name{};
 #if RAYTRACING
 	ecs::component::PathTraceable pt{};
@@ -276,9 +529,9 @@ DropModelIntoScene(std::filesystem::path modelPath, u32* materials /* = nullptr
 
 	// root
 	mesh.MeshID = uploadedGeometryInfo.GeometryContentID;
+	cullable.obb = uploadedGeometryInfo.SubmeshBounds[0];
 	material.MaterialCount = 1;
 	material.MaterialID = hasMaterials ? materials[0] : defaultMat;
-	material.MaterialAsset = content::assets::GetAssetFromResource(material.MaterialID, content::AssetType::Material);
 
 	struct RenderableEntitySpawnContext
 	{
@@ -300,14 +553,14 @@ DropModelIntoScene(std::filesystem::path modelPath, u32* materials /* = nullptr
 #if RAYTRACING
 	pt.MeshInfo = graphics::d3d12::content::geometry::GetMeshInfo(mesh.MeshID);
 	ecs::EntityData& rootEntityData{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Parent, ecs::component::NameComponent,
+		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Parent, ecs::component::NameComponent,
 	ecs::component::PathTraceable>(
-			lt, wt, mesh, material, parentEntity, name, pt) };
+			lt, wt, mesh, material, cullable, parentEntity, name, pt) };
 	spawnedEntities[0] = { rootEntityData.id, mesh, material, false, pt};
 #else
 	ecs::EntityData& rootEntityData{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Parent, ecs::component::NameComponent>(
-			lt, wt, mesh, material, parentEntity, name) };
+		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Parent, ecs::component::NameComponent>(
+			lt, wt, mesh, material, cullable, parentEntity, name) };
 	spawnedEntities[0] = { rootEntityData.id, mesh, material, false };
 #endif
 
@@ -322,22 +575,22 @@ DropModelIntoScene(std::filesystem::path modelPath, u32* materials /* = nullptr
 		mesh.MeshID = meshId;
 		material.MaterialID = hasMaterials ? materials[i] : defaultMat;
 		material.MaterialCount = 1;
-		material.MaterialAsset = content::assets::GetAssetFromResource(material.MaterialID, content::AssetType::Material);
+		cullable.obb = uploadedGeometryInfo.SubmeshBounds[i];
 		snprintf(name.Name, ecs::component::NAME_LENGTH, "child %u", i);
 
 #if RAYTRACING
 		pt.MeshInfo = graphics::d3d12::content::geometry::GetMeshInfo(mesh.MeshID);
 		ecs::EntityData& e{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Child, ecs::component::NameComponent,
+			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Child, ecs::component::NameComponent,
 		ecs::component::PathTraceable>(
-				lt, wt, mesh, material, child, name, pt) };
-		assert(ecs::scene::GetComponent<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
+				lt, wt, mesh, material, cullable, child, name, pt) };
+		assert(ecs::scene::GetComponentRO<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
 		spawnedEntities[i] = { e.id, mesh, material, true, child, pt };
 #else
 		ecs::EntityData& e{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Child, ecs::component::NameComponent>(
-				lt, wt, mesh, material, child, name) };
-		assert(ecs::scene::GetComponent<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
+			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Child, ecs::component::NameComponent>(
+				lt, wt, mesh, material, cullable, child, name) };
+		assert(ecs::scene::GetComponentRO<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
 		spawnedEntities[i] = { e.id, mesh, material, true, child };
 #endif
 	}
@@ -347,10 +600,11 @@ DropModelIntoScene(std::filesystem::path modelPath, u32* materials /* = nullptr
 		if (c.isChild)
 		{
 			assert(c.child.ParentEntity == child.ParentEntity);
-			assert(ecs::scene::GetComponent<ecs::component::Child>(c.entity).ParentEntity == child.ParentEntity);
+			assert(ecs::scene::GetComponentRO<ecs::component::Child>(c.entity).ParentEntity == child.ParentEntity);
 		}
 		ecs::component::RenderMesh& mesh{ ecs::scene::GetComponent<ecs::component::RenderMesh>(c.entity) };
 		mesh.RenderItemID = graphics::AddRenderItem(c.entity, c.Mesh.MeshID, c.Material.MaterialCount, c.Material.MaterialID);
+		ecs::metadata::GetAssets(c.entity).Material = content::assets::GetAssetFromResource(c.Material.MaterialID, content::AssetType::Material);
 		editor::AddEntityToSceneView(c.entity);
 	}
 }
@@ -378,7 +632,7 @@ SerializeEntityHierarchy(const Vec<ecs::Entity>& entities)
 	using namespace ecs;
 
 	Entity parent{ entities.front() };
-	const char* parentName{ scene::GetComponent<component::NameComponent>(parent).Name };
+	const char* parentName{ scene::GetComponentRO<component::NameComponent>(parent).Name };
 	std::string prefabFilename{ parentName };
 	prefabFilename += content::PREFAB_FILE_EXTENSION;
 	const std::filesystem::path resourcesPath{ mofu::editor::project::GetResourceDirectory() };
@@ -390,13 +644,14 @@ SerializeEntityHierarchy(const Vec<ecs::Entity>& entities)
 
 	std::ofstream outFile(prefabPath);
 	outFile << out.c_str();
+	outFile.close();
+	// the next instantiation compiles the saved version
+	_compiledPrefabs.erase(GetPrefabKey(prefabPath));
 }
 
 void
 SerializeScene(const ecs::scene::Scene& scene, const Vec<Vec<ecs::Entity>>& hierarchies)
 {
-	//TODO: maybe it makes sense to serialize by blocks for performance
-
 	/*for(auto [entity, parent]
 		: ecs::scene::GetRW<ecs::component::Parent>())
 	{
@@ -427,6 +682,10 @@ SerializeScene(const ecs::scene::Scene& scene, const Vec<Vec<ecs::Entity>>& hier
 
 	std::ofstream outFile(scenePath);
 	outFile << out.c_str();
+	outFile.close();
+
+	// the binary snapshot is what gets loaded, the yaml stays as the readable version, so it's written last to be the newer file
+	WriteSceneSnapshot(hierarchies, std::filesystem::path{ scenePath }.replace_extension(content::SCENE_SNAPSHOT_FILE_EXTENSION));
 }
 
 void
@@ -436,6 +695,16 @@ LoadScene(Vec<Vec<ecs::Entity>>& hierarchies, const std::filesystem::path& path)
 	std::string sceneName{ path.stem().string() };
 	ecs::scene::CreateScene(sceneName.c_str());
 
+	// the snapshot is only used if it isn't older than the yaml, which might have been edited by hand
+	const std::filesystem::path snapshotPath{ std::filesystem::path{ path }.replace_extension(content::SCENE_SNAPSHOT_FILE_EXTENSION) };
+	std::error_code error{};
+	if (std::filesystem::exists(snapshotPath, error)
+		&& std::filesystem::last_write_time(snapshotPath, error) >= std::filesystem::last_write_time(path, error)
+		&& LoadSceneSnapshot(hierarchies, snapshotPath))
+	{
+		return;
+	}
+
 	YAML::Node data = YAML::LoadFile(path.string());
 
 	const auto& sceneData{ data["Scene"] };
@@ -456,11 +725,31 @@ LoadScene(Vec<Vec<ecs::Entity>>& hierarchies, const std::filesystem::path& path)
 
 
 void
-DeserializeEntityHierarchy(Vec<ecs::Entity>& entities, const std::filesystem::path& path)
+InstantiatePrefab(const std::filesystem::path& path, u32 count, Vec<ecs::Entity>& entities)
 {
-	YAML::Node data = YAML::LoadFile(path.string());
+	if (count == 0) return;
+	const std::string key{ GetPrefabKey(path) };
+	auto it{ _compiledPrefabs.find(key) };
+	if (it == _compiledPrefabs.end())
+	{
+		// the first copy is loaded from the file, it creates the resources and the template is taken from it
+		YAML::Node data = YAML::LoadFile(path.string());
+		Vec<ecs::Entity> loaded{};
+		DeserializeEntityHierarchy(data, loaded);
+		it = _compiledPrefabs.try_emplace(key).first;
+		CompilePrefab(loaded, it->second);
+		for (ecs::Entity entity : loaded) entities.emplace_back(entity);
+		if (--count == 0) return;
+	}
+	InstantiateCompiledPrefab(it->second, count, entities);
+}
 
-	DeserializeEntityHierarchy(data, entities);
+void
+DuplicateEntities(const Vec<ecs::Entity>& entities, Vec<ecs::Entity>& outCopies)
+{
+	CompiledPrefab duplicated{};
+	CompilePrefab(entities, duplicated);
+	InstantiateCompiledPrefab(duplicated, 1, outCopies);
 }
 
 void 
@@ -506,13 +795,13 @@ Prefab::Instantiate([[maybe_unused]] const ecs::scene::Scene& scene)
 	ecs::component::WorldTransform wt{};
 	ecs::component::RenderMaterial material{};
 	ecs::component::RenderMesh mesh{};
+	ecs::component::CullableObject cullable{};
 	ecs::component::NameComponent name{};
 	
 	mesh.MeshID = uploadedGeometryInfo.GeometryContentID;
-	mesh.MeshAsset = _meshAssets[0];
+	cullable.obb = uploadedGeometryInfo.SubmeshBounds[0];
 	material.MaterialCount = 1;
 	material.MaterialID = materialIDs[0];
-	material.MaterialAsset = _materialAssets[0];
 
 	struct RenderableEntitySpawnContext
 	{
@@ -529,8 +818,8 @@ Prefab::Instantiate([[maybe_unused]] const ecs::scene::Scene& scene)
 	// create root entity
 	ecs::component::Parent parentEntity{ {} };
 	ecs::EntityData& rootEntityData{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Parent, ecs::component::NameComponent>(
-			lt, wt, mesh, material, parentEntity, name) };
+		ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Parent, ecs::component::NameComponent>(
+			lt, wt, mesh, material, cullable, parentEntity, name) };
 	spawnedEntities[0] = { rootEntityData.id, mesh, material, false };
 
 	ecs::component::Child child{ {}, rootEntityData.id };
@@ -542,17 +831,16 @@ Prefab::Instantiate([[maybe_unused]] const ecs::scene::Scene& scene)
 	{
 		id_t meshId{ uploadedGeometryInfo.SubmeshGpuIDs[i] };
 		mesh.MeshID = meshId;
-		mesh.MeshAsset = _meshAssets[0];
 		material.MaterialID = materialIDs[i];
 		material.MaterialCount = 1;
-		material.MaterialAsset = _materialAssets[i];
+		cullable.obb = uploadedGeometryInfo.SubmeshBounds[i];
 
 		snprintf(name.Name, ecs::component::NAME_LENGTH, "%s", i < _names.size() ? _names[i].c_str() : _names[0].c_str());
 
 		ecs::EntityData& e{ ecs::scene::SpawnEntity<ecs::component::LocalTransform, ecs::component::WorldTransform,
-			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::Child, ecs::component::NameComponent>(
-				lt, wt, mesh, material, child, name) };
-		assert(ecs::scene::GetComponent<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
+			ecs::component::RenderMesh, ecs::component::RenderMaterial, ecs::component::CullableObject, ecs::component::Child, ecs::component::NameComponent>(
+				lt, wt, mesh, material, cullable, child, name) };
+		assert(ecs::scene::GetComponentRO<ecs::component::Child>(e.id).ParentEntity == child.ParentEntity);
 		spawnedEntities[i] = { e.id, mesh, material, true, child };
 	}
 
@@ -562,12 +850,15 @@ Prefab::Instantiate([[maybe_unused]] const ecs::scene::Scene& scene)
 		if (c.isChild)
 		{
 			assert(c.child.ParentEntity == child.ParentEntity);
-			assert(ecs::scene::GetComponent<ecs::component::Child>(c.entity).ParentEntity == child.ParentEntity);
+			assert(ecs::scene::GetComponentRO<ecs::component::Child>(c.entity).ParentEntity == child.ParentEntity);
 		}
 
 
 		ecs::component::RenderMesh& mesh{ ecs::scene::GetComponent<ecs::component::RenderMesh>(c.entity) };
 		mesh.RenderItemID = graphics::AddRenderItem(c.entity, c.Mesh.MeshID, c.Material.MaterialCount, c.Material.MaterialID);
+		ecs::metadata::EntityAssets& assets{ ecs::metadata::GetAssets(c.entity) };
+		assets.Mesh = _meshAssets[0];
+		assets.Material = _materialAssets[entityIdx];
 		editor::AddEntityToSceneView(c.entity);
 		//FIXME: has to be there cause i add entity to transform hierarchy in AddEntityToSceneView() which makes no sense; cant migrate the entity because of that; think of creating some buffer for the new entity before adding it
 		if (!_joltMeshShapes.empty() && _joltMeshShapes[entityIdx].GetPtr() != nullptr)
@@ -576,8 +867,7 @@ Prefab::Instantiate([[maybe_unused]] const ecs::scene::Scene& scene)
 				physics::AddStaticBody(_joltMeshShapes[entityIdx], c.entity);
 			else
 				physics::AddDynamicBody(_joltMeshShapes[entityIdx], c.entity);
-			ecs::component::Collider& col{ ecs::scene::GetComponent<ecs::component::Collider>(c.entity) };
-			col.ShapeAsset = _joltShapeAssets[entityIdx];
+			assets.Shape = _joltShapeAssets[entityIdx];
 		}
 		entityIdx++;
 	}
@@ -41,7 +41,10 @@ void DropModelIntoScene(std::filesystem::path modelPath, u32* materials = nullpt
 void AddFBXImportedModelToScene(const content::FBXImportState& state, bool extractMaterials);
 
 void SerializeEntityHierarchy(const Vec<ecs::Entity>& entities);
-void DeserializeEntityHierarchy(Vec<ecs::Entity>& entities, const std::filesystem::path& path);
+// appends count copies of the prefab's hierarchy, the first instantiation loads and compiles the prefab and later ones are batched copies
+void InstantiatePrefab(const std::filesystem::path& path, u32 count, Vec<ecs::Entity>& entities);
+// the entities have to be in hierarchy order, parents before their children
+void DuplicateEntities(const Vec<ecs::Entity>& entities, Vec<ecs::Entity>& outCopies);
 void SerializeScene(const ecs::scene::Scene& scene, const Vec<Vec<ecs::Entity>>& hierarchies);
 void LoadScene(Vec<Vec<ecs::Entity>>& hierarchies, const std::filesystem::path& path);
 }
\ No newline at end of file
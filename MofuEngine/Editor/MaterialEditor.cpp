@@ -380,8 +380,8 @@ OpenMaterialEditor(ecs::Entity entityID)
 	materialOwner = entityID;
 	editorMaterial = {};
 	
-	ecs::component::RenderMaterial mat{ ecs::scene::GetComponent<ecs::component::RenderMaterial>(entityID) };
-	//TODO: could also just use mat.MaterialAsset and call UpdateMaterialInitInfo();
+	ecs::component::RenderMaterial mat{ ecs::scene::GetComponentRO<ecs::component::RenderMaterial>(entityID) };
+	//TODO: could also just use the entity's metadata::EntityAssets::Material and call UpdateMaterialInitInfo();
 	materialInitInfo = graphics::GetMaterialReflection(mat.MaterialID);
 	editorMaterial.TextureCount = materialInitInfo.TextureCount;
 	editorMaterial.Flags = materialInitInfo.MaterialFlags;
@@ -396,33 +396,33 @@ OpenMaterialEditor(ecs::Entity entityID)
 	{
 		editorMaterial.ShaderIDs[i] = materialInitInfo.ShaderIDs[i];
 	}
-	currentMaterialAsset = mat.MaterialAsset;
+	currentMaterialAsset = ecs::metadata::GetAssets(entityID).Material;
 
 	isOpen = true;
 
 	//TODO: which one is better
 	if constexpr (DISPLAY_TEXTURES_FROM_GEOMETRY_METADATA)
 	{
-		id_t geometryID{ ecs::scene::GetComponent<ecs::component::RenderMesh>(entityID).MeshID };
+		id_t geometryID{ ecs::scene::GetComponentRO<ecs::component::RenderMesh>(entityID).MeshID };
 		content::AssetHandle geometryHandle{ content::assets::GetAssetFromResource(geometryID, content::AssetType::Mesh) };
 		content::assets::GetGeometryRelatedTextures(geometryHandle, _relatedTextures);
 	}
 	else
 	{
 		const bool hasParent{ ecs::scene::HasComponent<ecs::component::Child>(entityID) };
-		if (!hasParent || _lastRelatedTexturesEntity != ecs::scene::GetComponent<ecs::component::Child>(entityID).ParentEntity)
+		if (!hasParent || _lastRelatedTexturesEntity != ecs::scene::GetComponentRO<ecs::component::Child>(entityID).ParentEntity)
 		{
 			id_t geometryID{};
 			if (!hasParent)
 			{
-				geometryID = ecs::scene::GetComponent<ecs::component::RenderMesh>(entityID).MeshID;
+				geometryID = ecs::scene::GetComponentRO<ecs::component::RenderMesh>(entityID).MeshID;
 				_lastRelatedTexturesEntity = entityID;
 			}
 			else 
 			{
 				// could pick one of the children without first editing the parent
-				geometryID = ecs::scene::GetComponent<ecs::component::RenderMesh>
-					(ecs::scene::GetComponent<ecs::component::Child>(entityID).ParentEntity).MeshID;
+				geometryID = ecs::scene::GetComponentRO<ecs::component::RenderMesh>
+					(ecs::scene::GetComponentRO<ecs::component::Child>(entityID).ParentEntity).MeshID;
 			}
 
 			content::AssetHandle geometryHandle{ content::assets::GetAssetFromResource(geometryID, content::AssetType::Mesh) };
@@ -29,7 +29,7 @@ CastProbe(f32 probeLength, f32& outFraction, JPH::RVec3& outPos, JPH::BodyID& ou
 	if(!ecs::scene::IsEntityAlive(_cameraEntity))
 		_cameraEntity = ecs::scene::GetSingletonEntity(ecs::component::ID<ecs::component::Camera>);
 
-	const ecs::component::LocalTransform& camLT{ ecs::scene::GetComponent<ecs::component::LocalTransform>(_cameraEntity) };
+	const auto camLT{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(_cameraEntity) };
 
 	JPH::RVec3 origin{ camLT.Position.Vec3() };
 	JPH::Vec3 direction{ (camLT.Forward * probeLength).Vec3() };
@@ -99,9 +99,9 @@ UpdateObjectPickerProbe()
 
 	if (ecs::scene::IsEntityAlive(_pickedEntity))
 	{
-		const ecs::component::LocalTransform& lt{ ecs::scene::GetComponent<ecs::component::LocalTransform>(_pickedEntity) };
+		const auto lt{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(_pickedEntity) };
 		assert(ecs::scene::HasComponent<ecs::component::Collider>(_pickedEntity));
-		JPH::BodyLockRead lock{ physics::core::PhysicsSystem().GetBodyLockInterface(), ecs::scene::GetComponent<ecs::component::Collider>(_pickedEntity).BodyID };
+		JPH::BodyLockRead lock{ physics::core::PhysicsSystem().GetBodyLockInterface(), ecs::scene::GetComponentRO<ecs::component::Collider>(_pickedEntity).BodyID };
 		if (lock.Succeeded())
 		{
 			const JPH::Shape* const shape{ lock.GetBody().GetShape() };
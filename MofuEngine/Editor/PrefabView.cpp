@@ -5,7 +5,7 @@
 
 namespace mofu::editor::scene {
 namespace {
-
+i32 _instanceCount{ 1 };
 
 } // anonymous namespace
 
@@ -14,13 +14,15 @@ InspectPrefab(const std::filesystem::path& path)
 {
 	ImGui::Text("Prefab: %ull", -1ull);
 
-	if (ImGui::Button("Add To Scene")) LoadPrefab(path);
+	ImGui::InputInt("Copies", &_instanceCount);
+	_instanceCount = std::max(_instanceCount, 1);
+	if (ImGui::Button("Add To Scene")) LoadPrefab(path, (u32)_instanceCount);
 }
 
 void
-LoadPrefab(const std::filesystem::path& path)
+LoadPrefab(const std::filesystem::path& path, u32 count /* = 1 */)
 {
-	AddPrefab(path);
+	AddPrefab(path, count);
 }
 
 }
@@ -5,6 +5,6 @@
 namespace mofu::editor::scene
 {
 void InspectPrefab(const std::filesystem::path& path);
-void LoadPrefab(const std::filesystem::path& path);
+void LoadPrefab(const std::filesystem::path& path, u32 count = 1);
 
 }
\ No newline at end of file
@@ -33,6 +33,10 @@ std::filesystem::path currentScenePath{};
 EntityTreeNode* selectedNode{ nullptr };
 char sceneNameBuffer[ecs::scene::Scene::MAX_NAME_LENGTH];
 
+// the world from before entering play mode, restored when leaving it
+ecs::scene::World* playModeWorld{ nullptr };
+Vec<Vec<ecs::Entity>> playModeHierarchies{};
+
 
 constexpr EntityTreeNode*
 FindEntityAsNode(ecs::Entity parentEntity)
@@ -63,7 +67,7 @@ PrepareAddedComponent(ecs::ComponentID cid, ecs::Entity entity)
         }
         ecs::component::RenderMesh& mesh{ ecs::scene::GetComponent<ecs::component::RenderMesh>(entity) };
         mesh.MeshID = content::GetDefaultMesh();
-        mesh.MeshAsset = content::assets::DEFAULT_MESH_HANDLE;
+        ecs::metadata::GetAssets(entity).Mesh = content::assets::DEFAULT_MESH_HANDLE;
 
         const ecs::component::RenderMaterial& mat{ ecs::scene::GetComponent<ecs::component::RenderMaterial>(entity) };
 
@@ -77,8 +81,8 @@ PrepareAddedComponent(ecs::ComponentID cid, ecs::Entity entity)
         ecs::component::RenderMaterial material{};
         material.MaterialCount = 1;
         material.MaterialID = content::GetDefaultMaterial();
-        material.MaterialAsset = content::assets::DEFAULT_MATERIAL_UNTEXTURED_HANDLE;
         mat = material;
+        ecs::metadata::GetAssets(entity).Material = content::assets::DEFAULT_MATERIAL_UNTEXTURED_HANDLE;
         break;
     }
     case ecs::component::ID<ecs::component::Collider>:
@@ -97,7 +101,7 @@ CreateEntityTreeNode(ecs::Entity entity, EntityTreeNode* parentNode)
     node->ID = entity;
     if (ecs::scene::HasComponent<ecs::component::NameComponent>(entity))
     {
-        const char* name{ ecs::scene::GetComponent<ecs::component::NameComponent>(entity).Name };
+        const char* name{ ecs::scene::GetComponentRO<ecs::component::NameComponent>(entity).Name };
         snprintf(node->Name, NODE_NAME_LENGTH, "%s", name);
     }
     else
@@ -167,37 +171,93 @@ DuplicateEntity(EntityTreeNode* node)
     //if (!selectedNode) return;
     assert(node);
     if (!node) return;
-    ecs::Entity selected{ node->ID };
-
-    //ecs::Entity selected{ selectedNode ? selectedNode->ID : id::INVALID_ID };
 
-    const ecs::EntityData& duplicatedData{ ecs::scene::GetEntityData(selected) };
-    const ecs::EntityBlock* const duplicatedBlock{ duplicatedData.block };
+    // the children are duplicated with it, parents are collected before their children
+    Vec<ecs::Entity> duplicated{};
+    Vec<EntityTreeNode*> pending{};
+    pending.emplace_back(node);
+    for (u32 i{ 0 }; i < pending.size(); ++i)
+    {
+        duplicated.emplace_back(pending[i]->ID);
+        for (EntityTreeNode* child : pending[i]->Children) pending.emplace_back(child);
+    }
 
-    const ecs::EntityData& newData = ecs::scene::SpawnEntity(duplicatedBlock->Signature);
-    const ecs::EntityBlock* const newBlock{ newData.block }; // in case the original block got filled, grab the one given
+    Vec<ecs::Entity> copies{};
+    assets::DuplicateEntities(duplicated, copies);
+    for (const ecs::Entity e : copies)
+    {
+        AddEntityToSceneView(e);
+    }
+}
 
-    const u32 duplicatedRow{ duplicatedData.row };
-    const u32 newRow{ newData.row };
+// the scene tree as lists of a top level entity followed by its children
+void
+GetSceneHierarchies(Vec<Vec<ecs::Entity>>& outHierarchies)
+{
+    //TODO: more depth levels
+    for (EntityTreeNode* parent : _rootNode->Children)
+    {
+        outHierarchies.emplace_back();
+        Vec<ecs::Entity>& hierarchy{ outHierarchies.back() };
+        hierarchy.emplace_back(parent->ID);
+        for (EntityTreeNode* child : parent->Children)
+        {
+            hierarchy.emplace_back(child->ID);
+        }
+    }
+}
 
-    // copy over component values
-    for (ecs::ComponentID cid : newBlock->GetComponentView())
+void
+RebuildSceneTree(const Vec<Vec<ecs::Entity>>& hierarchies)
+{
+    for (auto [e, n] : entityToPair)
     {
-        const u32 componentSize{ ecs::component::GetComponentSize(cid) };
-        const u32 duplicatedOffset{ duplicatedBlock->ComponentOffsets[cid] + componentSize * duplicatedRow };
-        const u32 newOffset{ newBlock->ComponentOffsets[cid] + componentSize * newRow };
-        memcpy(newBlock->ComponentData + newOffset, duplicatedBlock->ComponentData + duplicatedOffset, componentSize);
+        delete n;
+        n = nullptr;
     }
+    entityToPair.clear();
+    delete _rootNode;
+    _rootNode = nullptr;
+    selectedNode = nullptr;
+
+    _rootNode = new EntityTreeNode{};
+    char rootName[NODE_NAME_LENGTH]{ "Root" };
+    snprintf(_rootNode->Name, NODE_NAME_LENGTH, "%s", rootName);
+    _rootNode->ID = ecs::Entity{ id::INVALID_ID };
+    //CreateSceneHierarchyTree(ecs::scene::GetAllEntityData());
+    for (const Vec<ecs::Entity>& hierarchy : hierarchies)
+    {
+        for (const ecs::Entity e : hierarchy)
+        {
+            AddEntityToSceneView(e);
+        }
+	}
+}
 
-    const ecs::Entity newEntity{ newData.id };
-    if (ecs::scene::HasComponent<ecs::component::RenderMesh>(newEntity))
+void
+TogglePlayMode()
+{
+    if (!playModeWorld)
+    {
+        playModeHierarchies.clear();
+        GetSceneHierarchies(playModeHierarchies);
+        playModeWorld = ecs::scene::CloneMainWorld();
+    }
+    else
     {
-        ecs::component::RenderMesh& mesh{ ecs::scene::GetComponent<ecs::component::RenderMesh>(newEntity) };
-        const ecs::component::RenderMaterial& material{ ecs::scene::GetComponent<ecs::component::RenderMaterial>(newEntity) };
-        mesh.RenderItemID = graphics::AddRenderItem(newEntity, mesh.MeshID, material.MaterialCount, material.MaterialID);
+        // the tree goes back to the entities from before playing as well
+        ecs::scene::RestoreMainWorld(playModeWorld);
+        playModeWorld = nullptr;
+        RebuildSceneTree(playModeHierarchies);
     }
+}
 
-    AddEntityToSceneView(newEntity);
+void
+DiscardPlayMode()
+{
+    if (!playModeWorld) return;
+    ecs::scene::DestroyWorld(playModeWorld);
+    playModeWorld = nullptr;
 }
 
 struct SceneHierarchy
@@ -243,20 +303,14 @@ struct SceneHierarchy
             }
         }
 
+        if (ImGui::Button(playModeWorld ? "Stop" : "Play"))
+        {
+            TogglePlayMode();
+        }
         if (ImGui::Button("Save Scene"))
         {
             Vec<Vec<ecs::Entity>> hierarchies{};
-            //TODO: more depth levels
-            for (EntityTreeNode* parent : _rootNode->Children)
-            {
-                hierarchies.emplace_back();
-                Vec<ecs::Entity>& hierarchy{ hierarchies.back() };
-                hierarchy.emplace_back(parent->ID);
-                for (EntityTreeNode* child : parent->Children)
-                {
-                    hierarchy.emplace_back(child->ID);
-                }
-            }
+            GetSceneHierarchies(hierarchies);
             assets::SerializeScene(ecs::scene::GetCurrentScene(), hierarchies);
         }
         if (ImGui::Button("Load Scene"))
@@ -327,19 +381,31 @@ struct SceneHierarchy
                 //TODO: make an iterator or a view
                 const EntityData& entityData{ ecs::scene::GetEntityData(entity) };
                 const EntityBlock* const block{ ecs::scene::GetEntityData(entity).block };
-                ecs::component::LocalTransform oldLT{ ecs::scene::GetComponent<ecs::component::LocalTransform>(entity) };
+                const bool hasTransform{ ecs::scene::HasComponent<component::LocalTransform>(entity) };
+                ecs::component::LocalTransform oldLT{};
+                if (hasTransform) oldLT = ecs::scene::GetComponentRO<ecs::component::LocalTransform>(entity);
 
                 ForEachComponent(block, entityData.row, [](ComponentID cid, u8* data) {
                     component::RenderLUT[cid](data);
                     });
+                ecs::scene::ForEachSparseComponent(entity, [](ComponentID cid) {
+                    u8 tag{}; // sparse components are tags without data
+                    component::RenderLUT[cid](&tag);
+                    });
 
-                if (ecs::scene::HasComponent<component::Collider>(entity))
+                // the fields are written in place without a version, the hierarchy only picks up marked transforms
+                if (hasTransform)
                 {
-                    const ecs::component::LocalTransform& newLT{ ecs::scene::GetComponent<ecs::component::LocalTransform>(entity) };
+                    const ecs::component::LocalTransform newLT = ecs::scene::GetComponentRO<ecs::component::LocalTransform>(entity);
                     if (memcmp(&oldLT, &newLT, sizeof(ecs::component::LocalTransform)))
                     {
-                        ecs::component::Collider col{ ecs::scene::GetComponent<ecs::component::Collider>(entity) };
-                        mofu::physics::core::BodyInterface().SetPositionAndRotation(col.BodyID, newLT.Position.Vec3(), newLT.Rotation, JPH::EActivation::Activate);
+                        ecs::scene::MarkComponentChanged<component::LocalTransform>(entity);
+                        ecs::transform::MarkLocalTransformChanged(entity);
+                        if (ecs::scene::HasComponent<component::Collider>(entity))
+                        {
+                            ecs::component::Collider col{ ecs::scene::GetComponentRO<ecs::component::Collider>(entity) };
+                            mofu::physics::core::BodyInterface().SetPositionAndRotation(col.BodyID, newLT.Position.Vec3(), newLT.Rotation, JPH::EActivation::Activate);
+                        }
                     }
                 }
 
@@ -538,7 +604,7 @@ void AddEntityToSceneView(ecs::Entity entity)
     EntityTreeNode* parentNode{ _rootNode };
     if (ecs::scene::HasComponent<ecs::component::Child>(entity))
     {
-        ecs::component::Child p{ ecs::scene::GetComponent<ecs::component::Child>(entity) };
+        ecs::component::Child p{ ecs::scene::GetComponentRO<ecs::component::Child>(entity) };
         parentNode = FindEntityAsNode(p.ParentEntity);
     }
 
@@ -587,36 +653,18 @@ void LoadScene(const std::filesystem::path& path)
         log::Warn("Scene already loaded");
         return;
 	}
+    // the loaded scene replaces whatever play mode would go back to
+    DiscardPlayMode();
     Vec<Vec<ecs::Entity>> hierarchies{};
     assets::LoadScene(hierarchies, path);
     currentScenePath = path;
-    for (auto [e, n] : entityToPair)
-    {
-        delete n;
-        n = nullptr;
-    }
-    entityToPair.clear();
-    delete _rootNode;
-    _rootNode = nullptr;
-    selectedNode = nullptr;
-
-    _rootNode = new EntityTreeNode{};
-    char rootName[NODE_NAME_LENGTH]{ "Root" };
-    snprintf(_rootNode->Name, NODE_NAME_LENGTH, "%s", rootName);
-    _rootNode->ID = ecs::Entity{ id::INVALID_ID };
-    //CreateSceneHierarchyTree(ecs::scene::GetAllEntityData());
-    for (const Vec<ecs::Entity>& hierarchy : hierarchies)
-    {
-        for (const ecs::Entity e : hierarchy)
-        {
-            AddEntityToSceneView(e);
-        }
-	}
+    RebuildSceneTree(hierarchies);
 }
 
 void 
 ShutdownSceneEditorView()
 {
+    DiscardPlayMode();
     for (auto [e, n] : entityToPair)
     {
         delete n;
@@ -626,10 +674,10 @@ ShutdownSceneEditorView()
 	_rootNode = nullptr;
 }
 
-ecs::Entity AddPrefab(const std::filesystem::path& path)
+ecs::Entity AddPrefab(const std::filesystem::path& path, u32 count /* = 1 */)
 {
     Vec<ecs::Entity> entities{};
-    assets::DeserializeEntityHierarchy(entities, path);
+    assets::InstantiatePrefab(path, count, entities);
     for (const ecs::Entity e : entities)
     {
         AddEntityToSceneView(e);
@@ -13,5 +13,6 @@ bool InitializeSceneEditorView();
 void ShutdownSceneEditorView();
 void RenderSceneEditorView();
 void LoadScene(const std::filesystem::path& path); //FIXME: shouldnt be there
-ecs::Entity AddPrefab(const std::filesystem::path& path); // FIXME: shouldnt be there
+// returns the root of the first copy
+ecs::Entity AddPrefab(const std::filesystem::path& path, u32 count = 1); // FIXME: shouldnt be there
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "ECS/QueryView.h"
 #include "ECS/Scene.h"
+#include "ECS/EntityCommandBuffer.h"
 #include "Graphics/Renderer.h"
 #include "Utilities/Logger.h"
 
@@ -12,19 +13,26 @@ constexpr bool contains_type{ (std::is_same_v<C, Cs> || ...) };
 template<typename... Component>
 QueryView<true, Component...> GetRW()
 {
-	auto blocks = GetBlocksFromCet(GetCetMask<Component...>());
-	return QueryView<true, Component...>(blocks);
+	return QueryView<true, Component...>(GetBlocksFromCet(GetQueryMask<Component...>()));
 }
 
 template<typename... Component>
 QueryView<false, Component...> GetRO()
 {
-	auto blocks = GetBlocksFromCet(GetCetMask<Component...>());
-	return QueryView<false, Component...>(blocks);
+	return QueryView<false, Component...>(GetBlocksFromCet(GetQueryMask<Component...>()));
 }
 
+// the returned reference is writable, so the component counts as changed
 template<IsComponent C>
-C& GetComponent(Entity id)
+ColumnElement<C, true> GetComponent(Entity id)
+{
+	MarkComponentChanged<C>(id);
+	return GetEntityComponent<C>(id);
+}
+
+// for reads, doesn't count as a change
+template<IsComponent C>
+ColumnElement<C, false> GetComponentRO(Entity id)
 {
 	return GetEntityComponent<C>(id);
 }
@@ -83,6 +91,41 @@ inline EntityData& SpawnEntity(const C... components)
 	return entityData;
 }
 
+// spawns count entities with the same component values, each component column is filled per block
+template<IsComponent... C>
+void SpawnEntities(u32 count, const C&... components)
+{
+	Vec<BlockRange> ranges{};
+	scene::CreateEntities(GetCetMask<C...>(), count, ranges);
+	for (const BlockRange& range : ranges)
+	{
+		(FillColumn<C>(range.Block, range.FirstRow, range.Count, components), ...);
+		for (u16 i{ 0 }; i < range.Count; ++i) scene::ValidateTransform(range.Block->Entities[range.FirstRow + i]);
+	}
+}
+
+// spawns count entities, init(index, entity, components&...) fills in the components of each (split components come as their row proxy)
+template<IsComponent... C, typename Fun>
+	requires std::invocable<Fun, u32, Entity, ColumnElement<C, true>...>
+void SpawnEntities(u32 count, Fun&& init)
+{
+	Vec<BlockRange> ranges{};
+	scene::CreateEntities(GetCetMask<C...>(), count, ranges);
+	u32 index{ 0 };
+	for (const BlockRange& range : ranges)
+	{
+		EntityBlock* const block{ range.Block };
+		(FillColumn<C>(block, range.FirstRow, range.Count, C{}), ...);
+		std::tuple<ColumnArray<C, true>...> columns{ (GetColumn<C>(block) + range.FirstRow)... };
+		for (u16 i{ 0 }; i < range.Count; ++i, ++index)
+		{
+			const Entity entity{ block->Entities[range.FirstRow + i] };
+			init(index, entity, std::get<ColumnArray<C, true>>(columns)[i]...);
+			scene::ValidateTransform(entity);
+		}
+	}
+}
+
 inline EntityData& SpawnEntity(const CetMask& signature)
 {
 	EntityData& entityData{ scene::CreateEntity(signature) };
@@ -90,6 +133,12 @@ inline EntityData& SpawnEntity(const CetMask& signature)
 	return entityData;
 }
 
+// records structural changes to apply at the end of the frame, safe to use from systems running on worker threads
+inline EntityCommandBuffer& GetCommandBuffer()
+{
+	return GetThreadCommandBuffer();
+}
+
 inline ecs::Entity GetSingletonEntity(ecs::ComponentID withComponent)
 {
 	return scene::GetSingleton(withComponent);
@@ -1,5 +1,7 @@
 #pragma once
 #include "ECS/ECSCommon.h"
+#include "ECS/ComponentRegistry.h"
+#include "ECS/QueryFilters.h"
 //namespace mofu::ecs {
 //
 //#define REGISTER_SYSTEM(System, Group, Order) \
@@ -7,6 +9,11 @@
 //
 //}
 
+namespace mofu::ecs {
+template<bool Writable, typename... Component>
+class QueryView;
+}
+
 namespace mofu::ecs::system {
 
 struct SystemUpdateData
@@ -36,6 +43,80 @@ struct System
 	}
 };
 
+/*
+* component access of a system, used to figure out which systems in a group can run at the same time
+* declared in the system with: using Access = SystemAccess<Read<A, B>, Write<C>>;
+* the query types can be used directly too: SystemAccess<decltype(scene::GetRW<C, D>())>
+* systems without an Access touch things outside of the ECS (input, renderer, ...) so they run alone on the calling thread
+*/
+template<IsComponent... C> struct Read {};
+template<IsComponent... C> struct Write {};
+
+struct AccessMask
+{
+	CetMask ReadMask{};
+	CetMask WriteMask{};
+	bool Exclusive{ true };
+
+	[[nodiscard]] bool ConflictsWith(const AccessMask& o) const
+	{
+		if (Exclusive || o.Exclusive) return true;
+		return (WriteMask & (o.ReadMask | o.WriteMask)).any() || (o.WriteMask & ReadMask).any();
+	}
+};
+
+namespace detail {
+template<typename T>
+struct AccessOf;
+
+template<IsComponent... C>
+struct AccessOf<Read<C...>>
+{
+	static void Add(AccessMask& mask) { (mask.ReadMask.set(component::ID<C>), ...); }
+};
+
+template<IsComponent... C>
+struct AccessOf<Write<C...>>
+{
+	static void Add(AccessMask& mask) { (mask.WriteMask.set(component::ID<C>), ...); }
+};
+
+template<bool Writable, typename... Term>
+struct AccessOf<QueryView<Writable, Term...>>
+{
+	template<typename T>
+	static void AddTerm(AccessMask& mask)
+	{
+		using Info = ecs::detail::QueryTerm<T>;
+		// filters only read, excluded components only look at the block signature
+		if constexpr (Info::IsExcluded) return;
+		else if constexpr (Writable && !Info::IsFilter) mask.WriteMask.set(component::ID<typename Info::Type>);
+		else mask.ReadMask.set(component::ID<typename Info::Type>);
+	}
+
+	static void Add(AccessMask& mask) { (AddTerm<Term>(mask), ...); }
+};
+} // detail
+
+template<typename... Access>
+struct SystemAccess
+{
+	static AccessMask Get()
+	{
+		AccessMask mask{};
+		mask.Exclusive = false;
+		(detail::AccessOf<Access>::Add(mask), ...);
+		return mask;
+	}
+};
+
+template<typename T>
+AccessMask GetSystemAccess()
+{
+	if constexpr (requires { typename T::Access; }) return T::Access::Get();
+	else return {};
+}
+
 
 
 }
@@ -44,4 +125,4 @@ struct System
 
 #define REGISTER_SYSTEM(Type, Group, Order)                                       \
 	static ::mofu::ecs::system::detail::RegisterScriptCall<Type>                      \
-		_reg_##Type##_##__LINE__ { (Group), (Order) }
+		_reg_##Type##_##__LINE__ { (Group), (Order), #Type }
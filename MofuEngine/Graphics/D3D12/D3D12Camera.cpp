@@ -236,10 +236,10 @@ D3D12Camera::Update(u32 frameIndex)
 	using namespace DirectX;
 
     //TODO: take this out of there
-    ecs::component::LocalTransform& lt = ecs::scene::GetComponent<ecs::component::LocalTransform>(_entityID);
+    const auto lt = ecs::scene::GetComponentRO<ecs::component::LocalTransform>(_entityID);
     _position = XMLoadFloat3(&lt.Position);
     _direction = XMLoadFloat3(&lt.Forward);
-	_wasUpdated = ecs::scene::GetComponent<ecs::component::Camera>(_entityID).WasUpdated;
+	_wasUpdated = ecs::scene::GetComponentRO<ecs::component::Camera>(_entityID).WasUpdated;
 
 	_view = XMMatrixLookToRH(_position, _direction, _up);
     _inverseView = XMMatrixInverse(nullptr, _view);
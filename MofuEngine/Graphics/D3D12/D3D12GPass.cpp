@@ -109,7 +109,7 @@ FillPerObjectData(const D3D12FrameInfo& frameInfo, const content::material::Mate
 			hlsl::PerObjectData data{};
 
 			//TODO: do something that utilizes ecs better
-			ecs::component::WorldTransform& transform{ ecs::scene::GetComponent<ecs::component::WorldTransform>(currentEntityID) };
+			const ecs::component::WorldTransform& transform{ ecs::scene::GetComponentRO<ecs::component::WorldTransform>(currentEntityID) };
 			xmmat transformWorld{ XMLoadFloat4x4(&transform.TRS) };
 
 			//TODO: fill with actual transform data
@@ -73,8 +73,100 @@ StructuredBuffer _geometryInfoBuffer;
 Vec<hlsl::RTObjectMatrices> _objectMatricesData;
 StructuredBuffer _objectMatricesBuffer;
 
+// the TLAS instances kept between updates, so a refit only touches the instances that moved
+Vec<D3D12_RAYTRACING_INSTANCE_DESC> _instances;
+Vec<ecs::Entity> _instanceEntities;
+Vec<u32> _instanceIndices; // by entity index
+u32 _tlasInstanceCount{ 0 }; // the instance count the TLAS was last fully built with, a refit has to keep it
+
 constexpr f32 CLEAR_VALUE[4]{ 0.f, 0.f, 0.f, 0.f };
 
+void
+SetInstanceTransform(D3D12_RAYTRACING_INSTANCE_DESC& instance, const m4x4& trs)
+{
+	xmmat mat{ DirectX::XMLoadFloat4x4(&trs) };
+	DirectX::XMFLOAT3X4 mat3x4{};
+	DirectX::XMStoreFloat3x4(&mat3x4, mat);
+	memcpy(&instance.Transform, &mat3x4, sizeof(instance.Transform));
+}
+
+void
+GatherInstances()
+{
+	_instances.clear();
+	_instanceEntities.clear();
+	_instanceIndices.clear();
+	for (auto [entity, m, wt] : ecs::scene::GetRO<ecs::component::PathTraceable, ecs::component::WorldTransform>())
+	{
+		const u32 index{ id::Index(entity) };
+		if (index >= _instanceIndices.size()) _instanceIndices.resize(index + 1, U32_INVALID_ID);
+		_instanceIndices[index] = (u32)_instances.size();
+		_instanceEntities.emplace_back(entity);
+
+		D3D12_RAYTRACING_INSTANCE_DESC& instance{ *_instances.emplace_back() };
+		instance = {};
+		instance.InstanceID = entity & 0x00FFFFFF;
+		instance.InstanceMask = 1;
+		instance.AccelerationStructure = _bottomLevelAccStructure.GpuAddress();
+		instance.InstanceContributionToHitGroupIndex = 0;
+		instance.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
+		SetInstanceTransform(instance, wt.TRS);
+	}
+}
+
+// rewrites the instances of the moved entities, returns how many of them are path traced
+u32
+UpdateMovedInstances(std::span<const ecs::Entity> movedEntities)
+{
+	u32 updatedCount{ 0 };
+	for (ecs::Entity entity : movedEntities)
+	{
+		const u32 index{ id::Index(entity) };
+		if (index >= _instanceIndices.size() || _instanceIndices[index] == U32_INVALID_ID) continue;
+		const u32 instanceIndex{ _instanceIndices[index] };
+		if (_instanceEntities[instanceIndex] != entity) continue;
+		SetInstanceTransform(_instances[instanceIndex], ecs::scene::GetEntityComponent<ecs::component::WorldTransform>(entity).TRS);
+		++updatedCount;
+	}
+	return updatedCount;
+}
+
+// grows the TLAS and the scratch buffer to what a full build of instanceCount instances needs, they never shrink
+void
+ResizeTopLevelBuffers(u32 instanceCount, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+{
+	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO topPrebuildInfo{};
+	{
+		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS prebuildInfoDesc{};
+		prebuildInfoDesc.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+		prebuildInfoDesc.Flags = buildFlags;
+		prebuildInfoDesc.NumDescs = instanceCount;
+		prebuildInfoDesc.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+		core::Device()->GetRaytracingAccelerationStructurePrebuildInfo(&prebuildInfoDesc, &topPrebuildInfo);
+		assert(topPrebuildInfo.ResultDataMaxSizeInBytes);
+	}
+
+	// the old buffers are released deferred, the build of the last frame can still use them
+	RawBufferInitInfo info{};
+	info.Stride = 1;
+	info.CreateUAV = true;
+	// the refits use the same scratch buffer, an update never needs more than a full build
+	if (topPrebuildInfo.ScratchDataSizeInBytes > _accScratchBuffer.Size())
+	{
+		info.ElementCount = (u32)topPrebuildInfo.ScratchDataSizeInBytes;
+		info.InitialState = D3D12_RESOURCE_STATE_COMMON;
+		info.Name = L"RT Scratch Buffer";
+		_accScratchBuffer.Initialize(info);
+	}
+	if (topPrebuildInfo.ResultDataMaxSizeInBytes > _topLevelAccStructure.Size())
+	{
+		info.ElementCount = (u32)topPrebuildInfo.ResultDataMaxSizeInBytes;
+		info.InitialState = D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
+		info.Name = L"RT Top Level AccStructure Buffer";
+		_topLevelAccStructure.Initialize(info);
+	}
+}
+
 
 void
 CreateHitGroups()
@@ -322,6 +414,7 @@ BuildAccelerationStructure(DXGraphicsCommandList* const cmdList)
 
 	cmdList->BuildRaytracingAccelerationStructure(&topBuildDesc, 0, nullptr);
 	d3dx::ApplyUAVBarrier(_topLevelAccStructure.Buffer(), cmdList);
+	_tlasInstanceCount = instanceCount;
 
 	_shouldBuildAccelerationStructure = false;
 	_lastAccelerationStructureBuildFrame = core::CurrentCPUFrame();
@@ -864,59 +957,37 @@ void RequestRTAccStructureRebuild()
 }
 
 void 
-UpdateAccelerationStructure()
+UpdateAccelerationStructure(std::span<const ecs::Entity> movedEntities, bool rebuildInstances)
 {
 	if(!_topLevelAccStructure.Buffer()) return;
-	core::Release(_instanceBufferResource);
-	const StructuredBuffer& vertexBuffer{ content::geometry::GlobalVertexBuffer() };
-	const FormattedBuffer& indexBuffer{ content::geometry::GlobalIndexBuffer() };
-	DXGraphicsCommandList* const cmdList{ core::GraphicsCommandList() };
-	d3dx::ApplyUAVBarrier(_topLevelAccStructure.Buffer(), cmdList);
-
-	const u32 meshCount{ ecs::scene::GetEntityCount<ecs::component::PathTraceable>() };
-	assert(meshCount);
-	Array<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs{ meshCount };
-	const u32 geometryCount{ (u32)geometryDescs.size() };
-	Array<hlsl::GeometryInfo> geometryInfoBufferData{ geometryCount };
-	Vec<D3D12_RAYTRACING_INSTANCE_DESC> instances{};
-
-	D3D12FrameInfo& frameInfo{ gpass::GetCurrentD3D12FrameInfo() };
-
-	for (auto [entity, m, wt] : ecs::scene::GetRO<ecs::component::PathTraceable, ecs::component::WorldTransform>())
-	{
-		instances.emplace_back();
-		D3D12_RAYTRACING_INSTANCE_DESC& instance{ instances.back() };
-		instance.InstanceID = entity & 0x00FFFFFF;
-		instance.InstanceMask = 1;
-		instance.AccelerationStructure = m.BlasGPUAddress;
-		instance.InstanceContributionToHitGroupIndex = 0;
-		instance.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-
-		xmmat mat{ DirectX::XMLoadFloat4x4(&wt.TRS) };
-		DirectX::XMFLOAT3X4 mat3x4{};
-		DirectX::XMStoreFloat3x4(&mat3x4, mat);
-		memcpy(&instance.Transform, &mat3x4, sizeof(instance.Transform));
-	}
+	if (rebuildInstances || _instances.empty()) GatherInstances();
+	else if (UpdateMovedInstances(movedEntities) == 0) return;
+	assert(!_instances.empty());
+	const u32 instanceCount{ (u32)_instances.size() };
 
 	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags{ 
 		D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE 
-		| D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE
-		| D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE };
+		| D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE };
+	// a refit only works on the instances the TLAS was built with, a new instance set gets a full build into big enough buffers
+	const bool isRefit{ !rebuildInstances && instanceCount == _tlasInstanceCount };
+	if (isRefit) buildFlags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+	else ResizeTopLevelBuffers(instanceCount, buildFlags);
 
-	for (D3D12_RAYTRACING_INSTANCE_DESC& instance : instances)
-		instance.AccelerationStructure = _bottomLevelAccStructure.GpuAddress();
+	core::Release(_instanceBufferResource);
+	DXGraphicsCommandList* const cmdList{ core::GraphicsCommandList() };
+	d3dx::ApplyUAVBarrier(_topLevelAccStructure.Buffer(), cmdList);
 
 	assert(!_instanceBufferResource);
-	_instanceBufferResource = d3dx::CreateResourceBuffer(instances.data(), instances.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+	_instanceBufferResource = d3dx::CreateResourceBuffer(_instances.data(), _instances.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
 
 	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC topBuildDesc{};
 	{
 		topBuildDesc.ScratchAccelerationStructureData = _accScratchBuffer.GpuAddress();
 		topBuildDesc.DestAccelerationStructureData = _topLevelAccStructure.GpuAddress();
-		topBuildDesc.SourceAccelerationStructureData = _topLevelAccStructure.GpuAddress();
+		topBuildDesc.SourceAccelerationStructureData = isRefit ? _topLevelAccStructure.GpuAddress() : 0;
 		topBuildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
 		topBuildDesc.Inputs.Flags = buildFlags;
-		topBuildDesc.Inputs.NumDescs = instances.size();
+		topBuildDesc.Inputs.NumDescs = instanceCount;
 		topBuildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
 		topBuildDesc.Inputs.pGeometryDescs = nullptr;
 		topBuildDesc.Inputs.InstanceDescs = _instanceBufferResource->GetGPUVirtualAddress();
@@ -924,6 +995,7 @@ UpdateAccelerationStructure()
 
 	core::GraphicsCommandList()->BuildRaytracingAccelerationStructure(&topBuildDesc, 0, nullptr);
 	d3dx::ApplyUAVBarrier(_topLevelAccStructure.Buffer(), cmdList);
+	_tlasInstanceCount = instanceCount;
 	_lastAccelerationStructureBuildFrame = core::CurrentCPUFrame();
 
 	editor::debug::UpdateAccelerationStructureData(_accStructVertexCount, _accStructIndexCount, _lastAccelerationStructureBuildFrame);
@@ -1,5 +1,6 @@
 #pragma once
 #include "D3D12CommonHeaders.h"
+#include <span>
 
 namespace mofu::graphics::d3d12::rt {
 bool CompileRTShaders();
@@ -13,7 +14,8 @@ void Render(const D3D12FrameInfo& frameInfo, DXGraphicsCommandList* const cmdLis
 DescriptorHandle MainBufferSRV();
 void RequestRTUpdate();
 void RequestRTAccStructureRebuild();
-void UpdateAccelerationStructure();
+// refits the TLAS, only the instances of movedEntities are rewritten unless rebuildInstances gathers all of them again
+void UpdateAccelerationStructure(std::span<const ecs::Entity> movedEntities, bool rebuildInstances);
 void ResetShaders();
 
 D3D12_GPU_VIRTUAL_ADDRESS TopLevelAccStructureSRV();
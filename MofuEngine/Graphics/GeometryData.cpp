@@ -1,5 +1,6 @@
 #include "GeometryData.h"
 #include "Utilities/IOStream.h"
+#include "Utilities/JobSystem.h"
 #include "External/MikkTSpace/mikktspace.h"
 #include <filesystem>
 #include <fstream>
@@ -726,10 +727,13 @@ ProcessMeshGroupData(MeshGroup& group, const GeometryImportSettings& settings)
 
 	for (auto& lod : group.LodGroups)
 	{
-		for (auto& m : lod.Meshes)
-		{
-			ProcessAndPackVertexData(m, settings);
-		}
+		// meshes are processed independently
+		jobs::ParallelFor((u32)lod.Meshes.size(), 1, [&lod, &settings](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i)
+			{
+				ProcessAndPackVertexData(lod.Meshes[i], settings);
+			}
+			});
 	}
 }
 
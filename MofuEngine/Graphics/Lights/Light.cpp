@@ -2,13 +2,26 @@
 #include "EngineAPI/ECS/SceneAPI.h"
 #include "ECS/Component.h"
 #include "Graphics/RenderingDebug.h"
+#include "ECS/Resources.h"
 
 namespace mofu::graphics::light {
 namespace {
 
-u32 currentLightSetKey{};
+// the light set that gets rendered, a resource of the main world
+struct CurrentLightSet
+{
+	u32 Key{ 0 };
+};
+
 util::FreeList<LightSet> lightSets{};
 
+u32&
+CurrentLightSetKey()
+{
+	CurrentLightSet* const current{ ecs::resources::TryGet<CurrentLightSet>() };
+	return current ? current->Key : ecs::resources::Emplace<CurrentLightSet>().Key;
+}
+
 void 
 CalculateBoundingSphere(Sphere& sphere, const CullableLightParameters& params)
 {
@@ -48,7 +61,7 @@ ProcessUpdates(u32 lightSetIdx)
 void 
 UpdateDirectionalLight(ecs::component::DirectionalLight& l)
 {
-	LightSet& lightSet{ lightSets[currentLightSetKey] };
+	LightSet& lightSet{ lightSets[CurrentLightSetKey()] };
 
 	if (!l.Enabled && l.LightDataIndex < lightSet.FirstDisabledNonCullableIndex)
 	{
@@ -97,7 +110,7 @@ UpdateDirectionalLight(ecs::component::DirectionalLight& l)
 void
 UpdateCullableLightTransform(const ecs::component::CullableLight& l, const ecs::component::WorldTransform& wt)
 {
-	LightSet& lightSet{ lightSets[currentLightSetKey] };
+	LightSet& lightSet{ lightSets[CurrentLightSetKey()] };
 	CullableLightParameters& params{ lightSet.CullableLights[l.LightDataIndex] };
 	params.Position = { wt.TRS._41, wt.TRS._42, wt.TRS._43 };
 	Sphere& sphere{ lightSet.BoundingSpheres[l.LightDataIndex] };
@@ -109,11 +122,11 @@ UpdateCullableLightTransform(const ecs::component::CullableLight& l, const ecs::
 void 
 UpdatePointLight(ecs::component::PointLight& l)
 {
-	LightSet& lightSet{ lightSets[currentLightSetKey] };
+	LightSet& lightSet{ lightSets[CurrentLightSetKey()] };
 
 	CullableLightParameters& params{ lightSet.CullableLights[l.LightDataIndex] };
 	const ecs::component::WorldTransform& wt{
-		ecs::scene::GetComponent<ecs::component::WorldTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
+		ecs::scene::GetComponentRO<ecs::component::WorldTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
 	params.Color = l.Color;
 	params.Intensity = l.Intensity;
 	params.Range = l.Range;
@@ -130,13 +143,13 @@ UpdatePointLight(ecs::component::PointLight& l)
 void 
 UpdateSpotLight(ecs::component::SpotLight& l)
 {
-	LightSet& lightSet{ lightSets[currentLightSetKey] };
+	LightSet& lightSet{ lightSets[CurrentLightSetKey()] };
 
 	CullableLightParameters& params{ lightSet.CullableLights[l.LightDataIndex] };
-	const ecs::component::LocalTransform& lt{
-		ecs::scene::GetComponent<ecs::component::LocalTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
+	const auto lt{
+		ecs::scene::GetComponentRO<ecs::component::LocalTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
 	const ecs::component::WorldTransform& wt{
-		ecs::scene::GetComponent<ecs::component::WorldTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
+		ecs::scene::GetComponentRO<ecs::component::WorldTransform>(lightSet.CullableLightOwners[l.LightDataIndex].Entity) };
 	params.Color = l.Color;
 	params.Intensity = l.Intensity;
 	params.Range = l.Range;
@@ -178,6 +191,23 @@ RemoveLightSet(u32 lightSetIdx)
 	lightSets.remove(lightSetIdx);
 }
 
+void
+ClearLights(u32 lightSetIdx)
+{
+	assert(lightSetIdx < lightSets.size());
+	LightSet& set{ lightSets[lightSetIdx] };
+	set.FirstDisabledNonCullableIndex = 0;
+	set.NonCullableLightOwners.clear();
+	set.NonCullableLights.clear();
+	set.FirstDirtyCullableIndex = 0;
+	set.FirstDisabledCullableIndex = 0;
+	set.CullableLightOwners.clear();
+	set.CullableLights.clear();
+	set.CullingInfos.clear();
+	set.BoundingSpheres.clear();
+	set.DirtyBits.clear();
+}
+
 u32 
 GetDirectionalLightsCount(u32 lightSetIdx)
 {
@@ -223,7 +253,7 @@ AddLightToLightSet(u32 lightSetIdx, ecs::Entity lightEntity, LightType::Type typ
 	{
 		auto& pLight{ ecs::scene::GetComponent<ecs::component::PointLight>(lightEntity) };
 		auto& cLight{ ecs::scene::GetComponent<ecs::component::CullableLight>(lightEntity) };
-		auto& lt{ ecs::scene::GetComponent<ecs::component::LocalTransform>(lightEntity) };
+		const auto lt{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(lightEntity) };
 		//TODO: enabled/disabled 
 		u32 dataIndex{ (u32)set.CullableLights.size() };
 
@@ -254,7 +284,7 @@ AddLightToLightSet(u32 lightSetIdx, ecs::Entity lightEntity, LightType::Type typ
 	{
 		auto& sLight{ ecs::scene::GetComponent<ecs::component::SpotLight>(lightEntity) };
 		auto& cLight{ ecs::scene::GetComponent<ecs::component::CullableLight>(lightEntity) };
-		auto& lt{ ecs::scene::GetComponent<ecs::component::LocalTransform>(lightEntity) };
+		const auto lt{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(lightEntity) };
 		//TODO: enabled/disabled 
 		u32 dataIndex{ (u32)set.CullableLights.size() };
 
@@ -306,12 +336,12 @@ GetLightSet(u32 lightSetIdx)
 	return lightSets[lightSetIdx];
 }
 
-u32 GetCurrentLightSetKey() { return currentLightSetKey; }
-u32* const GetCurrentLightSetKeyRef() { return &currentLightSetKey; }
+u32 GetCurrentLightSetKey() { return CurrentLightSetKey(); }
+u32* const GetCurrentLightSetKeyRef() { return &CurrentLightSetKey(); }
 
 f32* const GetAmbientIntensityRef() 
 { 	
-	LightSet& set{ lightSets[currentLightSetKey] };
+	LightSet& set{ lightSets[CurrentLightSetKey()] };
 	return &set.AmbientLight.Intensity;
 }
 
@@ -79,6 +79,8 @@ f32* const GetAmbientIntensityRef();
 u32 CreateLightSet();
 void RemoveLightSet(u32 lightSetIdx);
 void AddLightToLightSet(u32 lightSetIdx, ecs::Entity lightEntity, LightType::Type type);
+// removes every light of the set, the ambient light and the environment maps stay
+void ClearLights(u32 lightSetIdx);
 
 void AddAmbientLight(u32 lightSetIdx, AmbientLightInitInfo ambientInfo);
 AmbientLightParameters GetAmbientLight(u32 lightSetIdx);
@@ -3,6 +3,8 @@
 #include "D3D12/D3D12Interface.h"
 #include "EngineAPI/Camera.h"
 #include "Content/EngineShaders.h"
+#include "ECS/SystemMessages.h"
+#include "ECS/Resources.h"
 
 namespace mofu::graphics {
 namespace {
@@ -35,7 +37,6 @@ constexpr const char* SHADER_FILE_EXTENSIONS[(u32)GraphicsPlatform::Count]{
 };
 
 PlatformInterface gfxInterface;
-FrameInfo frameInfo{};
 Vec<ecs::Entity> visibleEntities{};
 GraphicsPlatform _platform;
 
@@ -56,20 +57,22 @@ bool SetupPlatformInterface(GraphicsPlatform platform)
 
 } // anonymous namespace
 
+// the frame info and main camera are resources of the main world
 void SetCurrentFrameInfo(FrameInfo info)
 {
-    frameInfo = info;
+    ecs::resources::Get<FrameInfo>() = info;
 }
 
 const FrameInfo& GetCurrentFrameInfo()
 {
-    return frameInfo;
+    return ecs::resources::Get<FrameInfo>();
 }
 
 bool
 Initialize(GraphicsPlatform platform)
 {
     _platform = platform;
+    ecs::resources::Emplace<FrameInfo>();
     return SetupPlatformInterface(platform) && gfxInterface.initialize() && ui::Initialize(&gfxInterface);
 }
 
@@ -91,12 +94,10 @@ RemoveSurface(surface_id id)
     gfxInterface.surface.remove(id);
 }
 
-Camera cam{};
 Camera
 CreateCamera(CameraInitInfo info)
 {
-    cam = gfxInterface.camera.create(info);
-    return cam;
+    return ecs::resources::Emplace<Camera>(gfxInterface.camera.create(info));
 }
 
 void
@@ -108,7 +109,7 @@ RemoveCamera(camera_id id)
 const
 Camera& GetMainCamera()
 {
-    return cam;
+    return ecs::resources::Get<Camera>();
 }
 
 Vec<ecs::Entity>&
@@ -398,7 +399,9 @@ MaterialInitInfo GetMaterialReflection(id_t id)
 id_t 
 AddRenderItem(ecs::Entity entityID, id_t geometryContentID, u32 materialCount, const id_t materialID)
 {
-	return gfxInterface.resources.addRenderItem(entityID, geometryContentID, materialCount, materialID);
+	const id_t renderItemID{ gfxInterface.resources.addRenderItem(entityID, geometryContentID, materialCount, materialID) };
+	ecs::messages::RenderItemAddedEvents().Push(renderItemID);
+	return renderItemID;
 }
 
 void
@@ -410,6 +413,7 @@ UpdateRenderItemData(id_t oldRenderItemID, id_t newRenderItemID)
 void RemoveRenderItem(id_t id)
 {
 	gfxInterface.resources.removeRenderItem(id);
+	ecs::messages::RenderItemRemovedEvents().Push(id);
 }
 
 }
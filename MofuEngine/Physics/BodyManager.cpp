@@ -30,49 +30,53 @@ struct DeferredBody
 Vec<DeferredBody> _deferredDynamicBodies{};
 Vec<DeferredBody> _deferredStaticBodies{};
 
-void 
-SpawnDeferredBodies()
+JPH::BodyCreationSettings
+GetBodySettings(const JPH::Shape* shape, ecs::Entity e, bool isStatic)
 {
-    for (const DeferredBody& b : _deferredDynamicBodies)
+    const auto lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(e) };
+    JPH::BodyCreationSettings bodySettings{ shape, lt.Position.Vec3(), lt.Rotation,
+        isStatic ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic, isStatic ? PhysicsLayers::Layer::Static : PhysicsLayers::Layer::Movable };
+    if (isStatic)
     {
-        const ecs::Entity e{ b.Entity };
-        const ecs::component::LocalTransform& lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(e) };
-        JPH::BodyCreationSettings bodySettings{ b.Shape.GetPtr(), lt.Position.Vec3(), lt.Rotation,
-            JPH::EMotionType::Dynamic, PhysicsLayers::Layer::Movable };
-
-        bodySettings.mUserData = e;
-
-        JPH::Body* body{ core::BodyInterface().CreateBody(bodySettings) };
-        const JPH::BodyID bodyID{ body->GetID() };
-        core::BodyInterface().AddBody(bodyID, JPH::EActivation::Activate);
-        log::Info("JOLT: Added a new physics body: [%u]", body->GetID().GetIndex());
-        ecs::component::Collider& collider{ ecs::scene::GetEntityComponent<ecs::component::Collider>(e) };
-        collider.BodyID = bodyID;
-
-
-        JPH::BodyLockWrite lock{ physics::core::PhysicsSystem().GetBodyLockInterface(), bodyID };
-        lock.GetBody().GetMotionProperties()->SetGravityFactor(0.1f);
-    }
-
-    for (const DeferredBody& b : _deferredStaticBodies)
-    {
-        const ecs::Entity e{ b.Entity };
-        const ecs::component::LocalTransform& lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(e) };
-        JPH::BodyCreationSettings bodySettings{ b.Shape.GetPtr(), lt.Position.Vec3(), lt.Rotation,
-            JPH::EMotionType::Static, PhysicsLayers::Layer::Static };
         bodySettings.mAllowDynamicOrKinematic = core::settings::CREATE_STATIC_BODIES_AS_CHANGEABLE_TO_MOVABLE;
         bodySettings.mOverrideMassProperties = JPH::EOverrideMassProperties::MassAndInertiaProvided;
         bodySettings.mMassPropertiesOverride = JPH::MassProperties{ core::settings::DEFAULT_BODY_MASS };
+    }
+    else
+    {
+        bodySettings.mGravityFactor = 0.1f;
+    }
+
+    bodySettings.mUserData = e;
+    return bodySettings;
+}
 
-        bodySettings.mUserData = e;
+void
+CreateDeferredBody(const DeferredBody& b, bool isStatic)
+{
+    JPH::Body* body{ core::BodyInterface().CreateBody(GetBodySettings(b.Shape.GetPtr(), b.Entity, isStatic)) };
+    const JPH::BodyID bodyID{ body->GetID() };
+    core::BodyInterface().AddBody(bodyID, isStatic ? JPH::EActivation::DontActivate : JPH::EActivation::Activate);
+    log::Info("JOLT: Added a new physics body: [%u]", body->GetID().GetIndex());
+    ecs::component::Collider& collider{ ecs::scene::GetEntityComponent<ecs::component::Collider>(b.Entity) };
+    collider.BodyID = bodyID;
+}
 
-        JPH::Body* body{ core::BodyInterface().CreateBody(bodySettings) };
-        const JPH::BodyID bodyID{ body->GetID() };
-        core::BodyInterface().AddBody(bodyID, JPH::EActivation::DontActivate);
-        log::Info("JOLT: Added a new physics body: [%u]", body->GetID().GetIndex());
-        ecs::component::Collider& collider{ ecs::scene::GetEntityComponent<ecs::component::Collider>(e) };
-        collider.BodyID = bodyID;
-    }
+// the bodies must already be created, they're inserted into the broadphase together
+void
+AddBodiesBatched(Vec<JPH::BodyID>& bodies, JPH::EActivation activation)
+{
+    if (bodies.empty()) return;
+    JPH::BodyInterface& bodyInterface{ core::BodyInterface() };
+    const JPH::BodyInterface::AddState state{ bodyInterface.AddBodiesPrepare(bodies.data(), (int)bodies.size()) };
+    bodyInterface.AddBodiesFinalize(bodies.data(), (int)bodies.size(), state, activation);
+}
+
+void 
+SpawnDeferredBodies()
+{
+    for (const DeferredBody& b : _deferredDynamicBodies) CreateDeferredBody(b, false);
+    for (const DeferredBody& b : _deferredStaticBodies) CreateDeferredBody(b, true);
 
     _deferredDynamicBodies.clear();
     _deferredStaticBodies.clear();
@@ -84,6 +88,12 @@ void
 AddStaticBody(JPH::Ref<JPH::Shape> shape, ecs::Entity ownerEntity)
 {
     ecs::scene::AddComponents<ecs::component::Collider, ecs::component::StaticObject>(ownerEntity);
+    // a staging world has no bodies, MergeWorld creates them
+    if (!ecs::scene::IsMainWorld())
+    {
+        ecs::scene::StagePhysicsBody(SavedBody{ ownerEntity, shape, true });
+        return;
+    }
 
     _deferredStaticBodies.emplace_back(DeferredBody{ ownerEntity, shape });
 }
@@ -92,6 +102,11 @@ void
 AddDynamicBody(JPH::Ref<JPH::Shape> shape, ecs::Entity ownerEntity)
 {
     ecs::scene::AddComponents<ecs::component::Collider, ecs::component::DynamicObject>(ownerEntity);
+    if (!ecs::scene::IsMainWorld())
+    {
+        ecs::scene::StagePhysicsBody(SavedBody{ ownerEntity, shape, false });
+        return;
+    }
 
     //_deferredPhysicsSpawns[_deferredSpawnsCount++] = ownerEntity;
     _deferredDynamicBodies.emplace_back(DeferredBody{ ownerEntity, shape });
@@ -132,6 +147,58 @@ UpdateBodyManagerDeferred()
     SpawnDeferredBodies();
 }
 
+void
+SavePhysicsBodies(Vec<SavedBody>& outBodies)
+{
+    // a Collider only gets its body id once the body is created
+    SpawnDeferredBodies();
+    for (ecs::EntityBlock* block : ecs::scene::GetBlocksFromCet(ecs::scene::GetCetMask<ecs::component::Collider>()))
+    {
+        const bool isStatic{ block->Signature.test(ecs::component::ID<ecs::component::StaticObject>) };
+        const ecs::component::Collider* const colliders{ block->GetComponentArray<ecs::component::Collider>() };
+        for (u32 row{ 0 }; row < block->EntityCount; ++row)
+        {
+            outBodies.emplace_back(SavedBody{ block->Entities[row], core::BodyInterface().GetShape(colliders[row].BodyID), isStatic });
+        }
+    }
+}
+
+void
+DestroyAllPhysicsBodies()
+{
+    SpawnDeferredBodies();
+    Vec<JPH::BodyID> bodies{};
+    for (ecs::EntityBlock* block : ecs::scene::GetBlocksFromCet(ecs::scene::GetCetMask<ecs::component::Collider>()))
+    {
+        ecs::component::Collider* const colliders{ block->GetComponentArray<ecs::component::Collider>() };
+        for (u32 row{ 0 }; row < block->EntityCount; ++row)
+        {
+            bodies.emplace_back(colliders[row].BodyID);
+            colliders[row].BodyID = JPH::BodyID{};
+        }
+    }
+    if (bodies.empty()) return;
+    core::BodyInterface().RemoveBodies(bodies.data(), (int)bodies.size());
+    core::BodyInterface().DestroyBodies(bodies.data(), (int)bodies.size());
+}
+
+void
+CreatePhysicsBodies(const Vec<SavedBody>& bodies)
+{
+    Vec<JPH::BodyID> staticBodies{};
+    Vec<JPH::BodyID> dynamicBodies{};
+    for (const SavedBody& b : bodies)
+    {
+        JPH::Body* body{ core::BodyInterface().CreateBody(GetBodySettings(b.Shape.GetPtr(), b.Entity, b.IsStatic)) };
+        assert(body);
+        ecs::scene::GetEntityComponent<ecs::component::Collider>(b.Entity).BodyID = body->GetID();
+        (b.IsStatic ? staticBodies : dynamicBodies).emplace_back(body->GetID());
+    }
+    AddBodiesBatched(staticBodies, JPH::EActivation::DontActivate);
+    AddBodiesBatched(dynamicBodies, JPH::EActivation::Activate);
+    log::Info("JOLT: Added %u physics bodies", (u32)bodies.size());
+}
+
 void 
 ChangePhysicsShape(ecs::Entity ownerEntity, shapes::PrimitiveShapes::Type shapeType)
 {
@@ -141,7 +208,7 @@ ChangePhysicsShape(ecs::Entity ownerEntity, shapes::PrimitiveShapes::Type shapeT
     
     //JPH::Body& body{ lock.GetBody() };
 
-    const ecs::component::LocalTransform& lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(ownerEntity) };
+    const auto lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(ownerEntity) };
     JPH::Ref<JPH::Shape> newShape{ nullptr };
 
     switch (shapeType)
@@ -13,5 +13,19 @@ void DestroyPhysicsBodies(const Array<ecs::Entity>& entities);
 void DeactivatePhysicsBody(ecs::Entity entity);
 void UpdateBodyManagerDeferred();
 
+// what's needed to create an entity's body again, the body is placed at the entity's LocalTransform
+struct SavedBody
+{
+	ecs::Entity Entity;
+	JPH::RefConst<JPH::Shape> Shape;
+	bool IsStatic;
+};
+// the bodies of every Collider entity in the current world, disabled ones included; deferred bodies are created first
+void SavePhysicsBodies(Vec<SavedBody>& outBodies);
+// removes the bodies of every Collider entity in the current world at once
+void DestroyAllPhysicsBodies();
+// creates the bodies right away and adds them to the broadphase in one batch per motion type, the entities already have their Collider
+void CreatePhysicsBodies(const Vec<SavedBody>& bodies);
+
 void ChangePhysicsShape(ecs::Entity ownerEntity, shapes::PrimitiveShapes::Type shapeType);
 }
\ No newline at end of file
@@ -467,7 +467,7 @@ void
 DebugRenderer::DrawTriangles(const D3D12FrameInfo& frameInfo, D3D12_GPU_VIRTUAL_ADDRESS constants)
 {
 	DXGraphicsCommandList* const cmdList{ core::GraphicsCommandList() };
-	const ecs::component::LocalTransform& camLT{ ecs::scene::GetComponent<ecs::component::LocalTransform>(ecs::scene::GetSingletonEntity(ecs::component::ID<ecs::component::Camera>)) };
+	const auto camLT{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(ecs::scene::GetSingletonEntity(ecs::component::ID<ecs::component::Camera>)) };
 	JPH::Vec3 camPos{ camLT.Position.Vec3() };
 
 	if (_instanceCount > 0)
@@ -561,7 +561,7 @@ DebugRenderer::DrawTextBuffer(const D3D12FrameInfo& frameInfo, D3D12_GPU_VIRTUAL
 	cmdList->SetGraphicsRootDescriptorTable(font::FontRenderer::FontRootParameterIndices::FontTexture, 
 		content::texture::GetDescriptorHandle(_font.TextureID).gpu);
 
-	const ecs::component::LocalTransform& camLT{ ecs::scene::GetComponent<ecs::component::LocalTransform>(ecs::scene::GetSingletonEntity(ecs::component::ID<ecs::component::Camera>)) };
+	const auto camLT{ ecs::scene::GetComponentRO<ecs::component::LocalTransform>(ecs::scene::GetSingletonEntity(ecs::component::ID<ecs::component::Camera>)) };
 	JPH::Vec3 camPos{ camLT.Position.Vec3() };
 
 	for (const Text& text : _textArray)
@@ -630,7 +630,7 @@ Render(const D3D12FrameInfo& frameInfo)
 {
 	if (graphics::debug::RenderingSettings.RenderAllPhysicsShapes)
 	{
-		for (auto [entity, lt, wt, col] : ecs::scene::GetRW<ecs::component::LocalTransform,
+		for (auto [entity, lt, wt, col] : ecs::scene::GetRO<ecs::component::LocalTransform,
 			ecs::component::WorldTransform, ecs::component::Collider>())
 		{
 			JPH::BodyLockRead lock{ physics::core::PhysicsSystem().GetBodyLockInterface(), col.BodyID };
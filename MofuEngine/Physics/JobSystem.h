@@ -1,10 +1,46 @@
 #pragma once
 #include "CommonHeaders.h"
+#include "Utilities/JobSystem.h"
 #include <Jolt/Jolt.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
 
 namespace mofu::physics::jobs {
-//NOTE: for now just use jolt's implementation
-using JobSystem = JPH::JobSystemThreadPool;
+// runs jolt's jobs on the engine job system instead of a separate thread pool
+class JobSystem final : public JPH::JobSystemWithBarrier
+{
+public:
+	explicit JobSystem(u32 maxBarriers) : JPH::JobSystemWithBarrier{ maxBarriers } {}
+
+	int GetMaxConcurrency() const override { return (int)mofu::jobs::GetThreadCount(); }
+
+	JobHandle CreateJob(const char* name, JPH::ColorArg color, const JobFunction& jobFunction, JPH::uint32 dependencyCount = 0) override
+	{
+		Job* job{ new Job{ name, color, this, jobFunction, dependencyCount } };
+		// the handle keeps a reference, the job might finish before this returns
+		JobHandle handle{ job };
+		if (dependencyCount == 0) QueueJob(job);
+		return handle;
+	}
+
+protected:
+	void QueueJob(Job* job) override
+	{
+		job->AddRef();
+		mofu::jobs::Run([job] {
+			job->Execute();
+			job->Release();
+			});
+	}
+
+	void QueueJobs(Job** jobs, JPH::uint jobCount) override
+	{
+		for (JPH::uint i{ 0 }; i < jobCount; ++i) QueueJob(jobs[i]);
+	}
+
+	void FreeJob(Job* job) override
+	{
+		delete job;
+	}
+};
 
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "EngineAPI/ECS/SceneAPI.h"
 #include "ECS/QueryView.h"
 #include "ECS/Transform.h"
+#include "ECS/TransformHierarchy.h"
 #include "Utilities/Logger.h"
 #include "BodyManager.h"
 
@@ -85,9 +86,7 @@ Initialize()
 
 	_tempAllocator = new JPH::TempAllocatorImpl{ TEMP_ALLOCATOR_SIZE };
 
-	const i32 jobSystemThreadCount{ (i32)(std::thread::hardware_concurrency() - 1u) };
-	//const i32 jobSystemThreadCount{ 1 };
-	_jobSystem = new jobs::JobSystem{ JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, jobSystemThreadCount };
+	_jobSystem = new jobs::JobSystem{ JPH::cMaxPhysicsBarriers };
 
 	_physicsSystem.Init(MAX_RIGID_BODIES, NUM_BODY_MUTEXES, MAX_BODY_PAIRS, MAX_CONTACT_CONSTRAINTS,
 		_broadPhaseLayerInterface, _objectVsBroadphaseLayerFilter, _objectVsObjectLayerFilter);
@@ -117,8 +116,14 @@ Update(f32 deltaTime)
 	_physicsSystem.Update(deltaTime, COLLISION_STEPS, _tempAllocator, _jobSystem);
 	JPH::BodyInterface& bodyInterface{ _physicsSystem.GetBodyInterface() };
 
-	for (auto [entity, d, lt, wt, collider] : ecs::scene::GetRW<ecs::component::DynamicObject, ecs::component::LocalTransform, ecs::component::WorldTransform, ecs::component::Collider>())
+	// the write-back is independent per body, so the blocks are processed in parallel
+	// DynamicObject is sparse, so the blocks mix dynamic and static entities; only the awake bodies are written back
+	// and marked one by one, the rest of their blocks isn't recomputed by the hierarchy
+	ecs::scene::GetRO<ecs::With<ecs::component::DynamicObject>, ecs::With<ecs::component::LocalTransform>, ecs::component::Collider>()
+		.ParallelForEach([&bodyInterface](ecs::Entity entity, const ecs::component::Collider& collider)
 	{
+		if (!bodyInterface.IsActive(collider.BodyID)) return;
+		const auto lt{ ecs::scene::GetEntityComponent<ecs::component::LocalTransform>(entity) };
 		JPH::Vec3 pos;
 		JPH::Quat rot;
 		bodyInterface.GetPositionAndRotation(collider.BodyID, pos, rot);
@@ -130,6 +135,7 @@ Update(f32 deltaTime)
 		v3 forward{};
 		DirectX::XMStoreFloat3(&forward, forwardV);
 		lt.Forward = forward;
+		ecs::transform::MarkLocalTransformChanged(entity);
 		//xmm posV{ DirectX::XMLoadFloat3((v3*)&pos)};
 		//xmm rotV{ DirectX::XMLoadFloat4((v4*)&rot)};
 		//v3 scale{ 1.f, 1.f, 1.f };
@@ -140,7 +146,7 @@ Update(f32 deltaTime)
 		//xmmat newTransform{ currentTransform * mat };
 		//DirectX::XMStoreFloat4x4(&wt.TRS, newTransform);
 		//log::Info("PHYSICS: Updated object transform");
-	}
+	});
 }
 
 void
@@ -0,0 +1,181 @@
+#include "JobSystem.h"
+#include <thread>
+#include <deque>
+#include <condition_variable>
+
+namespace mofu::jobs {
+namespace {
+
+struct Job
+{
+	JobFunc Func;
+	JobCounter* Counter;
+};
+
+struct JobQueue
+{
+	std::mutex Mutex;
+	std::deque<Job> Jobs;
+};
+
+u32 _threadCount{ 1 };
+std::unique_ptr<JobQueue[]> _queues{};
+std::vector<std::thread> _workers{};
+
+std::atomic<u32> _pendingJobCount{ 0 };
+std::atomic<bool> _isRunning{ false };
+std::mutex _sleepMutex{};
+std::condition_variable _wakeCondition{};
+
+thread_local u32 _threadIndex{ 0 };
+
+bool
+PopJob(u32 queueIndex, Job& outJob)
+{
+	JobQueue& queue{ _queues[queueIndex] };
+	std::lock_guard lock{ queue.Mutex };
+	if (queue.Jobs.empty()) return false;
+	outJob = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	return true;
+}
+
+bool
+StealJob(u32 thiefIndex, Job& outJob)
+{
+	for (u32 i{ 1 }; i < _threadCount; ++i)
+	{
+		JobQueue& queue{ _queues[(thiefIndex + i) % _threadCount] };
+		std::lock_guard lock{ queue.Mutex };
+		if (queue.Jobs.empty()) continue;
+		outJob = std::move(queue.Jobs.front());
+		queue.Jobs.pop_front();
+		return true;
+	}
+	return false;
+}
+
+void
+Execute(Job& job)
+{
+	job.Func();
+	if (job.Counter) job.Counter->Value.fetch_sub(1, std::memory_order_release);
+}
+
+bool
+TryRunJob()
+{
+	Job job{};
+	const u32 threadIndex{ _threadIndex };
+	if (!PopJob(threadIndex, job) && !StealJob(threadIndex, job)) return false;
+
+	_pendingJobCount.fetch_sub(1, std::memory_order_relaxed);
+	Execute(job);
+	return true;
+}
+
+void
+WorkerLoop(u32 threadIndex)
+{
+	_threadIndex = threadIndex;
+	while (_isRunning.load(std::memory_order_acquire))
+	{
+		if (TryRunJob()) continue;
+
+		std::unique_lock lock{ _sleepMutex };
+		_wakeCondition.wait(lock, [] { return !_isRunning.load(std::memory_order_acquire) || _pendingJobCount.load(std::memory_order_acquire) > 0; });
+	}
+}
+
+} // anonymous namespace
+
+void
+Initialize(u32 workerCount)
+{
+	assert(!_isRunning);
+	if (workerCount == DEFAULT_WORKER_COUNT)
+	{
+		const u32 hardwareThreads{ std::thread::hardware_concurrency() };
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	_threadCount = workerCount + 1;
+	_queues = std::make_unique<JobQueue[]>(_threadCount);
+	_isRunning = true;
+
+	_workers.reserve(workerCount);
+	for (u32 i{ 1 }; i < _threadCount; ++i)
+	{
+		_workers.emplace_back(WorkerLoop, i);
+	}
+}
+
+void
+Shutdown()
+{
+	if (!_isRunning) return;
+
+	// finish whatever is still queued before stopping the workers
+	while (TryRunJob()) {}
+
+	{
+		std::lock_guard lock{ _sleepMutex };
+		_isRunning = false;
+	}
+	_wakeCondition.notify_all();
+	for (std::thread& worker : _workers) worker.join();
+
+	_workers.clear();
+	_queues.reset();
+	_threadCount = 1;
+}
+
+u32
+GetThreadCount()
+{
+	return _threadCount;
+}
+
+u32
+GetThreadIndex()
+{
+	return _threadIndex;
+}
+
+void
+Run(JobFunc job, JobCounter* counter)
+{
+	if (counter) counter->Value.fetch_add(1, std::memory_order_relaxed);
+
+	if (!_queues)
+	{
+		// not initialized, run inline
+		Job inlineJob{ std::move(job), counter };
+		Execute(inlineJob);
+		return;
+	}
+
+	{
+		JobQueue& queue{ _queues[_threadIndex] };
+		std::lock_guard lock{ queue.Mutex };
+		queue.Jobs.emplace_back(std::move(job), counter);
+	}
+	_pendingJobCount.fetch_add(1, std::memory_order_release);
+
+	// taking the lock makes sure a worker can't miss the wake up between checking for jobs and going to sleep
+	{
+		std::lock_guard lock{ _sleepMutex };
+	}
+	_wakeCondition.notify_one();
+}
+
+void
+Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!_queues || !TryRunJob()) std::this_thread::yield();
+	}
+}
+
+}
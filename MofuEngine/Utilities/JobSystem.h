@@ -0,0 +1,64 @@
+#pragma once
+#include "CommonHeaders.h"
+#include <atomic>
+#include <functional>
+
+/*
+* engine-wide job system
+* every thread owns a deque of jobs, the owner pushes and pops from the back and idle threads steal from the front
+* thread 0 is the main thread, it has a deque too but only runs jobs while waiting on a counter
+*/
+
+namespace mofu::jobs {
+
+using JobFunc = std::function<void()>;
+
+// counts the unfinished jobs that were started with it
+struct JobCounter
+{
+	std::atomic<u32> Value{ 0 };
+
+	[[nodiscard]] bool IsDone() const { return Value.load(std::memory_order_acquire) == 0; }
+};
+
+// one worker per hardware thread besides the main one
+constexpr u32 DEFAULT_WORKER_COUNT{ U32_INVALID_ID };
+
+// with 0 workers the jobs run on the main thread while it waits for them
+void Initialize(u32 workerCount = DEFAULT_WORKER_COUNT);
+void Shutdown();
+
+// workers + the main thread
+[[nodiscard]] u32 GetThreadCount();
+// index of the calling thread, 0 for the main thread and threads that aren't part of the job system
+[[nodiscard]] u32 GetThreadIndex();
+
+void Run(JobFunc job, JobCounter* counter = nullptr);
+// runs other jobs until the counter reaches 0, so waiting from inside a job can't deadlock
+void Wait(JobCounter& counter);
+
+// splits [0, count) into batches of batchSize and calls func(begin, end) for each, returns once all of them are done
+// the first batch runs on the calling thread
+template<typename Fun>
+void ParallelFor(u32 count, u32 batchSize, Fun&& func)
+{
+	if (count == 0) return;
+	if (batchSize == 0) batchSize = 1;
+	if (count <= batchSize || GetThreadCount() == 1)
+	{
+		// still in batches, func can rely on end - begin <= batchSize
+		for (u32 begin{ 0 }; begin < count; begin += batchSize) func(begin, std::min(begin + batchSize, count));
+		return;
+	}
+
+	JobCounter counter{};
+	for (u32 begin{ batchSize }; begin < count; begin += batchSize)
+	{
+		const u32 end{ std::min(begin + batchSize, count) };
+		Run([&func, begin, end] { func(begin, end); }, &counter);
+	}
+	func(0u, batchSize);
+	Wait(counter);
+}
+
+}
@@ -1,4 +1,5 @@
 #include "Logger.h"
+#include <mutex>
 
 namespace mofu::log {
 namespace {
@@ -8,6 +9,7 @@ ImGuiTextFilter Filter{};
 ImVector<int> LineOffsets{};
 ImVector<LogSeverityLevel> LogLevels{};
 bool AutoScroll{ true };
+std::mutex LogMutex{}; // logs can come from job system workers
 
 constexpr ImVec4 LOG_LEVEL_COLORS[LogSeverityLevel::Count]{
     {1.f, 1.f, 1.f, 1.f},
@@ -19,6 +21,7 @@ constexpr const char* LOG_LEVEL_TAGS[LogSeverityLevel::Count]{ "[inf]: ", "[war]
 void 
 AddLog(LogSeverityLevel level, const char* fmt, va_list args) IM_FMTARGS(2)
 {
+    std::lock_guard lock{ LogMutex };
     int old_size = LogBuffer.size();
 
     LogBuffer.appendf(LOG_LEVEL_TAGS[level]);
@@ -149,9 +149,12 @@ constexpr v3 v3forward{ 0.f, 0.f, -1.f };
 
 constexpr quat quatIndentity{ 0.f, 0.f, 0.f, 1.f };
 
+// a box in its entity's local space, the world transform orients it
+// NOTE: defaults to a unit cube, a box without size would cull a mesh as soon as its center leaves the view
 struct OBB
 {
-
+	v3 Center{ 0.f, 0.f, 0.f };
+	v3 Extents{ 0.5f, 0.5f, 0.5f }; // half sizes
 };
 
 }
\ No newline at end of file
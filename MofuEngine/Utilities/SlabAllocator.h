@@ -25,6 +25,18 @@ public:
 		_freeSlabs.push_back(slab);
 	}
 
+	// gives the cached free slabs back to the system, keeping at most keepCount of them
+	void ReleaseFreeSlabs(u32 keepCount)
+	{
+		while (_freeSlabs.size() > keepCount)
+		{
+			_aligned_free(_freeSlabs.back());
+			_freeSlabs.pop_back();
+		}
+	}
+
+	[[nodiscard]] u32 FreeSlabCount() const { return (u32)_freeSlabs.size(); }
+
 	~SlabAllocator()
 	{
 		for(void* slab : _slabs)